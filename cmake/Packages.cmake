@@ -516,6 +516,16 @@ rocprofiler_systems_checkout_git_submodule(
 
 include(Perfetto)
 
+# zlib is used for the optional deflate compression of the perfetto trace
+find_package(ZLIB ${rocprofiler_systems_FIND_QUIETLY})
+
+if(ZLIB_FOUND)
+    rocprofiler_systems_target_compile_definitions(rocprofiler-systems-perfetto
+                                                   INTERFACE ROCPROFSYS_USE_ZLIB)
+    target_link_libraries(rocprofiler-systems-perfetto
+                          INTERFACE $<BUILD_INTERFACE:ZLIB::ZLIB>)
+endif()
+
 # ----------------------------------------------------------------------------------------#
 #
 # ELFIO
@@ -0,0 +1,71 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Rank 0 sends two messages to rank 1 and delays the second one. Rank 1 receives the
+// first message with a wildcard MPI_Irecv and the second with a blocking MPI_Recv, so
+// the blocking receive waits for a late sender for roughly the delay.
+
+#include <mpi.h>
+#include <stdio.h>
+#include <unistd.h>
+
+int
+main(int argc, char** argv)
+{
+    const useconds_t SEND_DELAY = 250000;
+
+    MPI_Init(&argc, &argv);
+
+    int world_rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
+    int world_size;
+    MPI_Comm_size(MPI_COMM_WORLD, &world_size);
+
+    if(world_size != 2)
+    {
+        fprintf(stderr, "World size must be two for %s, not %i\n", argv[0], world_size);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    int value = 0;
+    if(world_rank == 0)
+    {
+        MPI_Send(&value, 1, MPI_INT, 1, 0, MPI_COMM_WORLD);
+        usleep(SEND_DELAY);
+        MPI_Send(&value, 1, MPI_INT, 1, 0, MPI_COMM_WORLD);
+    }
+    else
+    {
+        MPI_Request request;
+        MPI_Status  status;
+        MPI_Irecv(&value, 1, MPI_INT, MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD,
+                  &request);
+        MPI_Wait(&request, &status);
+        printf("%d received the first message from %d\n", world_rank,
+               status.MPI_SOURCE);
+        MPI_Recv(&value, 1, MPI_INT, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        printf("%d received the delayed message\n", world_rank);
+    }
+
+    MPI_Finalize();
+    return 0;
+}
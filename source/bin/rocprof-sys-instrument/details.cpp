@@ -212,10 +212,13 @@ get_parameter_types(procedure_t* func)
 //  We create a new name that embeds the file and line information in the name
 //
 function_signature
-get_func_file_line_info(module_t* module, procedure_t* func)
+get_func_file_line_info(module_t* module, procedure_t* func, std::mutex* _mutex)
 {
     using address_t = Dyninst::Address;
 
+    auto _lk = (_mutex) ? std::unique_lock<std::mutex>{ *_mutex }
+                        : std::unique_lock<std::mutex>{};
+
     ROCPROFSYS_ADD_LOG_ENTRY("Getting function line info for", get_name(func));
 
     auto _file_name   = get_name(module);
@@ -226,8 +229,15 @@ get_func_file_line_info(module_t* module, procedure_t* func)
     auto _last_addr   = address_t{};
     auto _src_lines   = std::vector<statement_t>{};
 
-    if(func->getAddressRange(_base_addr, _last_addr) &&
-       module->getSourceLines(_base_addr, _src_lines) && !_src_lines.empty())
+    auto _has_line = func->getAddressRange(_base_addr, _last_addr) &&
+                     module->getSourceLines(_base_addr, _src_lines) &&
+                     !_src_lines.empty();
+
+    // the cached names remain valid and the signature (which demangles the name) does
+    // not need dyninst
+    if(_lk.owns_lock()) _lk.unlock();
+
+    if(_has_line)
     {
         auto _row = _src_lines.front().lineNumber();
         return function_signature(_return_type, _func_name, _file_name, _param_types,
@@ -66,6 +66,7 @@
 #include <istream>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <numeric>
 #include <ostream>
 #include <regex>
@@ -122,6 +123,10 @@ using object_t               = BPatch_object;
 using local_var_t            = BPatch_localVar;
 using sequence_t             = BPatch_sequence;
 using const_expr_t           = BPatch_constExpr;
+using arith_expr_t           = BPatch_arithExpr;
+using variable_expr_t        = BPatch_variableExpr;
+using bool_expr_t            = BPatch_boolExpr;
+using if_expr_t              = BPatch_ifExpr;
 using error_level_t          = BPatchErrorLevel;
 using snippet_handle_t       = BPatchSnippetHandle;
 using patch_pointer_t        = std::shared_ptr<patch_t>;
@@ -171,6 +176,13 @@ enum CodeCoverageMode
     CODECOV_BASIC_BLOCK
 };
 
+enum LoopMode
+{
+    LOOP_TRACE = 0,
+    LOOP_ENTRIES,
+    LOOP_ITERATIONS
+};
+
 //======================================================================================//
 //
 //                                  Global Variables
@@ -191,6 +203,7 @@ extern bool   loop_level_instr;
 extern bool   instr_dynamic_callsites;
 extern bool   instr_traps;
 extern bool   instr_loop_traps;
+extern bool   enable_guard;
 extern bool   parse_all_modules;
 extern size_t min_address_range;
 extern size_t min_loop_address_range;
@@ -207,9 +220,17 @@ extern int  num_log_entries;
 //
 //  instrumentation settings
 //
-extern bool simulate;
-extern bool include_uninstr;
-extern bool include_internal_linked_libs;
+extern bool   simulate;
+extern bool   include_uninstr;
+extern bool   include_internal_linked_libs;
+extern size_t num_jobs;
+//
+//  profile feedback settings
+//
+extern string_t profile_feedback_file;
+extern double   profile_feedback_budget;
+extern double   profile_feedback_overhead;
+extern double   profile_feedback_hot;
 //
 //  string settings
 //
@@ -222,7 +243,9 @@ extern string_t prefer_library;
 //  global variables
 //
 extern patch_pointer_t  bpatch;
+extern std::mutex       dyninst_mutex;
 extern call_expr_t*     terminate_expr;
+extern variable_expr_t* trace_guard;
 extern snippet_vec_t    init_names;
 extern snippet_vec_t    fini_names;
 extern fmodset_t        available_module_functions;
@@ -241,6 +264,7 @@ extern regexvec_t       func_internal_include;
 extern regexvec_t       file_internal_include;
 extern regexvec_t       instruction_exclude;
 extern CodeCoverageMode coverage_mode;
+extern LoopMode         loop_mode;
 //
 // symtab variables
 //
@@ -320,8 +344,10 @@ process_modules(const std::vector<module_t*>&);
 strset_t
 get_whole_function_names();
 
+// when a mutex is given, it is only held while dyninst is queried
 function_signature
-get_func_file_line_info(module_t* mutatee_module, procedure_t* f);
+get_func_file_line_info(module_t* mutatee_module, procedure_t* f,
+                        std::mutex* _mutex = nullptr);
 
 function_signature
 get_loop_file_line_info(module_t* mutatee_module, procedure_t* f, flow_graph_t* cfGraph,
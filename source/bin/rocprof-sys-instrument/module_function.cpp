@@ -25,10 +25,14 @@
 #include "fwd.hpp"
 #include "internal_libs.hpp"
 #include "log.hpp"
+#include "profile_feedback.hpp"
 #include "rocprof-sys-instrument.hpp"
 
 #include <timemory/utility/join.hpp>
 
+#include <map>
+#include <optional>
+#include <shared_mutex>
 #include <stdexcept>
 
 module_function::width_t&
@@ -59,15 +63,45 @@ module_function::update_width(const module_function& rhs)
 module_function::module_function(module_t* mod, procedure_t* proc)
 : module{ mod }
 , function{ proc }
-, symtab_function{ proc->isInstrumentable() ? get_symtab_function(proc) : nullptr }
-, flow_graph{ proc->getCFG() }
-, module_name{ get_name(module) }
-, function_name{ get_name(function) }
 {
+    // the functions are constructed concurrently (see parallel_for). Only the queries
+    // which touch the state shared by the functions are serialized: the creation of
+    // the CFG (which registers its blocks with the address space), the lazily parsed
+    // symtab types and line information of the module and the name caches
+    auto _instrumentable = false;
+    {
+        auto _lk        = std::unique_lock<std::mutex>{ dyninst_mutex };
+        _instrumentable = function->isInstrumentable();
+        symtab_function = (_instrumentable) ? get_symtab_function(function) : nullptr;
+        flow_graph      = function->getCFG();
+        module_name     = get_name(module);
+        function_name   = get_name(function);
+
+        auto _range = std::pair<address_t, address_t>{};
+        if(function->getAddressRange(_range.first, _range.second))
+        {
+            start_address = _range.first;
+            address_range = _range.second - _range.first;
+        }
+    }
+
+    signature = get_func_file_line_info(module, function, &dyninst_mutex);
+
+    // this information is potentially not available and
+    // appears to be the cause of a segfault in testing
+    // so only attempt to extract it for instrumentable
+    // functions. The basic blocks are created with the CFG and the loops are
+    // analyzed on the CFG of this function only, so neither needs the lock
+    if(_instrumentable && flow_graph)
+    {
+        flow_graph->getAllBasicBlocks(basic_blocks);
+        flow_graph->getOuterLoops(loop_blocks);
+    }
+
     ROCPROFSYS_ADD_LOG_ENTRY("Adding function", function_name, "from module",
                              module_name);
 
-    if(!function->isInstrumentable())
+    if(!_instrumentable)
     {
         verbprintf(1,
                    "Warning! module function generated for un-instrumentable "
@@ -75,31 +109,12 @@ module_function::module_function(module_t* mod, procedure_t* proc)
                    function_name.c_str(), module_name.c_str());
     }
 
-    auto _range = std::pair<address_t, address_t>{};
-    if(function->getAddressRange(_range.first, _range.second))
-    {
-        start_address = _range.first;
-        address_range = _range.second - _range.first;
-    }
-
-    signature = get_func_file_line_info(module, function);
-
     // make sure all exist
     for(int i = 0; i <= instruction_category_t::c_NoCategory; ++i)
         instruction_types[static_cast<instruction_category_t>(i)] = 0;
 
-    if(function->isInstrumentable())
+    if(_instrumentable)
     {
-        // this information is potentially not available and
-        // appears to be the cause of a segfault in testing
-        // so only attempt to extract it for instrumentable
-        // functions
-        if(flow_graph)
-        {
-            flow_graph->getAllBasicBlocks(basic_blocks);
-            flow_graph->getOuterLoops(loop_blocks);
-        }
-
         instructions.reserve(basic_blocks.size());
         size_t _n = 0;
         for(const auto& itr : basic_blocks)
@@ -240,6 +255,13 @@ module_function::should_instrument(bool coverage) const
     if(!file_restrict.empty() || !func_restrict.empty()) return !is_user_restricted();
     if(is_user_included()) return true;
 
+    // the profile feedback targets the overhead of the trace instrumentation
+    if(!coverage)
+    {
+        if(is_profile_excluded()) return false;
+        if(is_profile_included()) return true;
+    }
+
     // do not apply visibility and linkage constraints to code coverage
     if(!coverage)
     {
@@ -257,7 +279,12 @@ module_function::should_instrument(bool coverage) const
 bool
 module_function::is_instrumentable() const
 {
-    if(!function->isInstrumentable())
+    auto _instrumentable = [this]() {
+        auto _lk = std::unique_lock<std::mutex>{ dyninst_mutex };
+        return function->isInstrumentable();
+    }();
+
+    if(!_instrumentable)
     {
         messages.emplace_back(2, "Skipping", "module", "not-instrumentable", module_name);
         return false;
@@ -276,6 +303,32 @@ check_regex_restrictions(const std::string& _name, const regexvec_t& _regexes)
         if(std::regex_search(_name, itr)) return true;
     return false;
 }
+
+// evaluates _func once per module name and returns the cached result for every other
+// function in the module. Each call-site passes a distinct lambda type and thus gets
+// its own cache. The functions are evaluated concurrently so the cache is guarded
+template <typename FuncT>
+auto
+memoize_module(const std::string& _module_name, FuncT&& _func)
+{
+    using value_type = decltype(_func());
+
+    static auto _mutex = std::shared_mutex{};
+    static auto _cache = std::map<std::string, value_type>{};
+
+    {
+        auto _lk  = std::shared_lock<std::shared_mutex>{ _mutex };
+        auto _itr = _cache.find(_module_name);
+        if(_itr != _cache.end()) return _itr->second;
+    }
+
+    auto _v  = _func();
+    auto _lk = std::unique_lock<std::shared_mutex>{ _mutex };
+    return _cache.emplace(_module_name, std::move(_v)).first->second;
+}
+
+// message reported when a module-level constraint applies
+using module_report_t = std::optional<module_function::str_msg_t>;
 }  // namespace
 
 bool
@@ -283,7 +336,9 @@ module_function::is_user_restricted() const
 {
     if(!file_restrict.empty())
     {
-        if(check_regex_restrictions(module_name, file_restrict))
+        if(memoize_module(module_name, [this]() {
+               return check_regex_restrictions(module_name, file_restrict);
+           }))
         {
             messages.emplace_back(2, "Forcing", "module", "module-restrict-regex",
                                   module_name);
@@ -327,7 +382,9 @@ module_function::is_user_included() const
 {
     if(!file_include.empty())
     {
-        if(check_regex_restrictions(module_name, file_include))
+        if(memoize_module(module_name, [this]() {
+               return check_regex_restrictions(module_name, file_include);
+           }))
         {
             messages.emplace_back(2, "Forcing", "module", "module-include-regex",
                                   module_name);
@@ -359,7 +416,9 @@ module_function::is_user_excluded() const
 {
     if(!file_exclude.empty())
     {
-        if(check_regex_restrictions(module_name, file_exclude))
+        if(memoize_module(module_name, [this]() {
+               return check_regex_restrictions(module_name, file_exclude);
+           }))
         {
             messages.emplace_back(2, "Skipping", "module", "module-exclude-regex",
                                   module_name);
@@ -386,10 +445,37 @@ module_function::is_user_excluded() const
     return false;
 }
 
+bool
+module_function::is_profile_excluded() const
+{
+    const auto* _entry = find_profile_feedback(signature.get(), function_name);
+    if(_entry && _entry->decision == profile_feedback_entry::PF_EXCLUDE)
+    {
+        messages.emplace_back(2, "Skipping", "function", _entry->reason, function_name);
+        return true;
+    }
+
+    return false;
+}
+
+bool
+module_function::is_profile_included() const
+{
+    const auto* _entry = find_profile_feedback(signature.get(), function_name);
+    if(_entry && _entry->decision == profile_feedback_entry::PF_INCLUDE)
+    {
+        messages.emplace_back(2, "Forcing", "function", _entry->reason, function_name);
+        return true;
+    }
+
+    return false;
+}
+
 bool
 module_function::is_overlapping() const
 {
     procedure_vec_t _overlapping{};
+    auto            _lk = std::unique_lock<std::mutex>{ dyninst_mutex };
     return function->findOverlapping(_overlapping);
 }
 
@@ -440,47 +526,70 @@ module_function::is_internal_constrained() const
         return true;
     };
 
+    static const auto _module_lib_regex =
+        std::regex{ "lib(rocprof-sys|rocprofsys|timemory|perfetto)" };
+    static const auto _module_src_regex =
+        std::regex{ ".*/source/lib/"
+                    "(core|common|binary|"
+                    "rocprofsys|rocprofsys-dl|"
+                    "rocprofsys-user)/.*/.*\\.(h|c|cpp|hpp)$" };
+    static const auto _rocprofsys_regex =
+        std::regex{ "10rocprofsys|rocprofsys|rocprofsys(::|_)" };
+    static const auto _timemory_regex = std::regex{ "3tim|tim::|timemory(::|_)" };
+    static const auto _perfetto_regex = std::regex{ "9perfetto|perfetto(::|_)" };
+
     const auto& _gnu_libs = get_internal_libs_data();
 
-    auto _module_base = _basename(module_name);
-    auto _module_real = _realpath(module_name);
-
-    if(std::regex_search(module_name,
-                         std::regex{ "lib(rocprof-sys|rocprofsys|timemory|perfetto)" }))
-        return _report("Excluding", "module", "rocprofsys", 3);
-    else if(std::regex_match(module_name,
-                             std::regex{ ".*/source/lib/"
-                                         "(core|common|binary|"
-                                         "rocprofsys|rocprofsys-dl|"
-                                         "rocprofsys-user)/.*/.*\\.(h|c|cpp|hpp)$" }))
-        return _report("Excluding", "module", "rocprofsys", 3);
-
-    if(std::regex_search(function_name,
-                         std::regex{ "10rocprofsys|rocprofsys|rocprofsys(::|_)" }))
+    // the module checks (including the realpath of the module) are shared by all the
+    // functions in the module
+    auto _module_report = memoize_module(module_name, [&]() -> module_report_t {
+        auto _module_msg = [&](const string_t& _reason) {
+            return module_function::str_msg_t{ 3, "Excluding", "module", _reason,
+                                               module_name };
+        };
+
+        if(std::regex_search(module_name, _module_lib_regex) ||
+           std::regex_match(module_name, _module_src_regex))
+            return _module_msg("rocprofsys");
+
+        auto _module_base = _basename(module_name);
+        auto _module_real = _realpath(module_name);
+
+        if(_gnu_libs.find(module_name) != _gnu_libs.end() ||
+           _gnu_libs.find(_module_real) != _gnu_libs.end() ||
+           _gnu_libs.find(_module_base) != _gnu_libs.end())
+            return _module_msg("internal library");
+
+        for(const auto& litr : _gnu_libs)
+        {
+            if(_module_base == _basename(litr.first) ||
+               litr.second.find(_module_base) != litr.second.end() ||
+               _module_real == litr.first ||
+               litr.second.find(_module_real) != litr.second.end() ||
+               litr.second.find(module_name) != litr.second.end())
+                return _module_msg(join(" ", "internal library", litr.first));
+        }
+
+        return std::nullopt;
+    });
+
+    if(_module_report)
+    {
+        messages.emplace_back(*_module_report);
+        return true;
+    }
+
+    if(std::regex_search(function_name, _rocprofsys_regex))
         return _report("Excluding", "function", "rocprofsys", 3);
-    else if(std::regex_search(function_name, std::regex{ "3tim|tim::|timemory(::|_)" }))
+    else if(std::regex_search(function_name, _timemory_regex))
         return _report("Excluding", "function", "timemory", 3);
-    else if(std::regex_search(function_name, std::regex{ "9perfetto|perfetto(::|_)" }))
+    else if(std::regex_search(function_name, _perfetto_regex))
         return _report("Excluding", "function", "perfetto", 3);
 
-    if(_gnu_libs.find(module_name) != _gnu_libs.end() ||
-       _gnu_libs.find(_module_real) != _gnu_libs.end() ||
-       _gnu_libs.find(_module_base) != _gnu_libs.end())
-        return _report("Excluding", "module", "internal library", 3);
-
     for(const auto& litr : _gnu_libs)
     {
-        if(_module_base == _basename(litr.first) ||
-           litr.second.find(_module_base) != litr.second.end() ||
-           _module_real == litr.first ||
-           litr.second.find(_module_real) != litr.second.end() ||
-           litr.second.find(module_name) != litr.second.end())
-            return _report("Excluding", "module",
-                           join(" ", "internal library", litr.first), 3);
-
         for(const auto& fitr : litr.second)
         {
-            using ::timemory::join::join;
             if(fitr.second.find(function_name) != fitr.second.end())
                 return _report("Excluding", "function",
                                join(" ", "internal library", litr.first), 3);
@@ -492,19 +601,40 @@ module_function::is_internal_constrained() const
 
 bool
 module_function::is_module_constrained() const
+{
+    // these constraints only depend on the module so they are evaluated once per module
+    auto _module_report = memoize_module(module_name, [this]() {
+        return is_module_constrained_impl();
+    });
+
+    if(_module_report)
+    {
+        messages.emplace_back(*_module_report);
+        return true;
+    }
+
+    return false;
+}
+
+std::optional<module_function::str_msg_t>
+module_function::is_module_constrained_impl() const
 {
     auto regex_opts = std::regex_constants::egrep | std::regex_constants::optimize;
     auto _report    = [&](const string_t& _action, const string_t& _reason, int _lvl) {
-        messages.emplace_back(_lvl, _action, "module", _reason, module_name);
-        return true;
+        return str_msg_t{ _lvl, _action, "module", _reason, module_name };
     };
 
-    if(module->isSystemLib()) return _report("Excluding", "system library", 3);
+    auto _is_system_lib = [this]() {
+        auto _lk = std::unique_lock<std::mutex>{ dyninst_mutex };
+        return module->isSystemLib();
+    };
+
+    if(_is_system_lib()) return _report("Excluding", "system library", 3);
 
     // always instrument these modules
     if(module_name == "DEFAULT_MODULE" || module_name == "LIBRARY_MODULE")
         // return _report("Skipping", "default module", 2);
-        return false;
+        return std::nullopt;
 
     static std::regex ext_regex{ "\\.(s|S)$", regex_opts };
     static std::regex sys_regex{ "^(s|k|e|w)_[A-Za-z_0-9\\-]+\\.(c|C)$", regex_opts };
@@ -548,7 +678,7 @@ module_function::is_module_constrained() const
     // if(std::regex_search(module_name, prefix_regex))
     //    return _report("Excluding", "prefix match", 3);
 
-    return false;
+    return std::nullopt;
 }
 
 bool
@@ -646,6 +776,7 @@ module_function::is_overlapping_constrained() const
 bool
 module_function::contains_dynamic_callsites() const
 {
+    auto _lk = std::unique_lock<std::mutex>{ dyninst_mutex };
     if(flow_graph) return flow_graph->containsDynamicCallsites();
 
     return false;
@@ -656,12 +787,18 @@ module_function::contains_user_callsite() const
 {
     if(caller_include.empty()) return false;
 
-    std::vector<BPatch_point*> call_points;
-    function->getCallPoints(call_points);
-    for(const auto& call_point : call_points)
+    auto _callees = strvec_t{};
     {
-        if(check_regex_restrictions(
-               std::string(get_name(call_point->getCalledFunction())), caller_include))
+        auto _lk = std::unique_lock<std::mutex>{ dyninst_mutex };
+        std::vector<BPatch_point*> call_points;
+        function->getCallPoints(call_points);
+        for(const auto& call_point : call_points)
+            _callees.emplace_back(get_name(call_point->getCalledFunction()));
+    }
+
+    for(const auto& itr : _callees)
+    {
+        if(check_regex_restrictions(itr, caller_include))
         {
             messages.emplace_back(2, "Forcing", "function", "caller-include-regex",
                                   function_name);
@@ -706,6 +843,7 @@ module_function::is_instruction_constrained() const
     {
         for(auto&& itr : instructions)
         {
+            // formatting the decoded instructions does not query the BPatch layer
             auto _instrss = std::stringstream{};
             for(auto&& iitr : itr)
                 _instrss << " " << iitr.first.format();
@@ -787,13 +925,23 @@ module_function::is_linkage_constrained() const
             enabled_linkage.find(_linkage) == enabled_linkage.end());
 }
 
+std::tuple<size_t, size_t>
+module_function::get_num_points(procedure_loc_t _loc) const
+{
+    // the entry and exit points are checked by several constraints
+    auto itr = num_points.find(_loc);
+    if(itr == num_points.end())
+        itr = num_points.emplace(_loc, query_instr(function, _loc)).first;
+    return itr->second;
+}
+
 bool
 module_function::can_instrument_entry() const
 {
     size_t _num_points = 0;
     size_t _num_traps  = 0;
 
-    std::tie(_num_points, _num_traps) = query_instr(function, BPatch_entry);
+    std::tie(_num_points, _num_traps) = get_num_points(BPatch_entry);
 
     if(_num_points == 0)
     {
@@ -811,7 +959,7 @@ module_function::can_instrument_exit() const
     size_t _num_points = 0;
     size_t _num_traps  = 0;
 
-    std::tie(_num_points, _num_traps) = query_instr(function, BPatch_exit);
+    std::tie(_num_points, _num_traps) = get_num_points(BPatch_exit);
 
     if(_num_points == 0)
     {
@@ -831,7 +979,7 @@ module_function::is_entry_trap_constrained() const
     size_t _num_points = 0;
     size_t _num_traps  = 0;
 
-    std::tie(_num_points, _num_traps) = query_instr(function, BPatch_entry);
+    std::tie(_num_points, _num_traps) = get_num_points(BPatch_entry);
 
     if(!instr_traps && (_num_points - _num_traps) == 0)
     {
@@ -851,7 +999,7 @@ module_function::is_exit_trap_constrained() const
     size_t _num_points = 0;
     size_t _num_traps  = 0;
 
-    std::tie(_num_points, _num_traps) = query_instr(function, BPatch_exit);
+    std::tie(_num_points, _num_traps) = get_num_points(BPatch_exit);
 
     if((_num_points - _num_traps) == 0)
     {
@@ -874,7 +1022,7 @@ module_function::operator()(address_space_t* _addr_space, procedure_t* _entr_tra
     auto _name       = signature.get();
     auto _trace_entr = rocprofsys_call_expr(_name.c_str());
     auto _trace_exit = rocprofsys_call_expr(_name.c_str());
-    auto _entr       = _trace_entr.get(_entr_trace);
+    auto _entr       = get_guarded_snippet(_trace_entr.get(_entr_trace));
     auto _exit       = _trace_exit.get(_exit_trace);
 
     if(insert_instr(_addr_space, function, _entr, BPatch_entry) &&
@@ -923,9 +1071,20 @@ module_function::operator()(address_space_t* _addr_space, procedure_t* _entr_tra
                            "loop-exit-point-trap-instrumentation", _lname))
             continue;
 
+        if(loop_mode != LOOP_TRACE)
+        {
+            if(insert_loop_counters(_addr_space, i, itr, _lname))
+            {
+                messages.emplace_back(1, "Loop Counting", "function", "no-constraint",
+                                      _lname);
+                ++_count.second;
+            }
+            continue;
+        }
+
         auto _ltrace_entr = rocprofsys_call_expr(_lname.c_str());
         auto _ltrace_exit = rocprofsys_call_expr(_lname.c_str());
-        auto _lentr       = _ltrace_entr.get(_entr_trace);
+        auto _lentr       = get_guarded_snippet(_ltrace_entr.get(_entr_trace));
         auto _lexit       = _ltrace_exit.get(_exit_trace);
 
         if(insert_instr(_addr_space, function, _lentr, BPatch_entry, flow_graph, itr,
@@ -950,10 +1109,13 @@ module_function::register_source(address_space_t* _addr_space, procedure_t* _ent
     {
         case CODECOV_FUNCTION:
         {
-            auto _name = signature.get_coverage(false);
-            auto _trace_entr =
-                rocprofsys_call_expr(signature.m_file, signature.m_name,
-                                     signature.m_row.first, start_address, _name);
+            auto* _index = get_coverage_index(_addr_space, start_address);
+            if(!_index) break;
+
+            auto _name       = signature.get_coverage(false);
+            auto _trace_entr = rocprofsys_call_expr(
+                signature.m_file, signature.m_name, signature.m_row.first, start_address,
+                _name, std::make_shared<snippet_t>(arith_expr_t{ BPatch_addr, *_index }));
             auto _entr = _trace_entr.get(_entr_trace);
 
             if(insert_instr(_addr_space, _entr_points, _entr, BPatch_entry))
@@ -969,10 +1131,14 @@ module_function::register_source(address_space_t* _addr_space, procedure_t* _ent
             {
                 auto  _start_addr = itr.second.start_address;
                 auto& _signature  = itr.second.signature;
-                auto  _name       = _signature.get_coverage(true);
-                auto  _trace_entr =
-                    rocprofsys_call_expr(_signature.m_file, _signature.m_name,
-                                         _signature.m_row.first, _start_addr, _name);
+                auto* _index      = get_coverage_index(_addr_space, _start_addr);
+                if(!_index) continue;
+
+                auto _name       = _signature.get_coverage(true);
+                auto _trace_entr = rocprofsys_call_expr(
+                    _signature.m_file, _signature.m_name, _signature.m_row.first,
+                    _start_addr, _name,
+                    std::make_shared<snippet_t>(arith_expr_t{ BPatch_addr, *_index }));
                 auto _entr = _trace_entr.get(_entr_trace);
 
                 if(insert_instr(_addr_space, _entr_points, _entr, BPatch_entry))
@@ -987,6 +1153,114 @@ module_function::register_source(address_space_t* _addr_space, procedure_t* _ent
     }
 }
 
+variable_expr_t*
+module_function::get_coverage_index(address_space_t* _addr_space, size_t _addr) const
+{
+    auto itr = coverage_index.find(_addr);
+    if(itr != coverage_index.end()) return itr->second;
+
+    // the allocation is zero-initialized and zero is never assigned by the runtime so
+    // the hits of a site which executes before it is registered are ignored
+    static auto* _type = _addr_space->getImage()->findType("int");
+    auto*        _var  = (_type) ? _addr_space->malloc(*_type) : nullptr;
+    if(!_var)
+    {
+        verbprintf(0, "Warning! Unable to allocate the coverage index for %s (0x%zx)\n",
+                   function_name.c_str(), _addr);
+    }
+    return coverage_index.emplace(_addr, _var).first->second;
+}
+
+module_function::loop_counter&
+module_function::get_loop_counter(address_space_t* _addr_space, size_t _idx,
+                                  const string_t& _name) const
+{
+    auto itr = loop_counters.find(_idx);
+    if(itr != loop_counters.end()) return itr->second;
+
+    // the allocations are zero-initialized
+    static auto* _type = [_addr_space]() {
+        auto* _v = _addr_space->getImage()->findType("unsigned long");
+        return (_v) ? _v : _addr_space->getImage()->findType("long");
+    }();
+    auto _alloc = [_addr_space]() -> variable_expr_t* {
+        return (_type) ? _addr_space->malloc(*_type) : nullptr;
+    };
+
+    auto _counter = loop_counter{ _name, _alloc(), nullptr };
+    if(_counter.entries && loop_mode == LOOP_ITERATIONS) _counter.iterations = _alloc();
+    if(!_counter.entries)
+    {
+        verbprintf(0, "Warning! Unable to allocate the loop counters for %s\n",
+                   _name.c_str());
+    }
+    return loop_counters.emplace(_idx, _counter).first->second;
+}
+
+bool
+module_function::insert_loop_counters(address_space_t* _addr_space, size_t _idx,
+                                      basic_loop_t* _loop, const string_t& _name) const
+{
+    auto& _counter = get_loop_counter(_addr_space, _idx, _name);
+    if(!_counter.entries) return false;
+
+    // the increment is performed in the mutatee without a call into the library. It
+    // is not atomic so concurrent executions of the loop may lose counts
+    auto _increment = [](variable_expr_t* _var) {
+        return std::make_shared<arith_expr_t>(
+            BPatch_assign, *_var, arith_expr_t{ BPatch_plus, *_var, const_expr_t{ 1 } });
+    };
+
+    if(!insert_instr(_addr_space, function, _increment(_counter.entries), BPatch_entry,
+                     flow_graph, _loop, instr_loop_traps))
+        return false;
+
+    if(_counter.iterations)
+    {
+        auto* _points = flow_graph->findLoopInstPoints(BPatch_locLoopStartIter, _loop);
+        if(!_points || !insert_instr(_addr_space, *_points,
+                                     _increment(_counter.iterations),
+                                     BPatch_locLoopStartIter, instr_loop_traps))
+        {
+            messages.emplace_back(2, "Skipping", "loop-iterations",
+                                  "no-instrumentable-loop-iteration-point", _name);
+        }
+    }
+
+    return true;
+}
+
+std::vector<call_expr_pointer_t>
+module_function::register_loop_counters(address_space_t* _addr_space,
+                                        procedure_t*     _reg_func,
+                                        const std::vector<point_t*>* _entr_points) const
+{
+    auto _calls = std::vector<call_expr_pointer_t>{};
+    auto _name  = signature.get();
+    for(const auto& itr : loop_counters)
+    {
+        const auto& _counter = itr.second;
+        if(!_counter.entries) continue;
+
+        // the address of each counter (null when the iterations are not counted)
+        auto _addr = [](variable_expr_t* _var) {
+            if(!_var)
+                return std::make_shared<snippet_t>(
+                    const_expr_t{ static_cast<const void*>(nullptr) });
+            return std::make_shared<snippet_t>(arith_expr_t{ BPatch_addr, *_var });
+        };
+
+        auto _reg_loop = rocprofsys_call_expr(
+            _name, _counter.name, _addr(_counter.entries), _addr(_counter.iterations));
+        auto _reg_call = _reg_loop.get(_reg_func);
+
+        if(_entr_points)
+            insert_instr(_addr_space, *_entr_points, _reg_call, BPatch_entry);
+        _calls.emplace_back(std::move(_reg_call));
+    }
+    return _calls;
+}
+
 std::pair<size_t, size_t>
 module_function::register_coverage(address_space_t* _addr_space,
                                    procedure_t*     _entr_trace) const
@@ -996,9 +1270,13 @@ module_function::register_coverage(address_space_t* _addr_space,
     {
         case CODECOV_FUNCTION:
         {
-            auto _trace_entr =
-                rocprofsys_call_expr(signature.m_file, signature.m_name, start_address);
-            auto _entr = _trace_entr.get(_entr_trace);
+            auto* _index = get_coverage_index(_addr_space, start_address);
+            if(!_index) break;
+
+            // the hit only passes the value of the index so the runtime does not have
+            // to look up the site by its file, function and address
+            auto _trace_entr = rocprofsys_call_expr(std::make_shared<snippet_t>(*_index));
+            auto _entr       = _trace_entr.get(_entr_trace);
 
             if(insert_instr(_addr_space, function, _entr, BPatch_entry))
             {
@@ -1014,9 +1292,12 @@ module_function::register_coverage(address_space_t* _addr_space,
             {
                 auto  _start_addr = itr.second.start_address;
                 auto& _signature  = itr.second.signature;
-                auto  _trace_entr = rocprofsys_call_expr(_signature.m_file,
-                                                        _signature.m_name, _start_addr);
-                auto  _entr       = _trace_entr.get(_entr_trace);
+                auto* _index      = get_coverage_index(_addr_space, _start_addr);
+                if(!_index) continue;
+
+                auto _trace_entr =
+                    rocprofsys_call_expr(std::make_shared<snippet_t>(*_index));
+                auto _entr = _trace_entr.get(_entr_trace);
 
                 if(insert_instr(_addr_space, _entr, BPatch_entry, itr.first))
                 {
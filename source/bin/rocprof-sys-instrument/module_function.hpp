@@ -28,6 +28,7 @@
 #include <timemory/mpl/concepts.hpp>
 #include <timemory/tpls/cereal/cereal/cereal.hpp>
 
+#include <optional>
 #include <sstream>
 #include <string>
 #include <tuple>
@@ -56,6 +57,13 @@ struct module_function
     std::pair<size_t, size_t> register_coverage(address_space_t* _addr_space,
                                                 procedure_t*     _entr_trace) const;
 
+    // loop counters (--loop-mode entries/iterations). The registration calls are
+    // inserted at the entry points, if provided, and returned so that they can be
+    // executed once when attached to a running process
+    std::vector<call_expr_pointer_t> register_loop_counters(
+        address_space_t* _addr_space, procedure_t* _reg_func,
+        const std::vector<point_t*>* _entr_points) const;
+
     // instrumentation
     std::pair<size_t, size_t> operator()(address_space_t* _addr_space,
                                          procedure_t*     _entr_trace,
@@ -78,6 +86,10 @@ struct module_function
     bool is_user_included() const;    // checks user include regexes
     bool is_user_excluded() const;    // checks user exclude regexes
 
+    // selection from the profile of a previous run (--profile-feedback)
+    bool is_profile_excluded() const;  // checks the instrumentation overhead budget
+    bool is_profile_included() const;  // checks for hot, expensive functions
+
     // applied before dynamic-callsite constraint
     bool is_overlapping_constrained() const;  // checks overlapping constrains
     bool is_entry_trap_constrained() const;   // checks entry trap constraint
@@ -113,6 +125,21 @@ struct module_function
 
     mutable str_msg_vec_t messages = {};
 
+    // variables in the mutatee holding the coverage index which the runtime assigns
+    // to each site when it is registered, keyed by the start address of the site
+    mutable std::map<size_t, variable_expr_t*> coverage_index = {};
+
+    struct loop_counter
+    {
+        string_t         name       = {};
+        variable_expr_t* entries    = nullptr;
+        variable_expr_t* iterations = nullptr;
+    };
+
+    // variables in the mutatee which are incremented at the entry and at the start of
+    // each iteration of a loop, keyed by the loop number
+    mutable std::map<size_t, loop_counter> loop_counters = {};
+
     bool is_overlapping() const;  // checks if func overlaps
 
 private:
@@ -123,6 +150,16 @@ private:
     bool contains_dynamic_callsites() const;
     bool should_instrument(bool _coverage) const;
     bool contains_user_callsite() const;  // checks user caller regexes
+    std::optional<str_msg_t> is_module_constrained_impl() const;
+    variable_expr_t* get_coverage_index(address_space_t*, size_t) const;
+    loop_counter&    get_loop_counter(address_space_t*, size_t, const string_t&) const;
+    bool insert_loop_counters(address_space_t*, size_t, basic_loop_t*,
+                              const string_t&) const;
+    std::tuple<size_t, size_t> get_num_points(procedure_loc_t) const;
+
+    // number of instrumentation points and of those requiring traps at the entry and
+    // exit of the function, queried once per location
+    mutable std::map<procedure_loc_t, std::tuple<size_t, size_t>> num_points = {};
 
 public:
     template <typename ArchiveT>
@@ -216,6 +253,8 @@ module_function::serialize(ArchiveT& ar, const unsigned)
            cereal::make_nvp("is_user_included", is_user_included()),
            cereal::make_nvp("contains_user_callsite", contains_user_callsite()),
            cereal::make_nvp("is_user_excluded", is_user_excluded()),
+           cereal::make_nvp("is_profile_excluded", is_profile_excluded()),
+           cereal::make_nvp("is_profile_included", is_profile_included()),
            cereal::make_nvp("is_overlapping_constrained", is_overlapping_constrained()),
            cereal::make_nvp("is_entry_trap_constrained", is_entry_trap_constrained()),
            cereal::make_nvp("is_exit_trap_constrained", is_exit_trap_constrained()),
@@ -0,0 +1,254 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "plan_cache.hpp"
+#include "fwd.hpp"
+#include "log.hpp"
+#include "module_function.hpp"
+
+#include <timemory/mpl/policy.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/utility/filepath.hpp>
+#include <timemory/utility/join.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <elf.h>
+#include <fcntl.h>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+namespace filepath = ::tim::filepath;
+using ::timemory::join::join;
+
+template <typename Tp>
+auto
+to_hex(Tp _v)
+{
+    auto _ss = std::stringstream{};
+    _ss << std::hex << std::setw(2 * sizeof(Tp)) << std::setfill('0') << _v;
+    return _ss.str();
+}
+
+bool
+read_at(int _fd, void* _dst, size_t _size, off_t _offset)
+{
+    return (pread(_fd, _dst, _size, _offset) == static_cast<ssize_t>(_size));
+}
+
+// walks the SHT_NOTE sections of a 64-bit ELF file for a NT_GNU_BUILD_ID note
+std::optional<string_t>
+read_build_id(int _fd)
+{
+    auto _ehdr = Elf64_Ehdr{};
+    if(!read_at(_fd, &_ehdr, sizeof(_ehdr), 0)) return std::nullopt;
+    if(memcmp(_ehdr.e_ident, ELFMAG, SELFMAG) != 0 ||
+       _ehdr.e_ident[EI_CLASS] != ELFCLASS64 || _ehdr.e_shentsize != sizeof(Elf64_Shdr))
+        return std::nullopt;
+
+    for(size_t i = 0; i < _ehdr.e_shnum; ++i)
+    {
+        auto _shdr = Elf64_Shdr{};
+        if(!read_at(_fd, &_shdr, sizeof(_shdr), _ehdr.e_shoff + (i * sizeof(_shdr))))
+            return std::nullopt;
+        if(_shdr.sh_type != SHT_NOTE || _shdr.sh_size > (1 << 16)) continue;
+
+        auto _data = std::vector<uint8_t>(_shdr.sh_size, 0);
+        if(!read_at(_fd, _data.data(), _data.size(), _shdr.sh_offset)) continue;
+
+        size_t _pos = 0;
+        while(_pos + sizeof(Elf64_Nhdr) <= _data.size())
+        {
+            auto _nhdr = Elf64_Nhdr{};
+            memcpy(&_nhdr, _data.data() + _pos, sizeof(_nhdr));
+            auto _name = _pos + sizeof(_nhdr);
+            auto _desc = _name + ((_nhdr.n_namesz + 3) & ~3UL);
+            auto _next = _desc + ((_nhdr.n_descsz + 3) & ~3UL);
+            if(_desc + _nhdr.n_descsz > _data.size()) break;
+
+            if(_nhdr.n_type == NT_GNU_BUILD_ID && _nhdr.n_namesz == 4 &&
+               memcmp(_data.data() + _name, "GNU", 4) == 0)
+            {
+                auto _ss = std::stringstream{};
+                for(size_t j = 0; j < _nhdr.n_descsz; ++j)
+                    _ss << std::hex << std::setw(2) << std::setfill('0')
+                        << static_cast<int>(_data.at(_desc + j));
+                return _ss.str();
+            }
+            _pos = _next;
+        }
+    }
+
+    return std::nullopt;
+}
+}  // namespace
+
+string_t
+get_build_id(const string_t& _filename)
+{
+    auto _fd = open(_filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if(_fd < 0) return string_t{};
+
+    auto _build_id = read_build_id(_fd);
+    if(!_build_id)
+    {
+        struct stat _st = {};
+        if(fstat(_fd, &_st) == 0)
+            _build_id = join('-', "size", _st.st_size, "mtime", _st.st_mtim.tv_sec,
+                             _st.st_mtim.tv_nsec);
+    }
+
+    close(_fd);
+    return _build_id.value_or(string_t{});
+}
+
+uint64_t
+instrumentation_plan::get_offset(module_t* _mod, uint64_t _address)
+{
+    auto _base = (_mod) ? static_cast<uint64_t>(_mod->getLoadAddr()) : 0;
+    return (_address >= _base) ? (_address - _base) : _address;
+}
+
+instrumentation_plan::key_t
+instrumentation_plan::get_key(const module_function& _v)
+{
+    return key_t{ _v.module_name, _v.function_name,
+                  get_offset(_v.module, _v.start_address) };
+}
+
+instrumentation_plan::key_t
+instrumentation_plan::get_key(module_t* _mod, procedure_t* _proc)
+{
+    auto _range = std::pair<Dyninst::Address, Dyninst::Address>{};
+    if(!_proc->getAddressRange(_range.first, _range.second)) _range.first = 0;
+    return key_t{ string_t{ get_name(_mod) }, string_t{ get_name(_proc) },
+                  get_offset(_mod, _range.first) };
+}
+
+bool
+instrumentation_plan::contains(module_t* _mod, procedure_t* _proc) const
+{
+    auto _itr = entries.find(get_key(_mod, _proc));
+    return (_itr != entries.end() && _itr->second.flags != 0);
+}
+
+const instrumentation_plan::entry*
+instrumentation_plan::find(const module_function& _v) const
+{
+    auto _itr = entries.find(get_key(_v));
+    return (_itr != entries.end()) ? &_itr->second : nullptr;
+}
+
+void
+instrumentation_plan::insert(const module_function& _v, uint8_t _flags)
+{
+    auto _key     = get_key(_v);
+    entries[_key] = entry{ _v.module_name, _v.function_name, std::get<2>(_key), _flags,
+                           _v.messages };
+}
+
+string_t
+instrumentation_plan::get_filename(const string_t& _dir, const string_t& _target) const
+{
+    auto _hash = std::hash<std::string>{}(join('|', build_id, options, version));
+    return join("", _dir, "/", filepath::basename(_target), "-", to_hex(_hash),
+                ".json");
+}
+
+bool
+instrumentation_plan::save(const string_t& _fname) const
+{
+    namespace cereal = tim::cereal;
+    namespace policy = tim::policy;
+
+    std::stringstream oss{};
+    {
+        using output_policy = policy::output_archive<cereal::PrettyJSONOutputArchive>;
+        auto ar             = output_policy::get(oss);
+
+        ar->setNextName("rocprofsys");
+        ar->startNode();
+        (*ar)(cereal::make_nvp("instrumentation_plan", *this));
+        ar->finishNode();
+    }
+
+    // several ranks may save the same plan concurrently so the plan is written to a
+    // unique file first and then renamed
+    auto _tmp = join("", _fname, ".", getpid());
+    {
+        std::ofstream ofs{};
+        if(!filepath::open(ofs, _tmp)) return false;
+        ofs << oss.str() << std::endl;
+        if(!ofs) return false;
+    }
+
+    if(rename(_tmp.c_str(), _fname.c_str()) != 0)
+    {
+        unlink(_tmp.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool
+instrumentation_plan::load(const string_t& _fname)
+{
+    namespace cereal = tim::cereal;
+    namespace policy = tim::policy;
+
+    std::ifstream ifs{ _fname };
+    if(!ifs) return false;
+
+    auto _plan = instrumentation_plan{};
+    try
+    {
+        using input_policy = policy::input_archive<cereal::JSONInputArchive>;
+        auto ar            = input_policy::get(ifs);
+
+        ar->setNextName("rocprofsys");
+        ar->startNode();
+        (*ar)(cereal::make_nvp("instrumentation_plan", _plan));
+        ar->finishNode();
+    } catch(std::exception& _e)
+    {
+        ROCPROFSYS_ADD_LOG_ENTRY("Ignoring invalid instrumentation plan", _fname, ":",
+                                 _e.what());
+        return false;
+    }
+
+    if(_plan.build_id != build_id || _plan.options != options ||
+       _plan.version != version)
+    {
+        ROCPROFSYS_ADD_LOG_ENTRY("Ignoring stale instrumentation plan", _fname);
+        return false;
+    }
+
+    entries = std::move(_plan.entries);
+    return true;
+}
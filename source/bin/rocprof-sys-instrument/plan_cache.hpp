@@ -0,0 +1,160 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "fwd.hpp"
+#include "module_function.hpp"
+
+#include <timemory/tpls/cereal/cereal.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// results of the constraint evaluation of a function
+enum constraint_result : uint8_t
+{
+    CR_INSTRUMENT  = 0x1,
+    CR_COVERAGE    = 0x2,
+    CR_OVERLAPPING = 0x4,
+};
+
+// the outcome of the function analysis for one instrumentation target. It is keyed by
+// the ELF build-id of the target, a hash of the options which affect the analysis (which
+// includes the build-ids of the loaded libraries) and the rocprof-sys version and is
+// reused as long as all three match. The functions are identified by their offset from
+// the load address of their object so that the plan remains valid when the target or
+// the libraries are loaded at a different address (PIE/ASLR)
+struct instrumentation_plan
+{
+    using key_t = std::tuple<string_t, string_t, uint64_t>;
+
+    struct entry
+    {
+        string_t                       module_name   = {};
+        string_t                       function_name = {};
+        uint64_t                       offset        = 0;
+        uint8_t                        flags         = 0;
+        module_function::str_msg_vec_t messages      = {};
+
+        template <typename ArchiveT>
+        void serialize(ArchiveT& ar, const unsigned);
+    };
+
+    string_t               build_id = {};
+    string_t               options  = {};
+    string_t               version  = {};
+    std::map<key_t, entry> entries  = {};
+
+    static key_t    get_key(const module_function&);
+    static key_t    get_key(module_t*, procedure_t*);
+    static uint64_t get_offset(module_t*, uint64_t _address);
+
+    bool         contains(module_t*, procedure_t*) const;
+    const entry* find(const module_function&) const;
+    void         insert(const module_function&, uint8_t _flags);
+    string_t     get_filename(const string_t& _dir, const string_t& _target) const;
+    bool         save(const string_t& _fname) const;
+    bool         load(const string_t& _fname);
+
+    template <typename ArchiveT>
+    void serialize(ArchiveT& ar, const unsigned);
+};
+
+// returns the GNU build-id of an ELF file as a hex string. When the file does not have
+// one, the size and modification time of the file are used instead
+string_t
+get_build_id(const string_t& _filename);
+
+template <typename ArchiveT>
+void
+instrumentation_plan::entry::serialize(ArchiveT& ar, const unsigned)
+{
+    namespace cereal = tim::cereal;
+
+    ar(cereal::make_nvp("module", module_name),
+       cereal::make_nvp("function", function_name),
+       cereal::make_nvp("offset", offset),
+       cereal::make_nvp("flags", flags));
+
+    // the decision reasons are reported again when the plan is reused
+    auto _levels  = std::vector<int>{};
+    auto _reasons = std::vector<std::vector<string_t>>{};
+    if constexpr(tim::concepts::is_output_archive<ArchiveT>::value)
+    {
+        for(const auto& itr : messages)
+        {
+            _levels.emplace_back(std::get<0>(itr));
+            _reasons.emplace_back(std::vector<string_t>{
+                std::get<1>(itr), std::get<2>(itr), std::get<3>(itr), std::get<4>(itr) });
+        }
+    }
+
+    ar(cereal::make_nvp("message_levels", _levels),
+       cereal::make_nvp("messages", _reasons));
+
+    if constexpr(!tim::concepts::is_output_archive<ArchiveT>::value)
+    {
+        messages.clear();
+        for(size_t i = 0; i < std::min(_levels.size(), _reasons.size()); ++i)
+        {
+            if(_reasons.at(i).size() != 4) continue;
+            const auto& _v = _reasons.at(i);
+            messages.emplace_back(_levels.at(i), _v.at(0), _v.at(1), _v.at(2), _v.at(3));
+        }
+    }
+}
+
+template <typename ArchiveT>
+void
+instrumentation_plan::serialize(ArchiveT& ar, const unsigned)
+{
+    namespace cereal = tim::cereal;
+
+    ar(cereal::make_nvp("build_id", build_id), cereal::make_nvp("options", options),
+       cereal::make_nvp("version", version));
+
+    auto _entries = std::vector<entry>{};
+    if constexpr(tim::concepts::is_output_archive<ArchiveT>::value)
+    {
+        _entries.reserve(entries.size());
+        for(const auto& itr : entries)
+            _entries.emplace_back(itr.second);
+    }
+
+    ar(cereal::make_nvp("functions", _entries));
+
+    if constexpr(!tim::concepts::is_output_archive<ArchiveT>::value)
+    {
+        entries.clear();
+        for(auto& itr : _entries)
+        {
+            auto _key = key_t{ itr.module_name, itr.function_name, itr.offset };
+            entries.emplace(std::move(_key), std::move(itr));
+        }
+    }
+}
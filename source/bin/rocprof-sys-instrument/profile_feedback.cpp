@@ -0,0 +1,245 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "profile_feedback.hpp"
+#include "fwd.hpp"
+#include "log.hpp"
+
+#include <timemory/mpl/policy.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/utility/filepath.hpp>
+#include <timemory/utility/join.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+namespace cereal = ::tim::cereal;
+using ::timemory::join::join;
+
+std::map<string_t, profile_feedback_entry> profile_feedback_data = {};
+
+// the subset of a timemory call-graph node which is needed
+struct graph_node
+{
+    string_t prefix = {};
+    int64_t  depth  = 0;
+    double   laps   = 0;
+    double   accum  = 0;
+
+    template <typename ArchiveT>
+    void serialize(ArchiveT& ar, const unsigned)
+    {
+        ar(cereal::make_nvp("prefix", prefix), cereal::make_nvp("depth", depth));
+        ar.setNextName("entry");
+        ar.startNode();
+        ar(cereal::make_nvp("laps", laps), cereal::make_nvp("accum", accum));
+        ar.finishNode();
+    }
+};
+
+struct graph_rank
+{
+    std::vector<graph_node> graph = {};
+
+    template <typename ArchiveT>
+    void serialize(ArchiveT& ar, const unsigned)
+    {
+        ar(cereal::make_nvp("graph", graph));
+    }
+};
+
+// removes the thread/rank/depth decoration from the prefix, e.g. "|0>>> |_foo"
+string_t
+get_label(string_t _prefix)
+{
+    auto _pos = _prefix.find(">>> ");
+    if(_pos != string_t::npos) _prefix = _prefix.substr(_pos + 4);
+    _pos = _prefix.find_first_not_of(" |_");
+    return (_pos == string_t::npos) ? string_t{} : _prefix.substr(_pos);
+}
+
+// the thread decoration of the prefix, e.g. "|0>>>" for "|0>>> |_foo"
+string_t
+get_thread(const string_t& _prefix)
+{
+    auto _pos = _prefix.find(">>> ");
+    return (_pos == string_t::npos) ? string_t{} : _prefix.substr(0, _pos);
+}
+}  // namespace
+
+size_t
+load_profile_feedback(const string_t& _fname)
+{
+    auto _ranks = std::vector<graph_rank>{};
+    auto _ifs   = std::ifstream{};
+    if(!tim::filepath::open(_ifs, _fname))
+        throw std::runtime_error(
+            join(" ", "[rocprof-sys][exe] Error opening profile feedback file", _fname));
+
+    try
+    {
+        auto ar = tim::policy::input_archive<cereal::JSONInputArchive>::get(_ifs);
+
+        ar->setNextName("timemory");
+        ar->startNode();
+        ar->setNextName("wall_clock");
+        ar->startNode();
+        (*ar)(cereal::make_nvp("ranks", _ranks));
+        ar->finishNode();
+        ar->finishNode();
+    } catch(std::exception& _e)
+    {
+        throw std::runtime_error(join(" ", "[rocprof-sys][exe] Error reading",
+                                      _fname, "as a timemory wall_clock JSON file:",
+                                      _e.what()));
+    }
+
+    // a function may appear in several call-paths, threads and ranks. The graph is
+    // stored in depth-first order so the labels of the ancestors of each node are
+    // tracked: the inclusive time of a (recursive) call nested within a call of the
+    // same function is already part of the outer call and is not added again. All
+    // the calls contribute to the overhead. The inclusive times are normalized by the
+    // sum of the time of the roots of every thread and rank
+    double _total = 0.0;
+    profile_feedback_data.clear();
+    for(const auto& ritr : _ranks)
+    {
+        auto _thread = string_t{};
+        auto _path   = std::vector<string_t>{};
+        for(const auto& nitr : ritr.graph)
+        {
+            auto _depth = static_cast<size_t>(std::max<int64_t>(nitr.depth, 0));
+            auto _tid   = get_thread(nitr.prefix);
+            if(_tid != _thread) _path.clear();
+            _thread = _tid;
+            _path.resize(std::min(_path.size(), _depth));
+
+            auto _label = get_label(nitr.prefix);
+            auto _outer = std::find(_path.begin(), _path.end(), _label) == _path.end();
+            if(_path.empty()) _total += nitr.accum;
+            _path.emplace_back(_label);
+
+            if(_label.empty()) continue;
+            auto& _entry = profile_feedback_data[_label];
+            _entry.name  = _label;
+            _entry.calls += static_cast<uint64_t>(nitr.laps);
+            if(_outer) _entry.inclusive += nitr.accum;
+        }
+    }
+
+    auto _percent = [](double _v) {
+        auto _ss = std::stringstream{};
+        _ss << std::fixed << std::setprecision(1) << (100.0 * _v) << "-percent";
+        return _ss.str();
+    };
+
+    for(auto& itr : profile_feedback_data)
+    {
+        auto& _entry    = itr.second;
+        _entry.overhead = _entry.calls * profile_feedback_overhead;
+
+        auto _budget = profile_feedback_budget * _entry.inclusive;
+        auto _frac   = (_total > 0.0) ? (_entry.inclusive / _total) : 0.0;
+        if(_entry.overhead > _budget)
+        {
+            _entry.decision = profile_feedback_entry::PF_EXCLUDE;
+            _entry.reason   = join("-", "profile-feedback-overhead",
+                                   _percent(_entry.overhead /
+                                            std::max(_entry.inclusive, 1.0)));
+        }
+        else if(_frac >= profile_feedback_hot)
+        {
+            _entry.decision = profile_feedback_entry::PF_INCLUDE;
+            _entry.reason   = join("-", "profile-feedback-hot", _percent(_frac));
+        }
+    }
+
+    verbprintf(0, "Read %zu functions from the profile feedback '%s'\n",
+               profile_feedback_data.size(), _fname.c_str());
+
+    return profile_feedback_data.size();
+}
+
+const profile_feedback_entry*
+find_profile_feedback(const string_t& _label, const string_t& _name)
+{
+    if(profile_feedback_data.empty()) return nullptr;
+    for(const auto& itr : { _label, _name })
+    {
+        auto _entry = profile_feedback_data.find(itr);
+        if(_entry != profile_feedback_data.end()) return &_entry->second;
+    }
+    return nullptr;
+}
+
+void
+write_profile_feedback_report(std::ostream& _os, const strset_t& _found)
+{
+    auto _decision_str = [](profile_feedback_entry::decision_t _v) {
+        switch(_v)
+        {
+            case profile_feedback_entry::PF_EXCLUDE: return "excluded";
+            case profile_feedback_entry::PF_INCLUDE: return "included";
+            case profile_feedback_entry::PF_NONE: break;
+        }
+        return "heuristics";
+    };
+
+    // highest estimated overhead first
+    auto _data = std::vector<const profile_feedback_entry*>{};
+    for(const auto& itr : profile_feedback_data)
+        _data.emplace_back(&itr.second);
+    std::sort(_data.begin(), _data.end(), [](const auto* _lhs, const auto* _rhs) {
+        return _lhs->overhead > _rhs->overhead;
+    });
+
+    _os << "# overhead per call: " << profile_feedback_overhead
+        << " nsec, budget: " << 100.0 * profile_feedback_budget
+        << "% of inclusive time, hot: " << 100.0 * profile_feedback_hot
+        << "% of total time\n";
+    _os << std::setw(12) << "decision"
+        << " " << std::setw(6) << "found"
+        << " " << std::setw(14) << "calls"
+        << " " << std::setw(16) << "inclusive (ns)"
+        << " " << std::setw(16) << "overhead (ns)"
+        << "  " << std::left << std::setw(40) << "reason" << " function\n"
+        << std::right;
+    for(const auto* itr : _data)
+    {
+        _os << std::setw(12) << _decision_str(itr->decision) << " " << std::setw(6)
+            << ((_found.count(itr->name) > 0) ? "yes" : "no") << " " << std::setw(14)
+            << itr->calls << " " << std::setw(16) << std::fixed << std::setprecision(0)
+            << itr->inclusive << " " << std::setw(16) << itr->overhead << "  "
+            << std::left << std::setw(40) << (itr->reason.empty() ? "-" : itr->reason)
+            << " " << itr->name << "\n"
+            << std::right;
+    }
+}
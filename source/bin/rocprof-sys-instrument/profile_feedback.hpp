@@ -0,0 +1,65 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "fwd.hpp"
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+// selection of the functions from the wall-clock profile of a previous run
+// (--profile-feedback). A function is excluded when the estimated overhead of
+// instrumenting it (calls x per-call overhead) exceeds the budget fraction of its
+// inclusive time and force-included when it is within the budget and accounts for at
+// least the "hot" fraction of the total time
+struct profile_feedback_entry
+{
+    enum decision_t : uint8_t
+    {
+        PF_NONE = 0,
+        PF_EXCLUDE,
+        PF_INCLUDE,
+    };
+
+    string_t   name      = {};
+    uint64_t   calls     = 0;
+    double     inclusive = 0.0;  // nsec
+    double     overhead  = 0.0;  // nsec
+    decision_t decision  = PF_NONE;
+    string_t   reason    = {};
+};
+
+// reads a timemory wall_clock JSON file and computes the decision for each function.
+// Returns the number of functions in the profile
+size_t
+load_profile_feedback(const string_t& _fname);
+
+// looks up the profile data of a function by its label and then by its name
+const profile_feedback_entry*
+find_profile_feedback(const string_t& _label, const string_t& _name);
+
+// writes the decision, the reason and whether the function was found in the target
+// for every function in the profile
+void
+write_profile_feedback_report(std::ostream&, const strset_t& _found);
@@ -27,8 +27,11 @@
 #include "fwd.hpp"
 #include "internal_libs.hpp"
 #include "log.hpp"
+#include "plan_cache.hpp"
+#include "profile_feedback.hpp"
 
 #include <timemory/backends/process.hpp>
+#include <timemory/components/timing/wall_clock.hpp>
 #include <timemory/config.hpp>
 #include <timemory/environment/types.hpp>
 #include <timemory/hash.hpp>
@@ -100,6 +103,7 @@ bool   loop_level_instr             = false;
 bool   instr_dynamic_callsites      = false;
 bool   instr_traps                  = false;
 bool   instr_loop_traps             = false;
+bool   enable_guard                 = false;
 bool   parse_all_modules            = false;
 size_t min_address_range            = get_default_min_address_range();  // 4096
 size_t min_loop_address_range       = get_default_min_address_range();  // 4096
@@ -111,18 +115,25 @@ bool   instr_print                  = false;
 bool   simulate                     = false;
 bool   include_uninstr              = false;
 bool   include_internal_linked_libs = false;
+size_t num_jobs                     = std::thread::hardware_concurrency();
+double profile_feedback_budget      = 0.05;
+double profile_feedback_overhead    = 250.0;
+double profile_feedback_hot         = 0.01;
 int    verbose_level   = tim::get_env<int>("ROCPROFSYS_VERBOSE_INSTRUMENT", 0);
 int    num_log_entries = tim::get_env<int>(
     "ROCPROFSYS_LOG_COUNT", tim::get_env<bool>("ROCPROFSYS_CI", false) ? 20 : 50);
-string_t main_fname     = "main";
-string_t argv0          = {};
-string_t cmdv0          = {};
-string_t prefer_library = {};
+string_t main_fname            = "main";
+string_t argv0                 = {};
+string_t cmdv0                 = {};
+string_t prefer_library        = {};
+string_t profile_feedback_file = {};
 //
 //  global variables
 //
 patch_pointer_t  bpatch                        = {};
+std::mutex       dyninst_mutex                 = {};
 call_expr_t*     terminate_expr                = nullptr;
+variable_expr_t* trace_guard                   = nullptr;
 snippet_vec_t    init_names                    = {};
 snippet_vec_t    fini_names                    = {};
 fmodset_t        available_module_functions    = {};
@@ -142,6 +153,7 @@ regexvec_t       func_internal_include         = {};
 regexvec_t       file_internal_include         = {};
 regexvec_t       instruction_exclude           = {};
 CodeCoverageMode coverage_mode                 = CODECOV_NONE;
+LoopMode         loop_mode                     = LOOP_TRACE;
 
 symtab_data_s                 symtab_data        = {};
 std::set<symbol_linkage_t>    enabled_linkage    = { SL_GLOBAL, SL_LOCAL, SL_UNIQUE };
@@ -186,6 +198,7 @@ string_t                                   print_available      = {};
 string_t                                   print_overlapping    = {};
 strset_t                                   print_formats        = { "txt", "json" };
 std::string                                modfunc_dump_dir     = {};
+std::string                                plan_cache_dir       = {};
 auto regex_opts = std::regex_constants::egrep | std::regex_constants::optimize;
 
 std::string
@@ -721,6 +734,68 @@ main(int argc, char** argv)
                 fixed_module_functions.at(itr.second) = !_empty;
             }
         });
+    parser
+        .add_argument({ "--profile-feedback" },
+                      "timemory wall_clock JSON file of a previous run of the "
+                      "instrumented target. Functions whose estimated instrumentation "
+                      "overhead (calls x --profile-feedback-overhead) exceeds "
+                      "--profile-feedback-budget of their inclusive time are excluded "
+                      "and functions within the budget which account for at least "
+                      "--profile-feedback-hot of the total time are always included")
+        .count(1)
+        .dtype("filepath")
+        .action([](parser_t& p) {
+            profile_feedback_file = p.get<string_t>("profile-feedback");
+        });
+    parser
+        .add_argument({ "--profile-feedback-budget" },
+                      "Maximum instrumentation overhead of a function as a fraction of "
+                      "its inclusive time (see --profile-feedback)")
+        .count(1)
+        .dtype("double")
+        .action([](parser_t& p) {
+            profile_feedback_budget = p.get<double>("profile-feedback-budget");
+        });
+    parser
+        .add_argument({ "--profile-feedback-overhead" },
+                      "Estimated overhead in nanoseconds of the instrumentation of one "
+                      "call of a function (see --profile-feedback)")
+        .count(1)
+        .dtype("double")
+        .action([](parser_t& p) {
+            profile_feedback_overhead = p.get<double>("profile-feedback-overhead");
+        });
+    parser
+        .add_argument({ "--profile-feedback-hot" },
+                      "Minimum fraction of the total time (the summed time of the root "
+                      "call-paths of every thread and rank) of a function for it to be "
+                      "always included (see --profile-feedback)")
+        .count(1)
+        .dtype("double")
+        .action([](parser_t& p) {
+            profile_feedback_hot = p.get<double>("profile-feedback-hot");
+        });
+    parser
+        .add_argument({ "--plan-cache" },
+                      "Save the outcome of the function analysis to this directory and "
+                      "reuse it (skipping the analysis) when the build-id of the target, "
+                      "the options and the rocprof-sys version are unchanged. Defaults "
+                      "to ${XDG_CACHE_HOME:-${HOME}/.cache}/rocprof-sys/instrument when "
+                      "no directory is provided. Can also be enabled via "
+                      "ROCPROFSYS_INSTRUMENT_PLAN_CACHE=<dir>")
+        .min_count(0)
+        .max_count(1)
+        .dtype("filepath")
+        .action([](parser_t& p) {
+            plan_cache_dir = p.get<string_t>("plan-cache");
+            if(plan_cache_dir.empty())
+            {
+                auto _home     = tim::get_env<std::string>("HOME", "/tmp");
+                auto _cache    = tim::get_env<std::string>("XDG_CACHE_HOME",
+                                                           JOIN('/', _home, ".cache"));
+                plan_cache_dir = JOIN('/', _cache, "rocprof-sys", "instrument");
+            }
+        });
     parser
         .add_argument({ "--init-functions" },
                       "Initialization function(s) for supplemental instrumentation "
@@ -920,6 +995,26 @@ main(int argc, char** argv)
         .dtype("boolean")
         .max_count(1)
         .action([](parser_t& p) { loop_level_instr = p.get<bool>("instrument-loops"); });
+    parser
+        .add_argument({ "--loop-mode" },
+                      "Instrumentation of the loops when --instrument-loops is enabled. "
+                      "'trace' inserts the push/pop calls at each loop entry and exit. "
+                      "'entries' only increments a 64-bit counter in the instrumented "
+                      "binary at each loop entry (no call into the library) and "
+                      "'iterations' additionally counts the loop iterations. The counts "
+                      "are reported per function in the loop-counts output at "
+                      "finalization")
+        .count(1)
+        .choices({ "trace", "entries", "iterations" })
+        .action([](parser_t& p) {
+            auto _v = p.get<std::string>("loop-mode");
+            if(_v == "entries")
+                loop_mode = LOOP_ENTRIES;
+            else if(_v == "iterations")
+                loop_mode = LOOP_ITERATIONS;
+            else
+                loop_mode = LOOP_TRACE;
+        });
     parser
         .add_argument({ "-i", "--min-instructions" },
                       "If the number of instructions in a function is less than this "
@@ -1003,6 +1098,23 @@ main(int argc, char** argv)
         .dtype("boolean")
         .set_default(instr_loop_traps)
         .action([](parser_t& p) { instr_loop_traps = p.get<bool>("loop-traps"); });
+    parser
+        .add_argument(
+            { "--enable-guard" },
+            "Branch around the instrumentation calls of functions and loops when "
+            "collection is inactive or was disabled via rocprofsys_user_stop_trace. The "
+            "guard is a flag in the instrumented binary which is updated by "
+            "librocprof-sys-dl so disabled instrumentation does not call into the "
+            "library. Only the entry calls are guarded: the exit calls always reach "
+            "librocprof-sys-dl, which drops an exit whose entry was skipped, so the "
+            "functions and loops in progress when the flag changes stay balanced. Note: "
+            "the flag is process-wide, so rocprofsys_user_stop_trace pauses the "
+            "instrumentation of every thread (not only the calling thread) until "
+            "rocprofsys_user_start_trace")
+        .max_count(1)
+        .dtype("boolean")
+        .set_default(enable_guard)
+        .action([](parser_t& p) { enable_guard = p.get<bool>("enable-guard"); });
     parser
         .add_argument(
             { "--allow-overlapping" },
@@ -1039,6 +1151,16 @@ main(int argc, char** argv)
         .count(1)
         .dtype("int")
         .action([](parser_t& p) { batch_size = p.get<size_t>("batch-size"); });
+    parser
+        .add_argument({ "-j", "--jobs" },
+                      "Number of threads used to analyze the functions (decoding "
+                      "their instructions) and to evaluate their instrumentation "
+                      "constraints. The BPatch queries are still serialized. "
+                      "Defaults to the number of hardware threads")
+        .count(1)
+        .dtype("int")
+        .action(
+            [](parser_t& p) { num_jobs = std::max<size_t>(p.get<size_t>("jobs"), 1); });
     parser.add_argument({ "--dyninst-rt" }, "Path(s) to the dyninstAPI_RT library")
         .dtype("filepath")
         .min_count(1)
@@ -1264,13 +1386,20 @@ main(int argc, char** argv)
     //----------------------------------------------------------------------------------//
     //
     {
+        //  the expressions of each filter, combined into a single regex below
+        auto _regex_exprs = std::map<regexvec_t*, strvec_t>{};
+
         //  Helper function for adding regex expressions
-        auto add_regex = [](auto& regex_array, const string_t& regex_expr) {
+        auto add_regex = [&_regex_exprs](auto& regex_array, const string_t& regex_expr) {
             ROCPROFSYS_ADD_DETAILED_LOG_ENTRY("", "Adding regular expression \"",
                                               regex_expr, "\" to regex_array@",
                                               &regex_array);
             if(!regex_expr.empty())
+            {
+                // constructed individually so that an invalid expression is reported
                 regex_array.emplace_back(std::regex(regex_expr, regex_opts));
+                _regex_exprs[&regex_array].emplace_back(regex_expr);
+            }
         };
 
         add_regex(func_include, tim::get_env<string_t>("ROCPROFSYS_REGEX_INCLUDE", ""));
@@ -1314,8 +1443,25 @@ main(int argc, char** argv)
         _parse_regex_option("module-restrict", file_restrict);
         _parse_regex_option("internal-module-include", file_internal_include);
         _parse_regex_option("instruction-exclude", instruction_exclude);
+
+        //  every function is checked against every filter so the expressions of each
+        //  filter are compiled into one alternation, i.e. one search per name
+        //  regardless of the number of expressions
+        for(auto& itr : _regex_exprs)
+        {
+            if(itr.second.size() < 2) continue;
+            auto _expr = std::string{};
+            for(const auto& eitr : itr.second)
+                _expr += JOIN("", (_expr.empty()) ? "" : "|", "(", eitr, ")");
+            ROCPROFSYS_ADD_LOG_ENTRY("Combined", itr.second.size(),
+                                     "regular expressions of regex_array@", itr.first,
+                                     "into", _expr);
+            *itr.first = regexvec_t{ std::regex(_expr, regex_opts) };
+        }
     }
 
+    if(!profile_feedback_file.empty()) load_profile_feedback(profile_feedback_file);
+
     //----------------------------------------------------------------------------------//
     //
     //                              DYNINST OPTIONS
@@ -1461,7 +1607,72 @@ main(int argc, char** argv)
     std::set<module_t*>        modules       = {};
     std::set<procedure_t*>     functions     = {};
 
-    if(app_modules) process_modules(*app_modules);
+    //----------------------------------------------------------------------------------//
+    //
+    //  Look up a saved instrumentation plan. The plan is not used when module functions
+    //  were loaded via --load-instr
+    //
+    //----------------------------------------------------------------------------------//
+
+    if(plan_cache_dir.empty())
+        plan_cache_dir =
+            tim::get_env<std::string>("ROCPROFSYS_INSTRUMENT_PLAN_CACHE", "");
+
+    auto _plan        = instrumentation_plan{};
+    auto _plan_fname  = std::string{};
+    bool _plan_loaded = false;
+    bool _plan_fixed  = false;
+    for(const auto& itr : fixed_module_functions)
+        _plan_fixed = (_plan_fixed || itr.second);
+
+    if(!plan_cache_dir.empty() && !_plan_fixed)
+    {
+        auto _target = (!mutname.empty()) ? mutname : JOIN("", "/proc/", _pid, "/exe");
+        _target      = get_realpath(_target);
+
+        // the module names are included since the shared libraries found at runtime
+        // may differ between launches
+        auto _options = std::vector<std::string>{};
+        for(int i = 1; i < _argc; ++i)
+            _options.emplace_back(_argv[i]);
+        for(const auto* itr : { "ROCPROFSYS_REGEX_", "ROCPROFSYS_DEFAULT_MIN_" })
+        {
+            for(char** eitr = environ; eitr && *eitr; ++eitr)
+                if(std::string_view{ *eitr }.find(itr) == 0) _options.emplace_back(*eitr);
+        }
+        if(app_modules)
+        {
+            for(auto* itr : *app_modules)
+                _options.emplace_back(get_name(itr));
+        }
+        // the functions are identified by their offset within their object so a
+        // rebuilt library must invalidate the plan
+        {
+            auto _objs = std::vector<object_t*>{};
+            app_image->getObjects(_objs);
+            for(auto* itr : _objs)
+            {
+                auto _path = itr->pathName();
+                if(_path.empty() || get_realpath(_path) == _target) continue;
+                _options.emplace_back(JOIN('=', _path, get_build_id(_path)));
+            }
+        }
+        if(!profile_feedback_file.empty())
+            _options.emplace_back(get_build_id(profile_feedback_file));
+
+        _plan.build_id = get_build_id(_target);
+        _plan.options  = std::to_string(std::hash<std::string>{}(JOIN('\n', _options)));
+        _plan.version  = JOIN('-', ROCPROFSYS_VERSION_STRING, ROCPROFSYS_GIT_REVISION);
+        _plan_fname    = _plan.get_filename(plan_cache_dir, _target);
+        _plan_loaded   = _plan.load(_plan_fname);
+
+        verbprintf(1, "%s instrumentation plan '%s' (build-id: %s)\n",
+                   (_plan_loaded) ? "Using" : "No valid", _plan_fname.c_str(),
+                   _plan.build_id.c_str());
+    }
+
+    // the symbol tables are only needed for the analysis
+    if(app_modules && !_plan_loaded) process_modules(*app_modules);
 
     //----------------------------------------------------------------------------------//
     //
@@ -1494,6 +1705,28 @@ main(int argc, char** argv)
         }
     };
 
+    // the module_function objects (CFG, loops and instructions of each function) are
+    // constructed concurrently and inserted afterwards in the original order
+    auto _add_module_functions = [&](const auto& _candidates) {
+        auto _modfns = std::vector<module_function>(_candidates.size());
+        parallel_for(_candidates.size(), [&](size_t i) {
+            _modfns.at(i) =
+                module_function{ _candidates.at(i).first, _candidates.at(i).second };
+        });
+
+        for(size_t i = 0; i < _modfns.size(); ++i)
+        {
+            const auto& _modfn = _modfns.at(i);
+            module_names.insert(_modfn.module_name);
+            _insert_module_function(available_module_functions, _modfn);
+            if(!_plan_loaded)
+                _add_overlapping(_candidates.at(i).first, _candidates.at(i).second);
+        }
+    };
+
+    auto _wc_build = tim::component::wall_clock{};
+    _wc_build.start();
+
     if(app_functions && !app_functions->empty())
     {
         for(auto* itr : *app_functions)
@@ -1506,17 +1739,18 @@ main(int argc, char** argv)
         }
         verbprintf(2, "Adding %zu procedures found in the app image...\n",
                    functions.size());
+        auto _candidates = std::vector<std::pair<module_t*, procedure_t*>>{};
         for(auto* itr : functions)
         {
             if(itr->isInstrumentable() || (simulate && include_uninstr))
             {
-                module_t* mod    = itr->getModule();
-                auto      _modfn = module_function{ mod, itr };
-                module_names.insert(_modfn.module_name);
-                _insert_module_function(available_module_functions, _modfn);
-                _add_overlapping(mod, itr);
+                module_t* mod = itr->getModule();
+                // with a saved plan, only the selected functions are parsed
+                if(_plan_loaded && !_plan.contains(mod, itr)) continue;
+                _candidates.emplace_back(mod, itr);
             }
         }
+        _add_module_functions(_candidates);
     }
     else
     {
@@ -1540,16 +1774,16 @@ main(int argc, char** argv)
             {
                 verbprintf(2, "Processing %zu procedures found in the %s module...\n",
                            procedures->size(), get_name(itr).data());
+                auto _candidates = std::vector<std::pair<module_t*, procedure_t*>>{};
                 for(auto* pitr : *procedures)
                 {
                     if(!pitr->isInstrumentable() && !simulate && !include_uninstr)
                         continue;
                     functions.emplace(pitr);
-                    auto _modfn = module_function{ itr, pitr };
-                    module_names.insert(_modfn.module_name);
-                    _insert_module_function(available_module_functions, _modfn);
-                    _add_overlapping(itr, pitr);
+                    if(_plan_loaded && !_plan.contains(itr, pitr)) continue;
+                    _candidates.emplace_back(itr, pitr);
                 }
+                _add_module_functions(_candidates);
             }
         }
     }
@@ -1558,9 +1792,13 @@ main(int argc, char** argv)
         verbprintf(0, "Warning! No modules in application...\n");
     }
 
+    _wc_build.stop();
+
     verbprintf(1, "\n");
     verbprintf(1, "Found %zu functions in %zu modules in instrumentation target\n",
                functions.size(), modules.size());
+    verbprintf(1, "Analyzed the functions in the instrumentation target in %.3f %s\n",
+               _wc_build.get(), _wc_build.display_unit().c_str());
 
     if(debug_print || verbose_level > 2)
     {
@@ -1724,8 +1962,8 @@ main(int argc, char** argv)
     auto* mpi_func       = find_function(app_image, "rocprofsys_set_mpi");
     auto* entr_trace     = find_function(app_image, "rocprofsys_push_trace");
     auto* exit_trace     = find_function(app_image, "rocprofsys_pop_trace");
-    auto* reg_src_func   = find_function(app_image, "rocprofsys_register_source");
-    auto* reg_cov_func   = find_function(app_image, "rocprofsys_register_coverage");
+    auto* reg_src_func   = find_function(app_image, "rocprofsys_register_source_index");
+    auto* reg_cov_func   = find_function(app_image, "rocprofsys_register_coverage_index");
     auto* set_instr_func = find_function(app_image, "rocprofsys_set_instrumented");
 
     if(!main_func && main_fname == "main") main_func = find_function(app_image, "_main");
@@ -1843,14 +2081,15 @@ main(int argc, char** argv)
 
     using pair_t = std::pair<procedure_t*, string_t>;
 
-    for(const auto& itr : { pair_t{ entr_trace, "rocprofsys_push_trace" },
-                            pair_t{ exit_trace, "rocprofsys_pop_trace" },
-                            pair_t{ init_func, "rocprofsys_init" },
-                            pair_t{ fini_func, "rocprofsys_finalize" },
-                            pair_t{ env_func, "rocprofsys_set_env" },
-                            pair_t{ set_instr_func, "rocprofsys_set_instrumented" },
-                            pair_t{ reg_src_func, "rocprofsys_register_source" },
-                            pair_t{ reg_cov_func, "rocprofsys_register_coverage" } })
+    for(const auto& itr :
+        { pair_t{ entr_trace, "rocprofsys_push_trace" },
+          pair_t{ exit_trace, "rocprofsys_pop_trace" },
+          pair_t{ init_func, "rocprofsys_init" },
+          pair_t{ fini_func, "rocprofsys_finalize" },
+          pair_t{ env_func, "rocprofsys_set_env" },
+          pair_t{ set_instr_func, "rocprofsys_set_instrumented" },
+          pair_t{ reg_src_func, "rocprofsys_register_source_index" },
+          pair_t{ reg_cov_func, "rocprofsys_register_coverage_index" } })
     {
         if(!itr.first)
         {
@@ -1859,6 +2098,33 @@ main(int argc, char** argv)
         }
     }
 
+    //----------------------------------------------------------------------------------//
+    //
+    //  Allocate the enable flag which guards the function and loop instrumentation.
+    //  librocprof-sys-dl updates the flag after it is registered in the init sequence
+    //
+    //----------------------------------------------------------------------------------//
+
+    auto* reg_guard_func =
+        (enable_guard) ? find_function(app_image, "rocprofsys_register_trace_guard")
+                       : nullptr;
+
+    if(enable_guard && !reg_guard_func)
+    {
+        verbprintf(0, "Warning! 'rocprofsys_register_trace_guard' was not found. The "
+                      "instrumentation will not be guarded\n");
+    }
+    else if(reg_guard_func)
+    {
+        auto* _type = app_image->findType("int");
+        trace_guard = (_type) ? addr_space->malloc(*_type) : nullptr;
+        if(!trace_guard)
+        {
+            verbprintf(0, "Warning! Unable to allocate the instrumentation guard. The "
+                          "instrumentation will not be guarded\n");
+        }
+    }
+
     //----------------------------------------------------------------------------------//
     //
     //  Find the entry/exit point of either the main (if executable) or the _init
@@ -1877,6 +2143,27 @@ main(int argc, char** argv)
         verbprintf(2, "Done\n");
     }
 
+    // the loop counters are registered from the entry of main or, when attached to a
+    // running process (main has already been entered), by executing the registration
+    // calls once along with the initial snippets
+    auto  _use_loop_counters = (loop_level_instr && loop_mode != LOOP_TRACE);
+    auto* reg_loop_func =
+        (_use_loop_counters)
+            ? find_function(app_image, "rocprofsys_register_loop_counters")
+            : nullptr;
+    auto* reg_loop_points = (is_attached) ? nullptr : main_entr_points;
+    auto  reg_loop_calls  = std::vector<call_expr_pointer_t>{};
+
+    if(_use_loop_counters && (!reg_loop_func || (!main_entr_points && !is_attached)))
+    {
+        verbprintf(0, "Warning! The loop counters cannot be registered (%s). Using the "
+                      "trace loop mode\n",
+                   (reg_loop_func) ? "no main function"
+                                   : "rocprofsys_register_loop_counters not found");
+        loop_mode     = LOOP_TRACE;
+        reg_loop_func = nullptr;
+    }
+
     //----------------------------------------------------------------------------------//
     //
     //  Create the call arguments for the initialization and finalization routines
@@ -1910,6 +2197,12 @@ main(int argc, char** argv)
     auto umpi_call_args = rocprofsys_call_expr(use_mpi, is_attached);
     auto none_call_args = rocprofsys_call_expr();
     auto set_instr_args = rocprofsys_call_expr(instr_mode_v_int);
+    auto guard_args     = rocprofsys_call_expr();
+
+    // the guard is registered by its address
+    if(trace_guard)
+        guard_args = rocprofsys_call_expr(
+            std::make_shared<snippet_t>(arith_expr_t{ BPatch_addr, *trace_guard }));
 
     verbprintf(2, "Done\n");
     verbprintf(2, "Getting call snippets... ");
@@ -1919,6 +2212,8 @@ main(int argc, char** argv)
     auto umpi_call      = umpi_call_args.get(mpi_func);
     auto set_instr_call = set_instr_args.get(set_instr_func);
     auto main_beg_call  = main_call_args.get(entr_trace);
+    auto guard_call =
+        (trace_guard) ? guard_args.get(reg_guard_func) : call_expr_pointer_t{};
 
     verbprintf(2, "Done\n");
 
@@ -1996,6 +2291,7 @@ main(int argc, char** argv)
         }
     }
 
+    if(guard_call) init_names.emplace_back(guard_call.get());
     if(umpi_call) init_names.emplace_back(umpi_call.get());
     if(!binary_rewrite && init_call) init_names.emplace_back(init_call.get());
     if(is_attached && main_func && main_beg_call)
@@ -2011,44 +2307,107 @@ main(int argc, char** argv)
     //
     //----------------------------------------------------------------------------------//
 
-    if(instr_mode != "sampling")
+    // the constraints of each function are evaluated concurrently (the BPatch queries
+    // within them are serialized via dyninst_mutex) and the results are inserted into
+    // the containers afterwards in the original order. With a saved plan, the results
+    // and the messages explaining them are taken from the plan instead
     {
+        auto _wc = tim::component::wall_clock{};
+        _wc.start();
+
+        auto _funcs = std::vector<const module_function*>{};
+        _funcs.reserve(available_module_functions.size());
         for(const auto& itr : available_module_functions)
+            _funcs.emplace_back(&itr);
+
+        auto _results = std::vector<uint8_t>(_funcs.size(), 0);
+        if(_plan_loaded)
         {
-            if(itr.should_instrument())
+            for(size_t i = 0; i < _funcs.size(); ++i)
             {
-                _insert_module_function(instrumented_module_functions, itr);
+                const auto* _entry = _plan.find(*_funcs.at(i));
+                if(!_entry) continue;
+                _results.at(i)         = _entry->flags;
+                _funcs.at(i)->messages = _entry->messages;
             }
+        }
+        else
+        {
+            parallel_for(_funcs.size(), [&](size_t i) {
+                const auto* itr = _funcs.at(i);
+                auto&       _v  = _results.at(i);
+                if(instr_mode != "sampling" && itr->should_instrument())
+                    _v |= CR_INSTRUMENT;
+                if(coverage_mode != CODECOV_NONE && itr->should_coverage_instrument())
+                    _v |= CR_COVERAGE;
+                if(itr->is_overlapping()) _v |= CR_OVERLAPPING;
+            });
+        }
+
+        // in sampling mode, we instrument either main or add init and fini callbacks
+        if(instr_mode == "sampling" && main_func)
+            _insert_module_function(instrumented_module_functions,
+                                    module_function{ main_func->getModule(), main_func });
+
+        for(size_t i = 0; i < _funcs.size(); ++i)
+        {
+            const auto& itr = *_funcs.at(i);
+            auto        _v  = _results.at(i);
+            if((_v & CR_INSTRUMENT) != 0)
+                _insert_module_function(instrumented_module_functions, itr);
             else
-            {
                 _insert_module_function(excluded_module_functions, itr);
+            if((_v & CR_COVERAGE) != 0)
+                _insert_module_function(coverage_module_functions, itr);
+            if((_v & CR_OVERLAPPING) != 0)
+                _insert_module_function(overlapping_module_functions, itr);
+        }
+
+        _wc.stop();
+        verbprintf(1,
+                   "Evaluated the constraints of %zu functions in %.3f %s (jobs: %zu)\n",
+                   _funcs.size(), _wc.get(), _wc.display_unit().c_str(), num_jobs);
+
+        if(!plan_cache_dir.empty() && !_plan_fixed && !_plan_loaded)
+        {
+            for(size_t i = 0; i < _funcs.size(); ++i)
+                _plan.insert(*_funcs.at(i), _results.at(i));
+
+            if(_plan.save(_plan_fname))
+            {
+                verbprintf(1, "Saved the instrumentation plan of %zu functions to '%s'\n",
+                           _plan.entries.size(), _plan_fname.c_str());
             }
-            if(coverage_mode != CODECOV_NONE)
+            else
             {
-                if(itr.should_coverage_instrument())
-                    _insert_module_function(coverage_module_functions, itr);
+                verbprintf(0, "Warning! Unable to save the instrumentation plan '%s'\n",
+                           _plan_fname.c_str());
             }
-            if(itr.is_overlapping())
-                _insert_module_function(overlapping_module_functions, itr);
         }
     }
-    else
-    {
-        // in sampling mode, we instrument either main or add init and fini callbacks
-        if(main_func)
-            _insert_module_function(instrumented_module_functions,
-                                    module_function{ main_func->getModule(), main_func });
 
+    if(!profile_feedback_file.empty())
+    {
+        auto _found = strset_t{};
         for(const auto& itr : available_module_functions)
         {
-            _insert_module_function(excluded_module_functions, itr);
-            if(coverage_mode != CODECOV_NONE)
-            {
-                if(itr.should_coverage_instrument())
-                    _insert_module_function(coverage_module_functions, itr);
-            }
-            if(itr.is_overlapping())
-                _insert_module_function(overlapping_module_functions, itr);
+            _found.emplace(itr.signature.get());
+            _found.emplace(itr.function_name);
+        }
+
+        auto _cfg         = tim::settings::compose_filename_config{};
+        _cfg.subdirectory = "instrumentation";
+        auto _oname =
+            tim::settings::compose_output_filename("profile-feedback", "txt", _cfg);
+        std::ofstream _ofs{};
+        if(tim::filepath::open(_ofs, _oname))
+        {
+            verbprintf(1, "Outputting '%s'...\n", _oname.c_str());
+            write_profile_feedback_report(_ofs, _found);
+        }
+        else
+        {
+            verbprintf(0, "Warning! Unable to open '%s' for output\n", _oname.c_str());
         }
     }
 
@@ -2148,6 +2507,9 @@ main(int argc, char** argv)
         addr_space->beginInsertionSet();
     }
 
+    auto _wc_insert = tim::component::wall_clock{};
+    _wc_insert.start();
+
     verbprintf(2, "Beginning instrumentation loop...\n");
     auto _report_info = [](int _lvl, const string_t& _action, const string_t& _type,
                            const string_t& _reason, const string_t& _name,
@@ -2172,6 +2534,13 @@ main(int argc, char** argv)
         {
             if(itr.function == main_func) continue;
             auto _count = itr(addr_space, entr_trace, exit_trace);
+            if(reg_loop_func)
+            {
+                auto _calls = itr.register_loop_counters(addr_space, reg_loop_func,
+                                                         reg_loop_points);
+                for(auto& citr : _calls)
+                    reg_loop_calls.emplace_back(std::move(citr));
+            }
             _pass_info[itr.module_name].first += _count.first;
             _pass_info[itr.module_name].second += _count.second;
 
@@ -2242,6 +2611,10 @@ main(int argc, char** argv)
             }
         }
     }
+
+    _wc_insert.stop();
+    verbprintf(1, "Inserted the instrumentation in %.3f %s\n", _wc_insert.get(),
+               _wc_insert.display_unit().c_str());
     verbprintf(1, "\n");
 
     if(app_thread)
@@ -2405,8 +2778,13 @@ main(int argc, char** argv)
             tim::makedir(outdir);
         }
 
+        auto _wc_write = tim::component::wall_clock{};
+        _wc_write.start();
         bool success = app_binary->writeFile(outfile.c_str());
         code         = (success) ? EXIT_SUCCESS : EXIT_FAILURE;
+        _wc_write.stop();
+        verbprintf(1, "Wrote the instrumented binary in %.3f %s\n", _wc_write.get(),
+                   _wc_write.display_unit().c_str());
         if(success)
         {
             verbprintf(0, "\n");
@@ -2513,6 +2891,8 @@ main(int argc, char** argv)
             verbprintf(1, "Executing initial snippets...\n");
             for(auto* itr : init_names)
                 app_thread->oneTimeCode(*itr);
+            for(const auto& itr : reg_loop_calls)
+                app_thread->oneTimeCode(*itr);
 
             app_thread->continueExecution();
             while(!app_thread->isTerminated())
@@ -2554,6 +2934,8 @@ bool
 query_instr(procedure_t* funcToInstr, procedure_loc_t traceLoc, flow_graph_t* cfGraph,
             basic_loop_t* loopToInstrument, bool allow_traps)
 {
+    auto _lk = std::unique_lock<std::mutex>{ dyninst_mutex };
+
     module_t* module = funcToInstr->getModule();
     if(!module) return false;
 
@@ -2590,32 +2972,36 @@ std::tuple<size_t, size_t>
 query_instr(procedure_t* funcToInstr, procedure_loc_t traceLoc, flow_graph_t* cfGraph,
             basic_loop_t* loopToInstrument)
 {
-    module_t* module = funcToInstr->getModule();
-    if(!module) return { 0, 0 };
+    auto _loop_loc = traceLoc;
+    auto _is_loop  = (cfGraph && loopToInstrument) ||
+                    (traceLoc == BPatch_locLoopEntry || traceLoc == BPatch_locLoopExit);
 
-    if(!cfGraph) cfGraph = funcToInstr->getCFG();
-
-    std::vector<point_t*>* _points = nullptr;
-
-    if((cfGraph && loopToInstrument) ||
-       (traceLoc == BPatch_locLoopEntry || traceLoc == BPatch_locLoopExit))
+    if(_is_loop)
     {
-        if(!cfGraph) throw std::runtime_error("No control flow graph");
         if(!loopToInstrument) throw std::runtime_error("No loop to instrument");
 
         if(traceLoc == BPatch_entry || traceLoc == BPatch_locLoopEntry)
-        {
-            _points = cfGraph->findLoopInstPoints(BPatch_locLoopEntry, loopToInstrument);
-        }
+            _loop_loc = BPatch_locLoopEntry;
         else if(traceLoc == BPatch_exit || traceLoc == BPatch_locLoopExit)
-        {
-            _points = cfGraph->findLoopInstPoints(BPatch_locLoopExit, loopToInstrument);
-        }
+            _loop_loc = BPatch_locLoopExit;
         else
-        {
             throw std::runtime_error("unsupported trace location :: " +
                                      std::to_string(traceLoc));
-        }
+    }
+
+    // only the BPatch queries are serialized
+    auto _lk = std::unique_lock<std::mutex>{ dyninst_mutex };
+
+    module_t* module = funcToInstr->getModule();
+    if(!module) return { 0, 0 };
+
+    std::vector<point_t*>* _points = nullptr;
+
+    if(_is_loop)
+    {
+        if(!cfGraph) cfGraph = funcToInstr->getCFG();
+        if(!cfGraph) throw std::runtime_error("No control flow graph");
+        _points = cfGraph->findLoopInstPoints(_loop_loc, loopToInstrument);
     }
     else
     {
@@ -31,11 +31,17 @@
 #include <timemory/utility/filepath.hpp>
 #include <timemory/utility/join.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <dlfcn.h>
+#include <exception>
 #include <ios>
+#include <mutex>
 #include <string>
 #include <sys/stat.h>
+#include <thread>
 #include <unistd.h>
+#include <vector>
 
 //======================================================================================//
 
@@ -72,6 +78,14 @@ get_snippet(const Tp& arg)
 //
 //======================================================================================//
 //
+inline snippet_pointer_t
+get_snippet(snippet_pointer_t arg)
+{
+    return arg;
+}
+//
+//======================================================================================//
+//
 template <typename... Args>
 snippet_pointer_vec_t
 get_snippets(Args&&... args)
@@ -143,6 +157,21 @@ private:
 //
 //======================================================================================//
 //
+// wraps the call in a branch on the enable flag (--enable-guard) so that the call into
+// librocprof-sys-dl is skipped while collection is inactive or disabled. Only applied
+// to the push calls: librocprof-sys-dl drops the pops whose push was skipped, so a
+// region stays balanced when the flag changes while it is in progress
+//
+inline snippet_pointer_t
+get_guarded_snippet(const call_expr_pointer_t& _call)
+{
+    if(!_call || !trace_guard) return _call;
+    return std::make_shared<if_expr_t>(
+        bool_expr_t{ BPatch_ne, *trace_guard, const_expr_t{ 0 } }, *_call);
+}
+//
+//======================================================================================//
+//
 static inline bool
 rocprofsys_get_is_executable(std::string_view _cmd, bool _default_v)
 {
@@ -372,6 +401,57 @@ rocprofsys_get_link_map(const char* _lib, const std::string& _exclude_linked_by
                         std::vector<int>&& _open_modes = { (RTLD_LAZY | RTLD_NOLOAD) });
 //
 //======================================================================================//
+// parallel_for -- invokes _func(i) for i in [0, _n) on up to num_jobs threads. Indices
+// are handed out in chunks so that cheap and expensive functions are load-balanced.
+// The first exception thrown by _func is rethrown on the calling thread
+//
+template <typename FuncT>
+void
+parallel_for(size_t _n, FuncT&& _func)
+{
+    constexpr size_t chunk_size = 64;
+
+    auto _njobs = std::min<size_t>(num_jobs, (_n + chunk_size - 1) / chunk_size);
+    if(_njobs <= 1)
+    {
+        for(size_t i = 0; i < _n; ++i)
+            _func(i);
+        return;
+    }
+
+    auto _idx    = std::atomic<size_t>{ 0 };
+    auto _error  = std::exception_ptr{};
+    auto _mutex  = std::mutex{};
+    auto _worker = [&]() {
+        try
+        {
+            for(size_t _beg = _idx.fetch_add(chunk_size); _beg < _n;
+                _beg        = _idx.fetch_add(chunk_size))
+            {
+                auto _end = std::min<size_t>(_beg + chunk_size, _n);
+                for(size_t i = _beg; i < _end; ++i)
+                    _func(i);
+            }
+        } catch(...)
+        {
+            auto _lk = std::unique_lock<std::mutex>{ _mutex };
+            if(!_error) _error = std::current_exception();
+            _idx.store(_n);
+        }
+    };
+
+    auto _threads = std::vector<std::thread>{};
+    _threads.reserve(_njobs - 1);
+    for(size_t i = 1; i < _njobs; ++i)
+        _threads.emplace_back(_worker);
+    _worker();
+    for(auto& itr : _threads)
+        itr.join();
+
+    if(_error) std::rethrow_exception(_error);
+}
+//
+//======================================================================================//
 // insert_instr -- insert instrumentation into a function
 //
 template <typename Tp>
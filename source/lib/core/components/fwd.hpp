@@ -72,6 +72,8 @@ struct backtrace_wall_clock
 {};
 struct backtrace_cpu_clock
 {};
+struct backtrace_offcpu_clock
+{};
 struct backtrace_fraction
 {};
 struct backtrace_gpu_busy
@@ -82,13 +84,14 @@ struct backtrace_gpu_power
 {};
 struct backtrace_gpu_memory
 {};
-using sampling_wall_clock = data_tracker<double, backtrace_wall_clock>;
-using sampling_cpu_clock  = data_tracker<double, backtrace_cpu_clock>;
-using sampling_percent    = data_tracker<double, backtrace_fraction>;
-using sampling_gpu_busy   = data_tracker<double, backtrace_gpu_busy>;
-using sampling_gpu_temp   = data_tracker<double, backtrace_gpu_temp>;
-using sampling_gpu_power  = data_tracker<double, backtrace_gpu_power>;
-using sampling_gpu_memory = data_tracker<double, backtrace_gpu_memory>;
+using sampling_wall_clock   = data_tracker<double, backtrace_wall_clock>;
+using sampling_cpu_clock    = data_tracker<double, backtrace_cpu_clock>;
+using sampling_offcpu_clock = data_tracker<double, backtrace_offcpu_clock>;
+using sampling_percent      = data_tracker<double, backtrace_fraction>;
+using sampling_gpu_busy     = data_tracker<double, backtrace_gpu_busy>;
+using sampling_gpu_temp     = data_tracker<double, backtrace_gpu_temp>;
+using sampling_gpu_power    = data_tracker<double, backtrace_gpu_power>;
+using sampling_gpu_memory   = data_tracker<double, backtrace_gpu_memory>;
 
 template <typename ApiT, typename StartFuncT = default_functor_t,
           typename StopFuncT = default_functor_t>
@@ -121,6 +124,8 @@ ROCPROFSYS_DEFINE_CONCRETE_TRAIT(is_available, component::backtrace_metrics, fal
 ROCPROFSYS_DEFINE_CONCRETE_TRAIT(is_available, component::backtrace_timestamp, false_type)
 ROCPROFSYS_DEFINE_CONCRETE_TRAIT(is_available, component::sampling_wall_clock, false_type)
 ROCPROFSYS_DEFINE_CONCRETE_TRAIT(is_available, component::sampling_cpu_clock, false_type)
+ROCPROFSYS_DEFINE_CONCRETE_TRAIT(is_available, component::sampling_offcpu_clock,
+                                 false_type)
 ROCPROFSYS_DEFINE_CONCRETE_TRAIT(is_available, component::sampling_percent, false_type)
 #endif
 
@@ -143,6 +148,9 @@ TIMEMORY_SET_COMPONENT_API(rocprofsys::component::sampling_wall_clock,
 TIMEMORY_SET_COMPONENT_API(rocprofsys::component::sampling_cpu_clock, project::rocprofsys,
                            category::timing, os::supports_unix, category::sampling,
                            category::interrupt_sampling)
+TIMEMORY_SET_COMPONENT_API(rocprofsys::component::sampling_offcpu_clock,
+                           project::rocprofsys, category::timing, os::supports_unix,
+                           category::sampling, category::interrupt_sampling)
 TIMEMORY_SET_COMPONENT_API(rocprofsys::component::sampling_percent, project::rocprofsys,
                            category::timing, os::supports_unix, category::sampling,
                            category::interrupt_sampling)
@@ -171,6 +179,9 @@ TIMEMORY_METADATA_SPECIALIZATION(rocprofsys::component::sampling_wall_clock,
 TIMEMORY_METADATA_SPECIALIZATION(rocprofsys::component::sampling_cpu_clock,
                                  "sampling_cpu_clock", "CPU-clock timing",
                                  "Derived from statistical sampling")
+TIMEMORY_METADATA_SPECIALIZATION(rocprofsys::component::sampling_offcpu_clock,
+                                 "sampling_offcpu_clock", "Off-CPU (blocked) timing",
+                                 "Derived from real-time vs. CPU-time sampling")
 TIMEMORY_METADATA_SPECIALIZATION(rocprofsys::component::sampling_percent,
                                  "sampling_percent",
                                  "Fraction of wall-clock time spent in functions",
@@ -192,6 +203,7 @@ TIMEMORY_METADATA_SPECIALIZATION(rocprofsys::component::sampling_gpu_temp,
 // statistics type
 TIMEMORY_STATISTICS_TYPE(rocprofsys::component::sampling_wall_clock, double)
 TIMEMORY_STATISTICS_TYPE(rocprofsys::component::sampling_cpu_clock, double)
+TIMEMORY_STATISTICS_TYPE(rocprofsys::component::sampling_offcpu_clock, double)
 TIMEMORY_STATISTICS_TYPE(rocprofsys::component::sampling_gpu_busy, double)
 TIMEMORY_STATISTICS_TYPE(rocprofsys::component::sampling_gpu_temp, double)
 TIMEMORY_STATISTICS_TYPE(rocprofsys::component::sampling_gpu_power, double)
@@ -203,12 +215,16 @@ ROCPROFSYS_DEFINE_CONCRETE_TRAIT(is_timing_category, component::sampling_wall_cl
                                  true_type)
 ROCPROFSYS_DEFINE_CONCRETE_TRAIT(is_timing_category, component::sampling_cpu_clock,
                                  true_type)
+ROCPROFSYS_DEFINE_CONCRETE_TRAIT(is_timing_category, component::sampling_offcpu_clock,
+                                 true_type)
 ROCPROFSYS_DEFINE_CONCRETE_TRAIT(is_timing_category, component::sampling_percent,
                                  true_type)
 ROCPROFSYS_DEFINE_CONCRETE_TRAIT(uses_timing_units, component::sampling_wall_clock,
                                  true_type)
 ROCPROFSYS_DEFINE_CONCRETE_TRAIT(uses_timing_units, component::sampling_cpu_clock,
                                  true_type)
+ROCPROFSYS_DEFINE_CONCRETE_TRAIT(uses_timing_units, component::sampling_offcpu_clock,
+                                 true_type)
 
 // enable percent units
 ROCPROFSYS_DEFINE_CONCRETE_TRAIT(uses_percent_units, component::sampling_gpu_busy,
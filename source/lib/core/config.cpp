@@ -340,6 +340,23 @@ configure_settings(bool _init)
                               "Enable support for MPI functions", true, "mpi", "backend",
                               "parallelism");
 
+    ROCPROFSYS_CONFIG_SETTING(
+        bool, "ROCPROFSYS_MPIP_COMM_MATRIX",
+        "Aggregate the bytes and message counts of the point-to-point MPI calls per "
+        "(peer, communicator, tag) and the log2 message-size histograms of all the "
+        "wrapped MPI calls. Each rank writes comm-peers.txt and the per-rank data is "
+        "gathered at finalization into an NxN communication matrix (comm-matrix.json)",
+        false, "mpi", "io", "parallelism", "advanced");
+
+    ROCPROFSYS_CONFIG_SETTING(
+        bool, "ROCPROFSYS_MPIP_WAIT_STATE",
+        "Classify the time spent in blocking MPI calls as late-sender, late-receiver or "
+        "collective imbalance by matching the entry timestamps of the calls across "
+        "ranks at finalization. Each rank writes the per call-site breakdown to "
+        "mpi-wait-states.txt and rank 0 writes the per-rank totals to "
+        "mpi-imbalance.txt. Captures a backtrace per MPI call to identify the call-site",
+        false, "mpi", "io", "parallelism", "advanced");
+
     ROCPROFSYS_CONFIG_SETTING(
         bool, "ROCPROFSYS_USE_RCCLP",
         "Enable support for ROCm Communication Collectives Library (RCCL) Performance",
@@ -541,6 +558,33 @@ configure_settings(bool _init)
                               "cause deadlocks with MPI distributions.",
                               false, "backend", "parallelism", "gotcha", "advanced");
 
+    ROCPROFSYS_CONFIG_SETTING(
+        bool, "ROCPROFSYS_TRACE_THREAD_LOCK_CONTENTION",
+        "Only record the lock acquisitions which had to wait. Each pthread_mutex_lock, "
+        "pthread_rwlock_rdlock/wrlock and pthread_spin_lock traced via "
+        "ROCPROFSYS_TRACE_THREAD_LOCKS, ROCPROFSYS_TRACE_THREAD_RW_LOCKS, and "
+        "ROCPROFSYS_TRACE_THREAD_SPIN_LOCKS first tries the non-blocking variant and "
+        "uncontended acquisitions (and all unlocks) are not recorded. Waits are "
+        "aggregated per lock and call-site (count, total, max, p99) and written to "
+        "lock-contention.txt",
+        false, "backend", "parallelism", "gotcha", "advanced");
+
+    ROCPROFSYS_CONFIG_SETTING(
+        double, "ROCPROFSYS_TRACE_THREAD_LOCK_WAIT_THRESHOLD",
+        "Minimum wait (in microseconds) for a contended lock acquisition to be emitted "
+        "as a trace slice when ROCPROFSYS_TRACE_THREAD_LOCK_CONTENTION is enabled. "
+        "Shorter waits are only aggregated",
+        10.0, "backend", "parallelism", "gotcha", "advanced");
+
+    ROCPROFSYS_CONFIG_SETTING(
+        bool, "ROCPROFSYS_TRACE_THREAD_LOCK_HOLDERS",
+        "Attribute contended lock waits to the thread which held the lock when "
+        "ROCPROFSYS_TRACE_THREAD_LOCK_CONTENTION is enabled. The holder records the "
+        "call-site of the unlock when a waiter is present, the aggregated holder -> "
+        "waiter call-site graph is written to lock-wait-graph.json and, with perfetto, "
+        "flow events link each release to the wake-up of the waiting thread",
+        false, "backend", "parallelism", "gotcha", "advanced");
+
     ROCPROFSYS_CONFIG_SETTING(bool, "ROCPROFSYS_TRACE_THREAD_BARRIERS",
                               "Enable tracing calls to pthread_barrier functions.", true,
                               "backend", "parallelism", "gotcha", "advanced");
@@ -561,6 +605,55 @@ configure_settings(bool _init)
                               "Create entries for inlined functions when available",
                               false, "sampling", "data", "advanced");
 
+    ROCPROFSYS_CONFIG_SETTING(
+        std::string, "ROCPROFSYS_SAMPLING_UNWINDER",
+        "Unwinder used for the call-stack of timer-based samples. 'frame-pointer' walks "
+        "the frame-pointer chain of the interrupted context and is much cheaper than "
+        "'libunwind' but requires code compiled with -fno-omit-frame-pointer. When the "
+        "frame-pointer chain is invalid, the sample (and eventually the thread) falls "
+        "back to libunwind",
+        std::string{ "libunwind" }, "sampling", "advanced")
+        ->set_choices({ "libunwind", "frame-pointer" });
+
+    ROCPROFSYS_CONFIG_SETTING(
+        double, "ROCPROFSYS_SAMPLING_OVERHEAD_BUDGET",
+        "Target percentage of each thread's elapsed time spent in the sampling signal "
+        "handler, e.g. 2 == 2%. When greater than zero, the CPU-time and real-time "
+        "sampling intervals of each thread are adaptively lengthened (never beyond "
+        "ROCPROFSYS_SAMPLING_MAX_INTERVAL_SCALE times, and never shorter than, the "
+        "configured period) to stay within the budget. Each sample carries the ratio of "
+        "its effective interval to the configured interval as its weight",
+        0.0, "sampling", "advanced");
+
+    ROCPROFSYS_CONFIG_SETTING(
+        double, "ROCPROFSYS_SAMPLING_MAX_INTERVAL_SCALE",
+        "Maximum factor by which the adaptive sampling controller may lengthen the "
+        "sampling interval (see ROCPROFSYS_SAMPLING_OVERHEAD_BUDGET)",
+        64.0, "sampling", "advanced");
+
+    ROCPROFSYS_CONFIG_SETTING(
+        bool, "ROCPROFSYS_SAMPLING_FOLDED_OUTPUT",
+        "Write the call-stack samples as collapsed (folded) stacks, one file per sample "
+        "value type, which can be consumed directly by flamegraph.pl, speedscope, etc.",
+        false, "sampling", "io", "advanced");
+
+    ROCPROFSYS_CONFIG_SETTING(
+        bool, "ROCPROFSYS_SAMPLING_PPROF_OUTPUT",
+        "Write the call-stack samples as a pprof profile (profile.proto) which can be "
+        "consumed directly by 'pprof' and other tools supporting the format",
+        false, "sampling", "io", "advanced");
+
+    ROCPROFSYS_CONFIG_SETTING(
+        bool, "ROCPROFSYS_SAMPLING_OFFCPU",
+        "Attribute the time each thread spends blocked (off-CPU: I/O, locks, MPI "
+        "waits, etc.) to the call-stack sampled by the real-time timer. The off-CPU "
+        "time of a sample is the elapsed wall-clock time minus the elapsed thread CPU "
+        "time since the previous sample on the thread. Requires "
+        "ROCPROFSYS_SAMPLING_REALTIME and is most useful in combination with "
+        "ROCPROFSYS_SAMPLING_CPUTIME. Produces a separate sampling_offcpu_clock "
+        "call-graph and a sampling-offcpu-folded.txt flamegraph input",
+        false, "sampling", "advanced");
+
     ROCPROFSYS_CONFIG_SETTING(
         size_t, "ROCPROFSYS_SAMPLING_ALLOCATOR_SIZE",
         "The number of sampled threads handled by an allocator running in a background "
@@ -683,6 +776,57 @@ configure_settings(bool _init)
         "discard", "perfetto", "data")
         ->set_choices({ "fill", "discard" });
 
+    ROCPROFSYS_CONFIG_SETTING(
+        std::string, "ROCPROFSYS_PERFETTO_COMPRESSION",
+        "Compression applied to the perfetto trace when it is written. 'deflate' "
+        "writes the trace packets as zlib-compressed TracePacket.compressed_packets "
+        "(supported by the perfetto trace processor and UI). Compression is performed "
+        "on a background thread. With ROCPROFSYS_USE_TEMPORARY_FILES, the trace data "
+        "is compressed into the temporary file as it is read from the perfetto buffer "
+        "every ROCPROFSYS_PERFETTO_FILE_WRITE_PERIOD_MS (or at finalization when it is "
+        "zero) so the uncompressed trace is never written to disk",
+        "none", "perfetto", "io", "data", "advanced")
+        ->set_choices({ "none", "deflate" });
+
+    ROCPROFSYS_CONFIG_SETTING(
+        size_t, "ROCPROFSYS_PERFETTO_ROTATE_SIZE_MB",
+        "If > 0, close the current perfetto trace file and start a new numbered trace "
+        "file (e.g. perfetto-trace.1.proto) once this many MB of trace data have been "
+        "written. Each trace file can be loaded independently",
+        size_t{ 0 }, "perfetto", "io", "data", "advanced");
+
+    ROCPROFSYS_CONFIG_SETTING(
+        double, "ROCPROFSYS_PERFETTO_ROTATE_SECONDS",
+        "If > 0.0, close the current perfetto trace file and start a new numbered trace "
+        "file (e.g. perfetto-trace.1.proto) after this many seconds. Each trace file "
+        "can be loaded independently",
+        0.0, "perfetto", "io", "data", "advanced");
+
+    ROCPROFSYS_CONFIG_SETTING(
+        uint64_t, "ROCPROFSYS_PERFETTO_FILE_WRITE_PERIOD_MS",
+        "If > 0, the in-process perfetto session periodically drains its buffer into "
+        "the temporary trace file at this interval (in milliseconds) instead of holding "
+        "all the data until finalization. This allows a small "
+        "ROCPROFSYS_PERFETTO_BUFFER_SIZE_KB to be used for long runs without losing "
+        "data. Requires ROCPROFSYS_USE_TEMPORARY_FILES",
+        uint64_t{ 0 }, "perfetto", "io", "data", "advanced");
+
+    ROCPROFSYS_CONFIG_SETTING(
+        uint64_t, "ROCPROFSYS_PERFETTO_FLUSH_PERIOD_MS",
+        "If > 0, periodically flush the thread-local perfetto trace writers into the "
+        "central buffer at this interval (in milliseconds). Recommended when "
+        "ROCPROFSYS_PERFETTO_FILE_WRITE_PERIOD_MS is set so that data from "
+        "long-running threads is streamed to disk",
+        uint64_t{ 0 }, "perfetto", "io", "data", "advanced");
+
+    ROCPROFSYS_CONFIG_SETTING(
+        uint64_t, "ROCPROFSYS_PERFETTO_COMM_COUNTER_PERIOD_MS",
+        "Interval (in milliseconds) at which the MPI/RCCL communication data counter "
+        "tracks are updated. The bytes transferred by each thread are accumulated and "
+        "one counter sample per thread is emitted per interval instead of one per "
+        "call. A value of 0 emits a counter sample for every call",
+        uint64_t{ 1 }, "perfetto", "mpi", "rccl", "data", "advanced");
+
     ROCPROFSYS_CONFIG_SETTING(std::string, "ROCPROFSYS_ENABLE_CATEGORIES",
                               "Enable collecting profiling and trace data for these "
                               "categories and disable all other categories",
@@ -1957,6 +2101,20 @@ get_use_mpip()
     return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
 
+bool
+get_mpip_comm_matrix()
+{
+    static auto _v = get_config()->find("ROCPROFSYS_MPIP_COMM_MATRIX");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_mpip_wait_state()
+{
+    static auto _v = get_config()->find("ROCPROFSYS_MPIP_WAIT_STATE");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
 bool
 get_use_kokkosp()
 {
@@ -2091,6 +2249,48 @@ get_perfetto_fill_policy()
     return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
 }
 
+std::string
+get_perfetto_compression()
+{
+    static auto _v = get_config()->find("ROCPROFSYS_PERFETTO_COMPRESSION");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
+size_t
+get_perfetto_rotate_size()
+{
+    static auto _v = get_config()->find("ROCPROFSYS_PERFETTO_ROTATE_SIZE_MB");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
+double
+get_perfetto_rotate_seconds()
+{
+    static auto _v = get_config()->find("ROCPROFSYS_PERFETTO_ROTATE_SECONDS");
+    return static_cast<tim::tsettings<double>&>(*_v->second).get();
+}
+
+uint64_t
+get_perfetto_file_write_period()
+{
+    static auto _v = get_config()->find("ROCPROFSYS_PERFETTO_FILE_WRITE_PERIOD_MS");
+    return static_cast<tim::tsettings<uint64_t>&>(*_v->second).get();
+}
+
+uint64_t
+get_perfetto_flush_period()
+{
+    static auto _v = get_config()->find("ROCPROFSYS_PERFETTO_FLUSH_PERIOD_MS");
+    return static_cast<tim::tsettings<uint64_t>&>(*_v->second).get();
+}
+
+uint64_t
+get_perfetto_comm_counter_period()
+{
+    static auto _v = get_config()->find("ROCPROFSYS_PERFETTO_COMM_COUNTER_PERIOD_MS");
+    return static_cast<tim::tsettings<uint64_t>&>(*_v->second).get();
+}
+
 namespace
 {
 auto
@@ -2333,6 +2533,50 @@ get_sampling_include_inlines()
     return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
 
+std::string
+get_sampling_unwinder()
+{
+    static auto _v = get_config()->find("ROCPROFSYS_SAMPLING_UNWINDER");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
+double
+get_sampling_overhead_budget()
+{
+    static auto _v = get_config()->find("ROCPROFSYS_SAMPLING_OVERHEAD_BUDGET");
+    return std::max<double>(static_cast<tim::tsettings<double>&>(*_v->second).get(),
+                            0.0);
+}
+
+double
+get_sampling_max_interval_scale()
+{
+    static auto _v = get_config()->find("ROCPROFSYS_SAMPLING_MAX_INTERVAL_SCALE");
+    return std::max<double>(static_cast<tim::tsettings<double>&>(*_v->second).get(),
+                            1.0);
+}
+
+bool
+get_sampling_folded_output()
+{
+    static auto _v = get_config()->find("ROCPROFSYS_SAMPLING_FOLDED_OUTPUT");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_sampling_pprof_output()
+{
+    static auto _v = get_config()->find("ROCPROFSYS_SAMPLING_PPROF_OUTPUT");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_sampling_offcpu()
+{
+    static auto _v = get_config()->find("ROCPROFSYS_SAMPLING_OFFCPU");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
 size_t
 get_sampling_allocator_size()
 {
@@ -2396,6 +2640,29 @@ get_trace_thread_spin_locks()
     return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
 
+bool
+get_trace_thread_lock_contention()
+{
+    static auto _v = get_config()->find("ROCPROFSYS_TRACE_THREAD_LOCK_CONTENTION");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+double
+get_trace_thread_lock_wait_threshold()
+{
+    static auto _v = get_config()->find("ROCPROFSYS_TRACE_THREAD_LOCK_WAIT_THRESHOLD");
+    return std::max<double>(static_cast<tim::tsettings<double>&>(*_v->second).get(),
+                            0.0);
+}
+
+bool
+get_trace_thread_lock_holders()
+{
+    static auto _v = get_config()->find("ROCPROFSYS_TRACE_THREAD_LOCK_HOLDERS");
+    return get_trace_thread_lock_contention() &&
+           static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
 bool
 get_trace_thread_barriers()
 {
@@ -218,6 +218,12 @@ get_use_pid();
 bool&
 get_use_mpip();
 
+bool
+get_mpip_comm_matrix();
+
+bool
+get_mpip_wait_state();
+
 bool
 get_use_kokkosp();
 
@@ -260,6 +266,24 @@ get_perfetto_combined_traces();
 std::string
 get_perfetto_fill_policy();
 
+std::string
+get_perfetto_compression();
+
+size_t
+get_perfetto_rotate_size();
+
+double
+get_perfetto_rotate_seconds();
+
+uint64_t
+get_perfetto_file_write_period();
+
+uint64_t
+get_perfetto_flush_period();
+
+uint64_t
+get_perfetto_comm_counter_period();
+
 std::set<std::string>
 get_enabled_categories();
 
@@ -330,6 +354,24 @@ get_sampling_overflow_tids();
 bool
 get_sampling_include_inlines();
 
+std::string
+get_sampling_unwinder();
+
+double
+get_sampling_overhead_budget();
+
+double
+get_sampling_max_interval_scale();
+
+bool
+get_sampling_folded_output();
+
+bool
+get_sampling_pprof_output();
+
+bool
+get_sampling_offcpu();
+
 size_t
 get_num_threads_hint();
 
@@ -354,6 +396,15 @@ get_trace_thread_rwlocks();
 bool
 get_trace_thread_spin_locks();
 
+bool
+get_trace_thread_lock_contention();
+
+double
+get_trace_thread_lock_wait_threshold();
+
+bool
+get_trace_thread_lock_holders();
+
 bool
 get_trace_thread_barriers();
 
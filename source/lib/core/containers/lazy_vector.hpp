@@ -0,0 +1,375 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "core/containers/aligned_static_vector.hpp"
+#include "core/containers/operators.hpp"
+#include "core/defines.hpp"
+#include "core/exception.hpp"
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace rocprofsys
+{
+namespace container
+{
+/// vector-like container whose storage is allocated on first access. Chunk N holds
+/// (ChunkSizeV << N) elements so the chunk and the offset of an index are computed
+/// from its leading bit and the lookup costs one load of the (atomically published)
+/// chunk pointer followed by one indexed load. Chunks are allocated in order and
+/// never move or shrink so references remain valid for the lifetime of the container
+/// and readers never need to lock. New elements are assigned the result of the
+/// initializer, when one is provided. Only non-const access allocates: const access to
+/// an element of a chunk which is not allocated returns a shared, value-initialized
+/// element
+template <typename Tp, size_t ChunkSizeV = 16, size_t AlignN = alignof(Tp)>
+class lazy_vector
+{
+public:
+    using value_type       = Tp;
+    using reference        = value_type&;
+    using const_reference  = const value_type&;
+    using pointer          = value_type*;
+    using const_pointer    = const value_type*;
+    using size_type        = size_t;
+    using difference_type  = std::ptrdiff_t;
+    using initializer_type = std::function<value_type()>;
+
+    static constexpr const size_t chunk_size = ChunkSizeV;
+
+private:
+    template <size_t N>
+    struct is_pow2
+    {
+        static constexpr bool value = (N & (N - 1)) == 0;
+    };
+
+    template <size_t N>
+    struct log2
+    {
+        static constexpr size_t value = (N <= 1) ? 0 : 1 + log2<N / 2>::value;
+    };
+
+    static_assert(ChunkSizeV > 0, "ChunkSize needs to be greater than zero");
+    static_assert(is_pow2<ChunkSizeV>::value, "ChunkSize needs to be a power of 2");
+
+    static constexpr size_t chunk_shift = log2<ChunkSizeV>::value;
+    static constexpr size_t max_chunks  = (8 * sizeof(size_type)) - chunk_shift - 1;
+
+    using this_type       = lazy_vector<Tp, ChunkSizeV, AlignN>;
+    using const_this_type = const lazy_vector<Tp, ChunkSizeV, AlignN>;
+
+    struct aligned_value_type
+    {
+        alignas(AlignN) Tp value = {};
+    };
+
+    using chunk_type   = aligned_value_type;
+    using storage_type = std::array<std::atomic<chunk_type*>, max_chunks>;
+
+    template <typename ContainerT>
+    struct iterator_base
+    {
+        iterator_base(ContainerT* c = nullptr, size_type i = 0)
+        : m_container(c)
+        , m_index(i)
+        {}
+
+        iterator_base& operator+=(size_type i)
+        {
+            m_index += i;
+            return *this;
+        }
+        iterator_base& operator-=(size_type i)
+        {
+            m_index -= i;
+            return *this;
+        }
+        iterator_base& operator++()
+        {
+            ++m_index;
+            return *this;
+        }
+        iterator_base& operator--()
+        {
+            --m_index;
+            return *this;
+        }
+
+        difference_type operator-(const iterator_base& it)
+        {
+            assert(m_container == it.m_container);
+            return m_index - it.m_index;
+        }
+
+        bool operator<(const iterator_base& it) const
+        {
+            assert(m_container == it.m_container);
+            return m_index < it.m_index;
+        }
+        bool operator==(const iterator_base& it) const
+        {
+            return m_container == it.m_container && m_index == it.m_index;
+        }
+
+    protected:
+        ContainerT* m_container;
+        size_type   m_index;
+    };
+
+public:
+    struct const_iterator;
+
+    struct iterator
+    : public iterator_base<this_type>
+    , public random_access_iterator_helper<iterator, value_type>
+    {
+        using iterator_base<this_type>::iterator_base;
+        friend struct const_iterator;
+
+        reference operator*() { return (*this->m_container)[this->m_index]; }
+    };
+
+    struct const_iterator
+    : public iterator_base<const_this_type>
+    , public random_access_iterator_helper<const_iterator, const value_type>
+    {
+        using iterator_base<const_this_type>::iterator_base;
+
+        const_iterator(const iterator& it)
+        : iterator_base<const_this_type>(it.m_container, it.m_index)
+        {}
+
+        const_reference operator*() const { return (*this->m_container)[this->m_index]; }
+
+        bool operator==(const const_iterator& it) const
+        {
+            return iterator_base<const_this_type>::operator==(it);
+        }
+
+        friend bool operator==(const iterator& l, const const_iterator& r)
+        {
+            return r == l;
+        }
+    };
+
+    lazy_vector() = default;
+    explicit lazy_vector(initializer_type _init);
+    ~lazy_vector();
+
+    // elements are handed out by reference to other threads so the storage can
+    // neither be copied nor moved
+    lazy_vector(const lazy_vector&)     = delete;
+    lazy_vector(lazy_vector&&) noexcept = delete;
+
+    lazy_vector& operator=(const lazy_vector&) = delete;
+    lazy_vector& operator=(lazy_vector&&) noexcept = delete;
+
+    iterator       begin() noexcept { return { this, 0 }; }
+    const_iterator begin() const noexcept { return { this, 0 }; }
+    const_iterator cbegin() const noexcept { return begin(); }
+
+    iterator       end() noexcept { return { this, size() }; }
+    const_iterator end() const noexcept { return { this, size() }; }
+    const_iterator cend() const noexcept { return end(); }
+
+    /// number of elements in the allocated chunks
+    size_type size() const noexcept
+    {
+        return chunk_offset(m_nchunks.load(std::memory_order_acquire));
+    }
+    size_type max_size() const noexcept { return chunk_offset(max_chunks); }
+    size_type capacity() const noexcept { return size(); }
+
+    bool empty() const noexcept { return size() == 0; }
+
+    /// allocates the chunks required to hold at least new_capacity elements
+    void reserve(size_type new_capacity);
+    void shrink_to_fit() noexcept {}
+
+    /// the initializer is only applied to elements of chunks allocated afterwards
+    void set_initializer(initializer_type _init);
+
+    reference operator[](size_type i);
+
+    const_reference operator[](size_type i) const;
+
+    reference at(size_type i);
+
+    const_reference at(size_type i) const;
+
+private:
+    // index of the first element in chunk _n
+    static constexpr size_type chunk_offset(size_type _n)
+    {
+        return ((size_type{ 1 } << _n) - 1) << chunk_shift;
+    }
+
+    static constexpr size_type chunk_length(size_type _n) { return ChunkSizeV << _n; }
+
+    static size_type chunk_index(size_type i)
+    {
+        const size_type _biased = i + ChunkSizeV;
+        return (8 * sizeof(unsigned long long) - 1 - __builtin_clzll(_biased)) -
+               chunk_shift;
+    }
+
+    chunk_type* allocate(size_type _n);
+
+    std::mutex             m_mutex   = {};
+    std::atomic<size_type> m_nchunks = { 0 };
+    storage_type           m_chunks  = {};
+    initializer_type       m_init    = {};
+};
+
+template <typename Tp, size_t ChunkSizeV, size_t AlignN>
+lazy_vector<Tp, ChunkSizeV, AlignN>::lazy_vector(initializer_type _init)
+: m_init{ std::move(_init) }
+{}
+
+template <typename Tp, size_t ChunkSizeV, size_t AlignN>
+lazy_vector<Tp, ChunkSizeV, AlignN>::~lazy_vector()
+{
+    for(auto& itr : m_chunks)
+        delete[] itr.exchange(nullptr);
+}
+
+template <typename Tp, size_t ChunkSizeV, size_t AlignN>
+typename lazy_vector<Tp, ChunkSizeV, AlignN>::chunk_type*
+lazy_vector<Tp, ChunkSizeV, AlignN>::allocate(size_type _n)
+{
+    if(ROCPROFSYS_UNLIKELY(_n >= max_chunks))
+    {
+        throw ::rocprofsys::exception<std::out_of_range>(
+            "lazy_vector::allocate(" + std::to_string(_n) + "). max chunks is " +
+            std::to_string(max_chunks));
+    }
+
+    std::unique_lock<std::mutex> _lk{ m_mutex };
+
+    // allocate every chunk up to and including _n so that the allocated chunks are
+    // always contiguous and size() never covers a missing chunk
+    for(size_type i = m_nchunks.load(std::memory_order_relaxed); i <= _n; ++i)
+    {
+        auto* _chunk = new chunk_type[chunk_length(i)];
+        if(m_init)
+        {
+            for(size_type j = 0; j < chunk_length(i); ++j)
+                _chunk[j].value = m_init();
+        }
+        m_chunks[i].store(_chunk, std::memory_order_release);
+        m_nchunks.store(i + 1, std::memory_order_release);
+    }
+
+    return m_chunks[_n].load(std::memory_order_acquire);
+}
+
+template <typename Tp, size_t ChunkSizeV, size_t AlignN>
+void
+lazy_vector<Tp, ChunkSizeV, AlignN>::reserve(size_type new_capacity)
+{
+    if(new_capacity > capacity()) allocate(chunk_index(new_capacity - 1));
+}
+
+template <typename Tp, size_t ChunkSizeV, size_t AlignN>
+void
+lazy_vector<Tp, ChunkSizeV, AlignN>::set_initializer(initializer_type _init)
+{
+    std::unique_lock<std::mutex> _lk{ m_mutex };
+    m_init = std::move(_init);
+}
+
+template <typename Tp, size_t ChunkSizeV, size_t AlignN>
+typename lazy_vector<Tp, ChunkSizeV, AlignN>::reference
+lazy_vector<Tp, ChunkSizeV, AlignN>::operator[](size_type i)
+{
+    const auto _n     = chunk_index(i);
+    auto*      _chunk = m_chunks[_n].load(std::memory_order_acquire);
+    if(ROCPROFSYS_UNLIKELY(!_chunk)) _chunk = allocate(_n);
+    return _chunk[i - chunk_offset(_n)].value;
+}
+
+template <typename Tp, size_t ChunkSizeV, size_t AlignN>
+typename lazy_vector<Tp, ChunkSizeV, AlignN>::const_reference
+lazy_vector<Tp, ChunkSizeV, AlignN>::operator[](size_type i) const
+{
+    static const auto _empty = value_type{};
+
+    const auto  _n     = chunk_index(i);
+    const auto* _chunk = m_chunks[_n].load(std::memory_order_acquire);
+    return (_chunk) ? _chunk[i - chunk_offset(_n)].value : _empty;
+}
+
+template <typename Tp, size_t ChunkSizeV, size_t AlignN>
+typename lazy_vector<Tp, ChunkSizeV, AlignN>::reference
+lazy_vector<Tp, ChunkSizeV, AlignN>::at(size_type i)
+{
+    if(ROCPROFSYS_UNLIKELY(i >= max_size()))
+    {
+        throw ::rocprofsys::exception<std::out_of_range>(
+            "lazy_vector::at(" + std::to_string(i) + "). max size is " +
+            std::to_string(max_size()));
+    }
+
+    return operator[](i);
+}
+
+template <typename Tp, size_t ChunkSizeV, size_t AlignN>
+typename lazy_vector<Tp, ChunkSizeV, AlignN>::const_reference
+lazy_vector<Tp, ChunkSizeV, AlignN>::at(size_type i) const
+{
+    if(ROCPROFSYS_UNLIKELY(i >= max_size()))
+    {
+        throw ::rocprofsys::exception<std::out_of_range>(
+            "lazy_vector::at(" + std::to_string(i) + ") const. max size is " +
+            std::to_string(max_size()));
+    }
+
+    return operator[](i);
+}
+
+template <typename Tp, size_t ChunkSizeV, size_t AlignN, typename... Args>
+auto
+resize(lazy_vector<Tp, ChunkSizeV, AlignN>& _v, size_t _n, Args&&... args)
+{
+    const size_t _beg = _v.size();
+    _v.reserve(_n);
+
+    // elements of the new chunks were assigned by the initializer, if any
+    if constexpr(sizeof...(Args) > 0)
+    {
+        for(size_t i = _beg; i < _v.size(); ++i)
+            _v[i] = Tp(args...);
+    }
+
+    return _v.size();
+}
+}  // namespace container
+}  // namespace rocprofsys
@@ -0,0 +1,108 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace rocprofsys
+{
+namespace cpu_freq_files
+{
+// opens the cpufreq sysfs entry of the cpu. Returns -1 if the entry is unavailable
+inline int
+open_cur_freq(uint64_t _cpu)
+{
+    char _path[128];
+    snprintf(_path, sizeof(_path),
+             "/sys/devices/system/cpu/cpu%lu/cpufreq/scaling_cur_freq",
+             static_cast<unsigned long>(_cpu));
+    return ::open(_path, O_RDONLY | O_CLOEXEC);
+}
+
+// scaling_cur_freq is reported in kHz. pread always reads from offset zero so the
+// descriptor never needs to be rewound or reopened (including after a fork)
+inline bool
+read_cur_freq(int _fd, uint64_t& _khz)
+{
+    char _buf[32];
+    auto _n = ::pread(_fd, _buf, sizeof(_buf) - 1, 0);
+    if(_n <= 0) return false;
+    _buf[_n] = '\0';
+    _khz     = strtoull(_buf, nullptr, 10);
+    return true;
+}
+
+// /proc/self is resolved when the file is opened so the descriptor is tagged with the
+// pid that opened it and is reopened in a forked child
+struct statm_file
+{
+    int   fd  = -1;
+    pid_t pid = -1;
+
+    statm_file()                  = default;
+    statm_file(const statm_file&) = delete;
+    statm_file& operator=(const statm_file&) = delete;
+    ~statm_file() { close(); }
+
+    void close()
+    {
+        if(fd >= 0) ::close(fd);
+        fd  = -1;
+        pid = -1;
+    }
+
+    // reads the total program size and resident set size (in bytes) with one pread
+    bool read(int64_t& _virt, int64_t& _rss)
+    {
+        auto _pid = getpid();
+        if(fd < 0 || pid != _pid)
+        {
+            close();
+            fd  = ::open("/proc/self/statm", O_RDONLY | O_CLOEXEC);
+            pid = _pid;
+            if(fd < 0) return false;
+        }
+
+        char _buf[256];
+        auto _n = ::pread(fd, _buf, sizeof(_buf) - 1, 0);
+        if(_n <= 0) return false;
+        _buf[_n] = '\0';
+
+        long long _size = 0;
+        long long _res  = 0;
+        if(sscanf(_buf, "%lld %lld", &_size, &_res) != 2) return false;
+
+        static const int64_t _page_size = sysconf(_SC_PAGESIZE);
+        _virt                           = _size * _page_size;
+        _rss                            = _res * _page_size;
+        return true;
+    }
+};
+}  // namespace cpu_freq_files
+}  // namespace rocprofsys
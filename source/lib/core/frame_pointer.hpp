@@ -0,0 +1,181 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <pthread.h>
+#include <signal.h>
+#include <ucontext.h>
+
+namespace rocprofsys
+{
+namespace frame_pointer
+{
+// walking the frame-pointer chain is only implemented for the x86_64 signal frame
+// layout. Everywhere else, callers should use libunwind
+#if defined(__x86_64__) && defined(__linux__)
+inline constexpr bool is_supported = true;
+#else
+inline constexpr bool is_supported = false;
+#endif
+
+struct stack_bounds
+{
+    uintptr_t lower = 0;
+    uintptr_t upper = 0;
+
+    bool contains(uintptr_t _addr, size_t _nbytes = sizeof(uintptr_t)) const
+    {
+        return (_addr >= lower && _addr + _nbytes <= upper && _addr + _nbytes > _addr);
+    }
+
+    explicit operator bool() const { return (upper > lower); }
+};
+
+// queries the stack of the calling thread. Not async-signal-safe: call this when the
+// thread is configured for sampling, not from the signal handler
+inline stack_bounds
+get_stack_bounds()
+{
+    auto           _v    = stack_bounds{};
+    pthread_attr_t _attr = {};
+    if(pthread_getattr_np(pthread_self(), &_attr) != 0) return _v;
+
+    void*  _addr = nullptr;
+    size_t _size = 0;
+    if(pthread_attr_getstack(&_attr, &_addr, &_size) == 0 && _addr != nullptr)
+    {
+        _v.lower = reinterpret_cast<uintptr_t>(_addr);
+        _v.upper = _v.lower + _size;
+    }
+    pthread_attr_destroy(&_attr);
+    return _v;
+}
+
+// the address the kernel places on the stack as the return address of the signal
+// handler (i.e. __restore_rt). sigaction is async-signal-safe so this is cached lazily
+inline uintptr_t
+get_signal_restorer(int _signo)
+{
+#if defined(__x86_64__) && defined(__linux__)
+    static std::array<std::atomic<uintptr_t>, 128> _cache = {};
+    if(_signo <= 0 || static_cast<size_t>(_signo) >= _cache.size()) return 0;
+
+    auto _v = _cache[_signo].load(std::memory_order_relaxed);
+    if(_v == 0)
+    {
+        struct sigaction _act = {};
+        if(sigaction(_signo, nullptr, &_act) == 0)
+        {
+            _v = reinterpret_cast<uintptr_t>(_act.sa_restorer);
+            _cache[_signo].store(_v, std::memory_order_relaxed);
+        }
+    }
+    return _v;
+#else
+    (void) _signo;
+    return 0;
+#endif
+}
+
+// locates the ucontext of the interrupted code from within a signal handler. The
+// kernel pushes the restorer address immediately below the ucontext of the signal
+// frame so the stack is scanned from the current frame towards the top of the stack
+inline const ucontext_t*
+find_signal_context(const void* _sp, uintptr_t _restorer, const stack_bounds& _bounds,
+                    size_t _max_scan = 4096)
+{
+#if defined(__x86_64__) && defined(__linux__)
+    auto _addr = reinterpret_cast<uintptr_t>(_sp) & ~(sizeof(uintptr_t) - 1);
+    if(_restorer == 0 || !_bounds.contains(_addr)) return nullptr;
+
+    for(size_t i = 0; i < _max_scan; ++i, _addr += sizeof(uintptr_t))
+    {
+        if(!_bounds.contains(_addr, sizeof(uintptr_t) + sizeof(ucontext_t))) break;
+        if(*reinterpret_cast<const uintptr_t*>(_addr) != _restorer) continue;
+
+        const auto* _uc  = reinterpret_cast<const ucontext_t*>(_addr + sizeof(uintptr_t));
+        auto        _usp = static_cast<uintptr_t>(_uc->uc_mcontext.gregs[REG_RSP]);
+        auto        _uip = static_cast<uintptr_t>(_uc->uc_mcontext.gregs[REG_RIP]);
+        // the interrupted stack pointer must be above the signal frame
+        if(_uip != 0 && _usp > _addr && _bounds.contains(_usp)) return _uc;
+    }
+#else
+    (void) _sp;
+    (void) _restorer;
+    (void) _bounds;
+    (void) _max_scan;
+#endif
+    return nullptr;
+}
+
+// walks the RBP chain of the interrupted context. The first entry is the interrupted
+// instruction; subsequent entries are return addresses minus one so that they resolve
+// to the call site. The walk stops at the first frame pointer which is misaligned,
+// outside of the stack bounds, or not above the previous frame. This is expected at
+// the outermost frames (e.g. libc start-up code compiled without frame pointers) but
+// when not even the caller of the interrupted function can be recovered, the chain is
+// treated as invalid and zero is returned
+inline size_t
+unwind(const ucontext_t* _uc, const stack_bounds& _bounds, uintptr_t* _frames,
+       size_t _max_frames)
+{
+#if defined(__x86_64__) && defined(__linux__)
+    if(!_uc || _max_frames == 0) return 0;
+
+    size_t _n    = 0;
+    auto   _fp   = static_cast<uintptr_t>(_uc->uc_mcontext.gregs[REG_RBP]);
+    auto   _prev = static_cast<uintptr_t>(_uc->uc_mcontext.gregs[REG_RSP]);
+
+    _frames[_n++] = static_cast<uintptr_t>(_uc->uc_mcontext.gregs[REG_RIP]);
+
+    while(_n < _max_frames)
+    {
+        if((_fp & (sizeof(uintptr_t) - 1)) != 0 || _fp < _prev ||
+           !_bounds.contains(_fp, 2 * sizeof(uintptr_t)))
+            break;
+
+        const auto* _frame = reinterpret_cast<const uintptr_t*>(_fp);
+        auto        _ret   = _frame[1];
+        if(_ret == 0) break;
+
+        _frames[_n++] = _ret - 1;
+        _prev         = _fp + 2 * sizeof(uintptr_t);
+        _fp           = _frame[0];
+    }
+
+    return (_n > 1) ? _n : 0;
+#else
+    (void) _uc;
+    (void) _bounds;
+    (void) _frames;
+    (void) _max_frames;
+    return 0;
+#endif
+}
+}  // namespace frame_pointer
+}  // namespace rocprofsys
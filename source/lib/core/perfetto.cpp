@@ -23,9 +23,26 @@
 #include "perfetto.hpp"
 #include "config.hpp"
 #include "library/runtime.hpp"
+#include "perfetto_compression.hpp"
 #include "perfetto_fwd.hpp"
+#include "state.hpp"
 #include "utility.hpp"
 
+#include <timemory/components/timing/backends.hpp>
+
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <fcntl.h>
+#include <future>
+#include <limits>
+#include <mutex>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
 namespace rocprofsys
 {
 namespace perfetto
@@ -47,6 +64,41 @@ get_perfetto_tmp_file(pid_t _pid = process::get_id())
     return _v.at(_pid);
 }
 
+// compresses the trace data of a tracing session into its temporary file as the data
+// is read from the session
+struct session_compressor
+{
+    explicit session_compressor(const std::string& _filename)
+    : fd{ ::open(_filename.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC) }
+    {}
+
+    ~session_compressor() { finish(); }
+
+    session_compressor(const session_compressor&) = delete;
+    session_compressor(session_compressor&&)      = delete;
+    session_compressor& operator=(const session_compressor&) = delete;
+    session_compressor& operator=(session_compressor&&) = delete;
+
+    bool finish()
+    {
+        auto _success = impl.finish();
+        if(fd >= 0) ::close(fd);
+        fd = -1;
+        return _success;
+    }
+
+    int        fd   = -1;
+    compressor impl = compressor{ fd };
+};
+
+auto&
+get_session_compressor(pid_t _pid = process::get_id())
+{
+    static auto _v = std::unordered_map<pid_t, std::unique_ptr<session_compressor>>{};
+    if(_v.find(_pid) == _v.end()) _v.emplace(_pid, std::unique_ptr<session_compressor>{});
+    return _v.at(_pid);
+}
+
 auto&
 get_config()
 {
@@ -63,6 +115,1067 @@ get_session(pid_t _pid = process::get_id())
         _v.emplace(_pid, std::unique_ptr<::perfetto::TracingSession>{});
     return _v.at(_pid);
 }
+
+// subset of the perfetto.protos.TraceStats.BufferStats fields, summed over all the
+// buffers of the tracing session
+struct buffer_stats
+{
+    uint64_t bytes_written            = 0;
+    uint64_t bytes_overwritten        = 0;
+    uint64_t chunks_written           = 0;
+    uint64_t chunks_overwritten       = 0;
+    uint64_t chunks_discarded         = 0;
+    uint64_t patches_failed           = 0;
+    uint64_t trace_writer_packet_loss = 0;
+
+    buffer_stats& operator+=(const buffer_stats&);
+};
+
+buffer_stats&
+buffer_stats::operator+=(const buffer_stats& _rhs)
+{
+    bytes_written += _rhs.bytes_written;
+    bytes_overwritten += _rhs.bytes_overwritten;
+    chunks_written += _rhs.chunks_written;
+    chunks_overwritten += _rhs.chunks_overwritten;
+    chunks_discarded += _rhs.chunks_discarded;
+    patches_failed += _rhs.patches_failed;
+    trace_writer_packet_loss += _rhs.trace_writer_packet_loss;
+    return *this;
+}
+
+// buffer statistics accumulated over all the tracing sessions (i.e. rotated segments)
+auto&
+get_total_buffer_stats()
+{
+    static auto _v = buffer_stats{};
+    return _v;
+}
+
+bool
+read_varint(const uint8_t*& _data, const uint8_t* _end, uint64_t& _value)
+{
+    _value = 0;
+    for(uint32_t _shift = 0; _shift < 64 && _data < _end; _shift += 7)
+    {
+        auto _byte = *_data++;
+        _value |= static_cast<uint64_t>(_byte & 0x7f) << _shift;
+        if((_byte & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+void
+write_varint(std::string& _out, uint64_t _value)
+{
+    for(; _value >= 0x80; _value >>= 7)
+        _out += static_cast<char>((_value & 0x7f) | 0x80);
+    _out += static_cast<char>(_value);
+}
+
+// minimal protobuf decoder for the serialized TraceStats. The callback is invoked
+// with the field number, the wire type, the value (or length) and, for
+// length-delimited fields, a pointer to the payload
+template <typename FuncT>
+void
+decode_proto_fields(const uint8_t* _data, const uint8_t* _end, FuncT&& _func)
+{
+    auto _read_varint = [&_data, _end](uint64_t& _value) {
+        return read_varint(_data, _end, _value);
+    };
+
+    while(_data < _end)
+    {
+        uint64_t _tag   = 0;
+        uint64_t _value = 0;
+        if(!_read_varint(_tag)) return;
+        switch(_tag & 0x7)
+        {
+            case 0:
+                if(!_read_varint(_value)) return;
+                _func(_tag >> 3, 0, _value, nullptr);
+                break;
+            case 1: _data += 8; break;
+            case 2:
+                if(!_read_varint(_value) || _value > static_cast<uint64_t>(_end - _data))
+                    return;
+                _func(_tag >> 3, 2, _value, _data);
+                _data += _value;
+                break;
+            case 5: _data += 4; break;
+            default: return;
+        }
+    }
+}
+
+buffer_stats
+get_buffer_stats(::perfetto::TracingSession* _session)
+{
+    auto _stats = buffer_stats{};
+    if(!_session) return _stats;
+
+    auto _args = _session->GetTraceStatsBlocking();
+    if(!_args.success || _args.trace_stats_data.empty()) return _stats;
+
+    const auto* _beg = _args.trace_stats_data.data();
+    const auto* _end = _beg + _args.trace_stats_data.size();
+    decode_proto_fields(_beg, _end, [&_stats](uint64_t _field, int _wire, uint64_t _len,
+                                              const uint8_t* _payload) {
+        // TraceStats.buffer_stats
+        if(_field != 1 || _wire != 2) return;
+        decode_proto_fields(_payload, _payload + _len,
+                            [&_stats](uint64_t _bfield, int _bwire, uint64_t _value,
+                                      const uint8_t*) {
+                                if(_bwire != 0) return;
+                                switch(_bfield)
+                                {
+                                    case 1: _stats.bytes_written += _value; break;
+                                    case 2: _stats.chunks_written += _value; break;
+                                    case 3: _stats.chunks_overwritten += _value; break;
+                                    case 6: _stats.patches_failed += _value; break;
+                                    case 13: _stats.bytes_overwritten += _value; break;
+                                    case 18: _stats.chunks_discarded += _value; break;
+                                    case 19:
+                                        _stats.trace_writer_packet_loss += _value;
+                                        break;
+                                    default: break;
+                                }
+                            });
+    });
+
+    return _stats;
+}
+
+void
+report_buffer_stats(const buffer_stats& _stats)
+{
+    auto _lost = _stats.chunks_overwritten + _stats.chunks_discarded +
+                 _stats.patches_failed + _stats.trace_writer_packet_loss;
+
+    ROCPROFSYS_VERBOSE((_lost > 0) ? 0 : 1,
+                       "perfetto buffer statistics: %.2f MB written in %lu chunks, "
+                       "%lu chunks overwritten (%.2f MB), %lu chunks discarded, %lu "
+                       "patches failed, %lu packets lost by trace writers\n",
+                       static_cast<double>(_stats.bytes_written) / units::MB,
+                       static_cast<unsigned long>(_stats.chunks_written),
+                       static_cast<unsigned long>(_stats.chunks_overwritten),
+                       static_cast<double>(_stats.bytes_overwritten) / units::MB,
+                       static_cast<unsigned long>(_stats.chunks_discarded),
+                       static_cast<unsigned long>(_stats.patches_failed),
+                       static_cast<unsigned long>(_stats.trace_writer_packet_loss));
+
+    if(_lost > 0)
+    {
+        ROCPROFSYS_VERBOSE(0,
+                           "perfetto trace data was lost. Consider increasing "
+                           "ROCPROFSYS_PERFETTO_BUFFER_SIZE_KB or setting "
+                           "ROCPROFSYS_PERFETTO_FILE_WRITE_PERIOD_MS and "
+                           "ROCPROFSYS_PERFETTO_FLUSH_PERIOD_MS\n");
+    }
+}
+
+// state of the background thread which rotates the trace files and/or compresses the
+// session data into the temporary file while the session is running
+struct writer_data
+{
+    bool                     active    = false;
+    bool                     error     = false;
+    size_t                   segment   = 0;
+    std::thread              thread    = {};
+    std::mutex               mutex     = {};
+    std::condition_variable  cv        = {};
+    std::vector<std::string> filenames = {};
+};
+
+auto&
+get_writer_data()
+{
+    static auto _v = writer_data{};
+    return _v;
+}
+
+bool
+use_rotation()
+{
+    return (config::get_perfetto_rotate_size() > 0 ||
+            config::get_perfetto_rotate_seconds() > 0.0);
+}
+
+// inserts the segment number before the extension, e.g. perfetto-trace.1.proto
+std::string
+get_segment_filename(const std::string& _filename, size_t _segment)
+{
+    auto _ext = _filename.find_last_of('.');
+    auto _dir = _filename.find_last_of('/');
+    if(_ext == std::string::npos || (_dir != std::string::npos && _ext < _dir))
+        return JOIN('.', _filename, _segment);
+    return JOIN('.', _filename.substr(0, _ext), _segment, _filename.substr(_ext + 1));
+}
+
+// invokes the callback with the field number, the value (or length) and the extent of
+// each field of a serialized protobuf message. Returns false if the message is malformed
+template <typename FuncT>
+bool
+for_each_proto_field(const uint8_t* _data, const uint8_t* _end, FuncT&& _func)
+{
+    while(_data < _end)
+    {
+        const auto* _field = _data;
+        auto        _tag   = uint64_t{ 0 };
+        auto        _value = uint64_t{ 0 };
+        if(!read_varint(_data, _end, _tag)) return false;
+
+        switch(_tag & 0x7)
+        {
+            case 0:
+                if(!read_varint(_data, _end, _value)) return false;
+                break;
+            case 1:
+                if(_end - _data < 8) return false;
+                _data += 8;
+                break;
+            case 2:
+                if(!read_varint(_data, _end, _value)) return false;
+                if(_value > static_cast<uint64_t>(_end - _data)) return false;
+                _data += _value;
+                break;
+            case 5:
+                if(_end - _data < 4) return false;
+                _data += 4;
+                break;
+            default: return false;
+        }
+
+        _func(_tag >> 3, _value, _field, _data);
+    }
+    return true;
+}
+
+// removes the track events which lie outside of [begin, end) from the serialized trace
+// data of a rotated segment. While the sessions of two segments overlap, the events are
+// recorded by both: the previous segment keeps the events before the switch and the
+// next segment keeps the events after it. The begin cut is only applied to the data
+// which the next session holds when the previous session has been stopped since the
+// events arriving afterwards were not recorded by the previous session. The packets
+// which also carry interned data or reset the incremental state are kept without the
+// track event. The data may be passed in chunks of any size
+struct segment_cut
+{
+    // TracePacket field numbers
+    static constexpr uint64_t timestamp_field      = 8;
+    static constexpr uint64_t track_event_field    = 11;
+    static constexpr uint64_t interned_data_field  = 12;
+    static constexpr uint64_t sequence_flags_field = 13;
+    static constexpr uint64_t state_cleared_field  = 41;
+    static constexpr uint64_t clock_id_field       = 58;
+
+    uint64_t          begin   = 0;
+    uint64_t          end     = std::numeric_limits<uint64_t>::max();
+    size_t            removed = 0;
+    bool              invalid = false;
+    std::string       carry   = {};  // incomplete packet at the end of the last chunk
+    std::vector<char> data    = {};  // data read at the switch without a temporary file
+
+    template <typename FuncT>
+    bool operator()(const char* _data, size_t _size, FuncT&& _write);
+
+private:
+    bool keep(const uint8_t* _beg, const uint8_t* _end, std::string& _stripped);
+};
+
+// returns true if the packet is kept unchanged. Otherwise, the packet is dropped or,
+// if it is not empty, replaced by the stripped packet
+bool
+segment_cut::keep(const uint8_t* _beg, const uint8_t* _end, std::string& _stripped)
+{
+    auto _timestamp = uint64_t{ 0 };
+    bool _has_time  = false;
+    bool _has_event = false;
+    bool _has_clock = false;
+    bool _has_state = false;
+
+    auto _inspect = [&](uint64_t _field, uint64_t _value, const uint8_t*,
+                        const uint8_t*) {
+        if(_field == timestamp_field)
+        {
+            _timestamp = _value;
+            _has_time  = true;
+        }
+        else if(_field == track_event_field)
+            _has_event = true;
+        else if(_field == clock_id_field)
+            _has_clock = true;
+        else if(_field == sequence_flags_field)
+            _has_state |= ((_value & 0x1) != 0);  // SEQ_INCREMENTAL_STATE_CLEARED
+        else if(_field == interned_data_field || _field == state_cleared_field)
+            _has_state = true;
+    };
+
+    auto _valid = for_each_proto_field(_beg, _end, _inspect);
+
+    // the track events without an absolute timestamp are not cut
+    if(!_valid || !_has_event || !_has_time || _has_clock) return true;
+    if(_timestamp >= begin && _timestamp < end) return true;
+
+    ++removed;
+    if(!_has_state) return false;
+
+    auto _fields = std::string{};
+    for_each_proto_field(_beg, _end,
+                         [&_fields](uint64_t _field, uint64_t, const uint8_t* _field_beg,
+                                    const uint8_t* _field_end) {
+                             if(_field == track_event_field) return;
+                             _fields.append(reinterpret_cast<const char*>(_field_beg),
+                                            _field_end - _field_beg);
+                         });
+
+    _stripped = std::string{ "\x0a" };  // Trace.packet
+    write_varint(_stripped, _fields.size());
+    _stripped += _fields;
+    return false;
+}
+
+template <typename FuncT>
+bool
+segment_cut::operator()(const char* _data, size_t _size, FuncT&& _write)
+{
+    if(invalid) return _write(_data, _size);
+
+    auto _buffer = std::string{};
+    if(!carry.empty())
+    {
+        _buffer = std::move(carry);
+        _buffer.append(_data, _size);
+        _data = _buffer.data();
+        _size = _buffer.size();
+    }
+    carry.clear();
+
+    const auto* _end      = reinterpret_cast<const uint8_t*>(_data) + _size;
+    const auto* _pos      = reinterpret_cast<const uint8_t*>(_data);
+    const auto* _run      = _pos;  // beginning of the packets written unchanged
+    auto        _stripped = std::string{};
+    bool        _success  = true;
+
+    auto _write_run = [&](const uint8_t* _run_end) {
+        if(_run_end > _run)
+            _success = _write(reinterpret_cast<const char*>(_run), _run_end - _run) &&
+                       _success;
+    };
+
+    while(_pos < _end)
+    {
+        const auto* _packet = _pos;
+        auto        _tag    = uint64_t{ 0 };
+        auto        _length = uint64_t{ 0 };
+        bool        _header = read_varint(_pos, _end, _tag) && _tag == 0x0a &&
+                       read_varint(_pos, _end, _length);
+
+        if(_header && _length <= static_cast<uint64_t>(_end - _pos))
+        {
+            _stripped.clear();
+            if(!keep(_pos, _pos + _length, _stripped))
+            {
+                _write_run(_packet);
+                if(!_stripped.empty())
+                    _success = _write(_stripped.data(), _stripped.size()) && _success;
+                _run = _pos + _length;
+            }
+            _pos += _length;
+        }
+        else if(_pos >= _end || _header)
+        {
+            // the remainder of the packet is in the next chunk
+            _write_run(_packet);
+            carry.assign(reinterpret_cast<const char*>(_packet), _end - _packet);
+            return _success;
+        }
+        else
+        {
+            ROCPROFSYS_VERBOSE(0, "perfetto trace data could not be parsed. The events "
+                                  "of the rotated segments will not be cut\n");
+            invalid = true;
+            break;
+        }
+    }
+
+    _write_run(_end);
+    return _success;
+}
+
+auto&
+get_segment_cut(pid_t _pid = process::get_id())
+{
+    static auto _v = std::unordered_map<pid_t, std::unique_ptr<segment_cut>>{};
+    if(_v.find(_pid) == _v.end()) _v.emplace(_pid, std::unique_ptr<segment_cut>{});
+    return _v.at(_pid);
+}
+
+// passes whatever data is currently held by the tracing session to the writer one
+// chunk at a time so that the trace is never fully buffered. The session does not
+// need to be stopped: the data which has been read is released from its buffer. The
+// data is passed through the cut of the segment, if there is one
+template <typename FuncT>
+size_t
+read_session_data(::perfetto::TracingSession* _session, FuncT&& _write,
+                  segment_cut* _cut = nullptr)
+{
+    auto _nbytes  = size_t{ 0 };
+    auto _promise = std::promise<void>{};
+    auto _future  = _promise.get_future();
+
+    using read_args_t = ::perfetto::TracingSession::ReadTraceCallbackArgs;
+
+    _session->ReadTrace([&_write, &_nbytes, &_promise, _cut](read_args_t _args) {
+        if(_args.size > 0)
+        {
+            auto _success = (_cut) ? (*_cut)(_args.data, _args.size, _write)
+                                   : _write(_args.data, _args.size);
+            if(_success) _nbytes += _args.size;
+        }
+        if(!_args.has_more) _promise.set_value();
+    });
+
+    _future.wait();
+    return _nbytes;
+}
+
+// streams the data still held by the tracing session onto the end of the file
+size_t
+append_session_data(::perfetto::TracingSession* _session, int _fd,
+                    segment_cut* _cut = nullptr)
+{
+    auto _append = [_fd](const char* _data, size_t _size) {
+        while(_size > 0)
+        {
+            auto _ret = ::write(_fd, _data, _size);
+            if(_ret < 0 && errno == EINTR) continue;
+            if(_ret <= 0)
+            {
+                ROCPROFSYS_VERBOSE(-1, "Error writing perfetto trace data: %s\n",
+                                   strerror(errno));
+                return false;
+            }
+            _data += _ret;
+            _size -= _ret;
+        }
+        return true;
+    };
+    return read_session_data(_session, _append, _cut);
+}
+
+// compresses the data still held by the tracing session into its temporary file
+size_t
+compress_session_data(::perfetto::TracingSession* _session, session_compressor& _sink,
+                      segment_cut* _cut = nullptr)
+{
+    return read_session_data(
+        _session,
+        [&_sink](const char* _data, size_t _size) {
+            return _sink.impl.write(_data, _size);
+        },
+        _cut);
+}
+
+// copies the contents of one file descriptor to another inside the kernel. Tries
+// copy_file_range first and falls back to sendfile for older kernels and
+// filesystems which do not support it
+bool
+copy_file_data(int _src, int _dst, size_t _nbytes)
+{
+    bool _use_copy_file_range = true;
+    auto _offset              = off_t{ 0 };
+    while(static_cast<size_t>(_offset) < _nbytes)
+    {
+        auto _remaining = _nbytes - static_cast<size_t>(_offset);
+        auto _ret       = ssize_t{ -1 };
+        if(_use_copy_file_range)
+        {
+            _ret = ::copy_file_range(_src, &_offset, _dst, nullptr, _remaining, 0);
+            if(_ret < 0 && (errno == ENOSYS || errno == EXDEV || errno == EINVAL ||
+                            errno == EOPNOTSUPP))
+            {
+                _use_copy_file_range = false;
+                continue;
+            }
+        }
+        else
+        {
+            _ret = ::sendfile(_dst, _src, &_offset, _remaining);
+        }
+
+        if(_ret < 0 && errno == EINTR) continue;
+        if(_ret <= 0) return false;
+    }
+    return true;
+}
+
+bool
+use_compression()
+{
+    static bool _v = []() {
+        if(config::get_perfetto_compression() != "deflate") return false;
+        if(!compression_available())
+        {
+            ROCPROFSYS_VERBOSE(0, "rocprof-sys was built without zlib support. "
+                                  "ROCPROFSYS_PERFETTO_COMPRESSION will be ignored\n");
+            return false;
+        }
+        return true;
+    }();
+    return _v;
+}
+
+// opens the output file for writing, creating the parent directory if necessary
+int
+open_output_file(const std::string& _filename)
+{
+    auto _dir = filepath::dirname(_filename);
+    if(!_dir.empty() && !filepath::exists(_dir)) filepath::makedir(_dir);
+    return ::open(_filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+}
+
+// moves the temporary trace file to the final output location. A rename is used
+// whenever possible and the data is copied in-kernel when the temporary directory
+// resides on a different filesystem than the output directory
+bool
+move_file(const std::string& _src, const std::string& _dst)
+{
+    auto _dir = filepath::dirname(_dst);
+    if(!_dir.empty() && !filepath::exists(_dir)) filepath::makedir(_dir);
+
+    if(::rename(_src.c_str(), _dst.c_str()) == 0) return true;
+
+    if(errno != EXDEV)
+    {
+        ROCPROFSYS_VERBOSE(-1, "Error renaming '%s' to '%s': %s\n", _src.c_str(),
+                           _dst.c_str(), strerror(errno));
+        return false;
+    }
+
+    int _src_fd = ::open(_src.c_str(), O_RDONLY);
+    if(_src_fd < 0) return false;
+
+    struct stat _src_stat = {};
+    if(::fstat(_src_fd, &_src_stat) != 0)
+    {
+        ::close(_src_fd);
+        return false;
+    }
+
+    int _dst_fd = open_output_file(_dst);
+    if(_dst_fd < 0)
+    {
+        ::close(_src_fd);
+        return false;
+    }
+
+    auto _success = copy_file_data(_src_fd, _dst_fd, _src_stat.st_size);
+
+    ::close(_src_fd);
+    ::close(_dst_fd);
+
+    if(_success) ::unlink(_src.c_str());
+    return _success;
+}
+
+// writes the trace data provided by the reader into the output file as compressed
+// packets. The reader is invoked with the compressor as the only argument
+template <typename FuncT>
+bool
+write_compressed(const std::string& _filename, FuncT&& _reader,
+                 compressor::stats& _stats)
+{
+    int _fd = open_output_file(_filename);
+    if(_fd < 0) return false;
+
+    auto _compressor = compressor{ _fd };
+    bool _success    = std::forward<FuncT>(_reader)(_compressor);
+    _success         = _compressor.finish() && _success;
+    _stats           = _compressor.get_stats();
+
+    ::close(_fd);
+    return _success;
+}
+
+// compresses an existing file into the output file in fixed-size chunks
+bool
+compress_file(const std::string& _src, const std::string& _dst,
+              compressor::stats& _stats)
+{
+    int _src_fd = ::open(_src.c_str(), O_RDONLY);
+    if(_src_fd < 0) return false;
+
+    auto _success = write_compressed(
+        _dst,
+        [_src_fd](compressor& _compressor) {
+            auto _buffer = std::vector<char>(4 * units::MB);
+            while(true)
+            {
+                auto _ret = ::read(_src_fd, _buffer.data(), _buffer.size());
+                if(_ret < 0 && errno == EINTR) continue;
+                if(_ret < 0) return false;
+                if(_ret == 0) return true;
+                if(!_compressor.write(_buffer.data(), _ret)) return false;
+            }
+        },
+        _stats);
+
+    ::close(_src_fd);
+    return _success;
+}
+
+void
+report_compression(const compressor::stats& _stats)
+{
+    ROCPROFSYS_VERBOSE(0,
+                       "perfetto trace compressed from %.2f MB to %.2f MB (ratio: "
+                       "%.2fx, throughput: %.2f MB/s, packet batches: %zu)\n",
+                       static_cast<double>(_stats.bytes_in) / units::MB,
+                       static_cast<double>(_stats.bytes_out) / units::MB, _stats.ratio(),
+                       _stats.throughput(), _stats.batches);
+}
+
+// compresses the remaining session data into the temporary file and flushes the
+// compressor. Afterwards, the temporary file holds the complete compressed trace
+bool
+finish_session_compressor(::perfetto::TracingSession* _session,
+                          std::unique_ptr<session_compressor> _sink,
+                          compressor::stats& _stats, segment_cut* _cut = nullptr)
+{
+    if(!_sink) return false;
+    if(_session) compress_session_data(_session, *_sink, _cut);
+    auto _success = _sink->finish();
+    _stats        = _sink->impl.get_stats();
+    return _success;
+}
+
+// finalizes the trace by appending the remaining session data to the temporary
+// file and moving it into place. When the session data is compressed while tracing,
+// the remaining data is compressed into the temporary file before it is moved.
+// Returns false if the temporary file is not available and the trace data needs to
+// be read into memory
+bool
+finalize_tmp_file(::perfetto::TracingSession*         _session,
+                  const std::shared_ptr<tmp_file>&    _tmp_file,
+                  std::unique_ptr<session_compressor> _sink, const std::string& _filename,
+                  tim::manager* _timemory_manager, bool& _perfetto_output_error,
+                  segment_cut* _cut = nullptr)
+{
+    if(!_tmp_file || !*_tmp_file || !_session) return false;
+
+    _tmp_file->close();
+
+    auto _stats      = compressor::stats{};
+    auto _compressed = (_sink != nullptr);
+    if(_compressed)
+    {
+        if(!finish_session_compressor(_session, std::move(_sink), _stats, _cut))
+        {
+            ROCPROFSYS_VERBOSE(-1, "Error! perfetto trace data could not be compressed "
+                                   "into the temp trace file '%s'\n",
+                               _tmp_file->filename.c_str());
+            _perfetto_output_error = true;
+        }
+    }
+    else
+    {
+        int _fd = ::open(_tmp_file->filename.c_str(), O_WRONLY | O_APPEND);
+        if(_fd < 0)
+        {
+            ROCPROFSYS_VERBOSE(
+                -1, "Error! perfetto temp trace file '%s' could not be opened\n",
+                _tmp_file->filename.c_str());
+            return false;
+        }
+
+        append_session_data(_session, _fd, _cut);
+        ::close(_fd);
+    }
+
+    struct stat _tmp_stat = {};
+    auto        _nbytes   = (::stat(_tmp_file->filename.c_str(), &_tmp_stat) == 0)
+                                ? static_cast<size_t>(_tmp_stat.st_size)
+                                : size_t{ 0 };
+
+    if(_nbytes == 0)
+    {
+        if(dmp::rank() == 0)
+            ROCPROFSYS_VERBOSE(
+                0, "perfetto trace data is empty. File '%s' will not be written...\n",
+                _filename.c_str());
+        return true;
+    }
+
+    {
+        operation::file_output_message<tim::project::rocprofsys> _fom{};
+        if(config::get_verbose() >= 0)
+            _fom(_filename, std::string{ "perfetto" },
+                 " (%.2f KB / %.2f MB / %.2f GB)... ",
+                 static_cast<double>(_nbytes) / units::KB,
+                 static_cast<double>(_nbytes) / units::MB,
+                 static_cast<double>(_nbytes) / units::GB);
+
+        // the temporary file is only compressed here if its compressor could not be
+        // opened when the session was started
+        auto _success = (use_compression() && !_compressed)
+                            ? compress_file(_tmp_file->filename, _filename, _stats)
+                            : move_file(_tmp_file->filename, _filename);
+
+        if(!_success)
+        {
+            _fom.append("Error writing '%s' from '%s'...", _filename.c_str(),
+                        _tmp_file->filename.c_str());
+            _perfetto_output_error = true;
+        }
+        else
+        {
+            if(config::get_verbose() >= 0) _fom.append("%s", "Done");  // NOLINT
+            if(_timemory_manager)
+                _timemory_manager->add_file_output("protobuf", "perfetto", _filename);
+        }
+    }
+
+    if(use_compression()) report_compression(_stats);
+
+    return true;
+}
+
+// writes trace data which has been read into memory to the output file. The data is
+// compressed unless it already consists of compressed packets
+void
+write_trace_data(const std::vector<char>& _data, const std::string& _filename,
+                 tim::manager* _timemory_manager, bool& _perfetto_output_error,
+                 bool _compress = use_compression())
+{
+    if(_data.empty())
+    {
+        if(dmp::rank() == 0)
+            ROCPROFSYS_VERBOSE(
+                0, "perfetto trace data is empty. File '%s' will not be written...\n",
+                _filename.c_str());
+        return;
+    }
+
+    auto _stats = compressor::stats{};
+    {
+        operation::file_output_message<tim::project::rocprofsys> _fom{};
+        // Write the trace into a file.
+        if(config::get_verbose() >= 0)
+            _fom(_filename, std::string{ "perfetto" },
+                 " (%.2f KB / %.2f MB / %.2f GB)... ",
+                 static_cast<double>(_data.size()) / units::KB,
+                 static_cast<double>(_data.size()) / units::MB,
+                 static_cast<double>(_data.size()) / units::GB);
+
+        bool _success = false;
+        if(_compress)
+        {
+            auto _write = [&_data](compressor& _compressor) {
+                return _compressor.write(_data.data(), _data.size());
+            };
+            _success = write_compressed(_filename, _write, _stats);
+        }
+        else
+        {
+            std::ofstream ofs{};
+            if(filepath::open(ofs, _filename, std::ios::out | std::ios::binary))
+            {
+                ofs.write(_data.data(), _data.size());
+                _success = ofs.good();
+            }
+            ofs.close();
+        }
+
+        if(!_success)
+        {
+            _fom.append("Error writing '%s'...", _filename.c_str());
+            _perfetto_output_error = true;
+        }
+        else
+        {
+            if(config::get_verbose() >= 0) _fom.append("%s", "Done");  // NOLINT
+            if(_timemory_manager)
+                _timemory_manager->add_file_output("protobuf", "perfetto", _filename);
+        }
+    }
+
+    if(_compress) report_compression(_stats);
+}
+
+// writes a stopped tracing session to the given file and releases its temporary file.
+// The events of a rotated segment which were recorded by the adjacent segments are
+// removed by its cut
+void
+write_session(::perfetto::TracingSession* _session, std::shared_ptr<tmp_file> _tmp_file,
+              std::unique_ptr<session_compressor> _sink, const std::string& _filename,
+              tim::manager* _timemory_manager, bool& _perfetto_output_error,
+              std::unique_ptr<segment_cut> _cut = {})
+{
+    if(!finalize_tmp_file(_session, _tmp_file, std::move(_sink), _filename,
+                          _timemory_manager, _perfetto_output_error, _cut.get()))
+    {
+        if(_cut)
+        {
+            auto _data = std::move(_cut->data);
+            auto _rest = _session->ReadTraceBlocking();
+            (*_cut)(_rest.data(), _rest.size(), [&_data](const char* _v, size_t _n) {
+                _data.insert(_data.end(), _v, _v + _n);
+                return true;
+            });
+            write_trace_data(_data, _filename, _timemory_manager,
+                             _perfetto_output_error);
+        }
+        else
+        {
+            write_trace_data(std::vector<char>{ _session->ReadTraceBlocking() },
+                             _filename, _timemory_manager, _perfetto_output_error);
+        }
+    }
+
+    if(_cut && _cut->removed > 0)
+        ROCPROFSYS_VERBOSE(2,
+                           "%zu track events recorded by the adjacent segments were "
+                           "removed from '%s'\n",
+                           _cut->removed, _filename.c_str());
+
+    if(_tmp_file)
+    {
+        _tmp_file->close();
+        _tmp_file->remove();
+    }
+}
+
+// opens the compressor which compresses the session data into the temporary file
+// while the session is running
+std::unique_ptr<session_compressor>
+open_session_compressor(const std::shared_ptr<tmp_file>& _tmp_file)
+{
+    if(!use_compression() || !_tmp_file || !*_tmp_file) return nullptr;
+
+    auto _sink = std::make_unique<session_compressor>(_tmp_file->filename);
+    if(_sink->fd < 0)
+    {
+        ROCPROFSYS_VERBOSE(0,
+                           "perfetto temp trace file '%s' could not be opened for "
+                           "compression. The trace will be compressed at finalization\n",
+                           _tmp_file->filename.c_str());
+        return nullptr;
+    }
+    return _sink;
+}
+
+// the session data is compressed into the temporary file by the background thread
+// every ROCPROFSYS_PERFETTO_FILE_WRITE_PERIOD_MS
+bool
+use_periodic_compression()
+{
+    return (use_compression() && config::get_use_tmp_files() &&
+            config::get_perfetto_file_write_period() > 0);
+}
+
+// the uncompressed session data of a rotated trace is appended to the temporary file
+// by the background thread every ROCPROFSYS_PERFETTO_FILE_WRITE_PERIOD_MS since the
+// tracing service cannot cut the segments when it writes into the file
+bool
+use_periodic_append()
+{
+    return (use_rotation() && !use_compression() && config::get_use_tmp_files() &&
+            config::get_perfetto_file_write_period() > 0);
+}
+
+// reads the data held by the current session through its cut into the temporary file,
+// the compressor or, without a temporary file, the cut itself
+void
+drain_session()
+{
+    auto& _session = get_session();
+    auto& _tmp     = get_perfetto_tmp_file();
+    auto& _sink    = get_session_compressor();
+    auto* _cut     = get_segment_cut().get();
+
+    if(!_session || !_cut) return;
+
+    if(_sink)
+        compress_session_data(_session.get(), *_sink, _cut);
+    else if(_tmp && *_tmp)
+        append_session_data(_session.get(), _tmp->fd, _cut);
+    else
+        read_session_data(
+            _session.get(),
+            [_cut](const char* _data, size_t _size) {
+                _cut->data.insert(_cut->data.end(), _data, _data + _size);
+                return true;
+            },
+            _cut);
+}
+
+// starts a new tracing session for the next segment, switches to it and then stops
+// the previous session and writes it out. The previous session keeps recording until
+// the next session has started so that no events are lost during the switch and the
+// current session is never null. The events recorded by both sessions are split at
+// the switch timestamp by the cuts of the two segments (see segment_cut). Since the
+// new session is a new instance of the track event data source, it emits its own track
+// descriptors and interned data. The session, the temporary file, the compressor and
+// the cut are swapped while holding the writer mutex
+void
+rotate(writer_data& _writer)
+{
+    auto _segment = size_t{ 0 };
+    {
+        std::unique_lock<std::mutex> _lk{ _writer.mutex };
+        _segment = _writer.segment;
+    }
+
+    auto _next_tmp =
+        config::get_tmp_file(JOIN('-', "perfetto-trace", _segment + 1), "proto");
+    if(_next_tmp) _next_tmp->fopen("w+");
+    auto _next_sink = open_session_compressor(_next_tmp);
+    auto _next_cut  = std::make_unique<segment_cut>();
+
+    auto _next = ::perfetto::Tracing::NewTrace();
+    _next->Setup(get_config(), -1);
+    _next->StartBlocking();
+
+    auto _switch     = tim::get_clock_real_now<uint64_t, std::nano>();
+    _next_cut->begin = _switch;
+
+    auto _prev      = std::unique_ptr<::perfetto::TracingSession>{};
+    auto _prev_tmp  = std::shared_ptr<tmp_file>{};
+    auto _prev_sink = std::unique_ptr<session_compressor>{};
+    auto _prev_cut  = std::unique_ptr<segment_cut>{};
+    {
+        std::unique_lock<std::mutex> _lk{ _writer.mutex };
+        _prev           = std::exchange(get_session(), std::move(_next));
+        _prev_tmp       = std::exchange(get_perfetto_tmp_file(), std::move(_next_tmp));
+        _prev_sink      = std::exchange(get_session_compressor(), std::move(_next_sink));
+        _prev_cut       = std::exchange(get_segment_cut(), std::move(_next_cut));
+        _writer.segment = _segment + 1;
+    }
+
+    if(!_prev_cut) _prev_cut = std::make_unique<segment_cut>();
+    _prev_cut->end = _switch;
+
+    ::perfetto::TrackEvent::Flush();
+    _prev->FlushBlocking();
+    get_total_buffer_stats() += get_buffer_stats(_prev.get());
+    _prev->StopBlocking();
+
+    // every event which the next session holds at this point was also recorded by the
+    // previous session if it happened before the switch
+    get_session()->FlushBlocking();
+    drain_session();
+    get_segment_cut()->begin = 0;
+
+    ROCPROFSYS_VERBOSE(1, "Rotating perfetto trace to segment %zu...\n", _segment + 1);
+
+    auto _filename =
+        get_segment_filename(config::get_perfetto_output_filename(), _segment);
+
+    bool _error = false;
+    write_session(_prev.get(), std::move(_prev_tmp), std::move(_prev_sink), _filename,
+                  nullptr, _error, std::move(_prev_cut));
+
+    std::unique_lock<std::mutex> _lk{ _writer.mutex };
+    if(_error)
+        _writer.error = true;
+    else
+        _writer.filenames.emplace_back(_filename);
+}
+
+void
+writer_loop()
+{
+    threading::offset_this_id(true);
+    threading::set_thread_name("omni.perfetto");
+
+    ROCPROFSYS_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+    using clock_type    = std::chrono::steady_clock;
+    using duration_type = std::chrono::duration<double>;
+
+    auto& _writer   = get_writer_data();
+    auto  _size     = uint64_t{ config::get_perfetto_rotate_size() } * units::MB;
+    auto  _seconds  = duration_type{ config::get_perfetto_rotate_seconds() };
+    auto  _rotation = use_rotation();
+    auto  _compress = use_periodic_compression();
+    auto  _append   = use_periodic_append();
+    auto  _period   = std::chrono::milliseconds(config::get_perfetto_file_write_period());
+    auto  _interval = std::chrono::milliseconds{ 250 };
+    auto  _beg      = clock_type::now();
+
+    if((_compress || _append) && (!_rotation || _period < _interval))
+        _interval = _period;
+
+    // the mutex is not held while the session data is read or the files are rotated
+    // so that stop_writer() is not blocked for the duration
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> _lk{ _writer.mutex };
+            _writer.cv.wait_for(_lk, _interval, [&_writer]() { return !_writer.active; });
+            if(!_writer.active) break;
+        }
+        if(get_state() != State::Active) continue;
+
+        if(_rotation && (_compress || _append))
+            drain_session();
+        else if(_compress && get_session() && get_session_compressor())
+            compress_session_data(get_session().get(), *get_session_compressor());
+
+        if(!_rotation) continue;
+
+        auto _now    = clock_type::now();
+        bool _rotate = (_seconds.count() > 0.0 && (_now - _beg) >= _seconds);
+        if(!_rotate && _size > 0)
+            _rotate = (get_buffer_stats(get_session().get()).bytes_written >= _size);
+
+        if(_rotate)
+        {
+            rotate(_writer);
+            _beg = clock_type::now();
+        }
+    }
+}
+
+void
+start_writer()
+{
+    auto& _writer = get_writer_data();
+
+    std::unique_lock<std::mutex> _lk{ _writer.mutex };
+    if(_writer.active) return;
+
+    if(use_rotation())
+    {
+        ROCPROFSYS_VERBOSE(
+            1, "Rotating perfetto trace files every %zu MB and/or %.3f seconds\n",
+            config::get_perfetto_rotate_size(), config::get_perfetto_rotate_seconds());
+    }
+
+    if(use_periodic_compression())
+    {
+        ROCPROFSYS_VERBOSE(1, "Compressing the perfetto trace data every %lu ms\n",
+                           static_cast<unsigned long>(
+                               config::get_perfetto_file_write_period()));
+    }
+
+    _writer.active = true;
+    _writer.thread = std::thread{ &writer_loop };
+}
+
+void
+stop_writer()
+{
+    auto& _writer = get_writer_data();
+    {
+        std::unique_lock<std::mutex> _lk{ _writer.mutex };
+        if(!_writer.active) return;
+        _writer.active = false;
+    }
+    _writer.cv.notify_all();
+    if(_writer.thread.joinable()) _writer.thread.join();
+}
 }  // namespace
 
 void
@@ -84,6 +1197,31 @@ setup()
     buffer_config->set_size_kb(buffer_size);
     buffer_config->set_fill_policy(_policy);
 
+    // stream the central buffer into the (temporary) trace file
+    auto _write_period = config::get_perfetto_file_write_period();
+    auto _flush_period = config::get_perfetto_flush_period();
+    if(_write_period > 0)
+    {
+        if(config::get_use_tmp_files())
+        {
+            // with compression or rotation, the background writer thread reads the
+            // buffer into the temporary file at this interval instead
+            if(!use_compression() && !use_rotation())
+            {
+                cfg.set_write_into_file(true);
+                cfg.set_file_write_period_ms(_write_period);
+            }
+        }
+        else
+        {
+            ROCPROFSYS_VERBOSE_F(0, "ROCPROFSYS_PERFETTO_FILE_WRITE_PERIOD_MS requires "
+                                    "ROCPROFSYS_USE_TEMPORARY_FILES=ON. Trace data "
+                                    "will be kept in memory until finalization\n");
+        }
+    }
+
+    if(_flush_period > 0) cfg.set_flush_period_ms(_flush_period);
+
     for(const auto& itr : config::get_disabled_categories())
     {
         ROCPROFSYS_VERBOSE_F(1, "Disabling perfetto track event category: %s\n",
@@ -91,6 +1229,9 @@ setup()
         track_event_cfg.add_disabled_categories(itr);
     }
 
+    // the rotated segments are cut at the absolute timestamps of the track events
+    if(use_rotation()) track_event_cfg.set_disable_incremental_timestamps(true);
+
     auto* ds_cfg = cfg.add_data_sources()->mutable_config();
     ds_cfg->set_name("track_event");  // this MUST be track_event
     ds_cfg->set_track_event_config_raw(track_event_cfg.SerializeAsString());
@@ -129,11 +1270,19 @@ start()
         }
     }
 
+    auto& _sink = get_session_compressor();
+    if(!_sink) _sink = open_session_compressor(_tmp_file);
+
+    auto& _cut = get_segment_cut();
+    if(!_cut && use_rotation()) _cut = std::make_unique<segment_cut>();
+
     ROCPROFSYS_VERBOSE(2, "Setup perfetto...\n");
-    int   _fd = (_tmp_file) ? _tmp_file->fd : -1;
+    int   _fd = (_tmp_file && !_sink && !_cut) ? _tmp_file->fd : -1;
     auto& cfg = get_config();
     tracing_session->Setup(cfg, _fd);
     tracing_session->StartBlocking();
+
+    if(use_rotation() || use_periodic_compression()) start_writer();
 }
 
 void
@@ -141,6 +1290,8 @@ stop()
 {
     if(is_system_backend()) return;
 
+    stop_writer();
+
     auto& tracing_session = get_perfetto_session();
 
     ROCPROFSYS_CI_THROW(tracing_session == nullptr,
@@ -153,6 +1304,10 @@ stop()
         ::perfetto::TrackEvent::Flush();
         tracing_session->FlushBlocking();
 
+        // the statistics are no longer available once the session is stopped
+        get_total_buffer_stats() += get_buffer_stats(tracing_session.get());
+        report_buffer_stats(get_total_buffer_stats());
+
         ROCPROFSYS_VERBOSE(2, "Stopping the perfetto trace session (blocking)...\n");
         tracing_session->StopBlocking();
     }
@@ -168,6 +1323,58 @@ post_process(tim::manager* _timemory_manager, bool& _perfetto_output_error)
     auto& tracing_session = get_perfetto_session();
     if(!tracing_session) return;
 
+    auto _filename = config::get_perfetto_output_filename();
+
+    // when the trace files are rotated, each rank writes its own final segment
+    if(use_rotation())
+    {
+        auto& _writer = get_writer_data();
+        write_session(tracing_session.get(), std::move(get_perfetto_tmp_file()),
+                      std::move(get_session_compressor()),
+                      get_segment_filename(_filename, _writer.segment), _timemory_manager,
+                      _perfetto_output_error, std::move(get_segment_cut()));
+        if(_timemory_manager)
+        {
+            for(const auto& itr : _writer.filenames)
+                _timemory_manager->add_file_output("protobuf", "perfetto", itr);
+        }
+        if(_writer.error) _perfetto_output_error = true;
+        return;
+    }
+
+    auto _cleanup_tmp_file = []() {
+        auto& _tmp_file = get_perfetto_tmp_file();
+        if(_tmp_file)
+        {
+            _tmp_file->close();
+            _tmp_file->remove();
+            _tmp_file.reset();
+        }
+    };
+
+    // when the trace is not combined across ranks, finalize the temporary file in
+    // place so that peak memory is independent of the size of the trace
+    if(!get_perfetto_combined_traces() &&
+       finalize_tmp_file(tracing_session.get(), get_perfetto_tmp_file(),
+                         std::move(get_session_compressor()), _filename,
+                         _timemory_manager, _perfetto_output_error))
+    {
+        _cleanup_tmp_file();
+        return;
+    }
+
+    // the data which was compressed into the temporary file while tracing is completed
+    // there and is not compressed again when it is written
+    bool _precompressed = (get_session_compressor() != nullptr);
+    if(_precompressed)
+    {
+        auto _stats = compressor::stats{};
+        if(!finish_session_compressor(tracing_session.get(),
+                                      std::move(get_session_compressor()), _stats))
+            _perfetto_output_error = true;
+        report_compression(_stats);
+    }
+
     auto _get_session_data = [&tracing_session]() {
         auto _data     = char_vec_t{};
         auto _tmp_file = get_perfetto_tmp_file();
@@ -188,7 +1395,7 @@ post_process(tim::manager* _timemory_manager, bool& _perfetto_output_error)
             size_t _fnum_elem = ftell(_fdata);
             fseek(_fdata, 0, SEEK_SET);  // same as rewind(f);
 
-            _data.resize(_fnum_elem + 1);
+            _data.resize(_fnum_elem);
             auto _fnum_read = fread(_data.data(), sizeof(char), _fnum_elem, _fdata);
             fclose(_fdata);
 
@@ -231,47 +1438,10 @@ post_process(tim::manager* _timemory_manager, bool& _perfetto_output_error)
     trace_data = _get_session_data();
 #endif
 
-    auto _filename = config::get_perfetto_output_filename();
-    if(!trace_data.empty())
-    {
-        operation::file_output_message<tim::project::rocprofsys> _fom{};
-        // Write the trace into a file.
-        if(config::get_verbose() >= 0)
-            _fom(_filename, std::string{ "perfetto" },
-                 " (%.2f KB / %.2f MB / %.2f GB)... ",
-                 static_cast<double>(trace_data.size()) / units::KB,
-                 static_cast<double>(trace_data.size()) / units::MB,
-                 static_cast<double>(trace_data.size()) / units::GB);
-        std::ofstream ofs{};
-        if(!filepath::open(ofs, _filename, std::ios::out | std::ios::binary))
-        {
-            _fom.append("Error opening '%s'...", _filename.c_str());
-            _perfetto_output_error = true;
-        }
-        else
-        {
-            // Write the trace into a file.
-            ofs.write(&trace_data[0], trace_data.size());
-            if(config::get_verbose() >= 0) _fom.append("%s", "Done");  // NOLINT
-            if(_timemory_manager)
-                _timemory_manager->add_file_output("protobuf", "perfetto", _filename);
-        }
-        ofs.close();
-    }
-    else if(dmp::rank() == 0)
-    {
-        ROCPROFSYS_VERBOSE(
-            0, "perfetto trace data is empty. File '%s' will not be written...\n",
-            _filename.c_str());
-    }
+    write_trace_data(trace_data, _filename, _timemory_manager, _perfetto_output_error,
+                     use_compression() && !_precompressed);
 
-    auto& _tmp_file = get_perfetto_tmp_file();
-    if(_tmp_file)
-    {
-        _tmp_file->close();
-        _tmp_file->remove();
-        _tmp_file.reset();
-    }
+    _cleanup_tmp_file();
 }
 
 }  // namespace perfetto
@@ -0,0 +1,454 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "perfetto_compression.hpp"
+#include "common.hpp"
+#include "debug.hpp"
+#include "state.hpp"
+
+#include <timemory/units.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <unistd.h>
+
+#if defined(ROCPROFSYS_USE_ZLIB) && ROCPROFSYS_USE_ZLIB > 0
+#    include <zlib.h>
+#endif
+
+namespace rocprofsys
+{
+namespace perfetto
+{
+namespace units = ::tim::units;
+
+namespace
+{
+// field number of Trace.packet and TracePacket.compressed_packets, respectively
+constexpr uint32_t trace_packet_field       = 1;
+constexpr uint32_t compressed_packets_field = 50;
+constexpr uint32_t length_delimited_type    = 2;
+constexpr size_t   invalid_record           = std::numeric_limits<size_t>::max();
+constexpr size_t   max_record_header_size   = 20;  // tag and length varints
+
+#if defined(ROCPROFSYS_USE_ZLIB) && ROCPROFSYS_USE_ZLIB > 0
+// zlib stores the input and output sizes of a deflate call as 32-bit uInt. The batch
+// is limited to half of the range so that deflateBound() of a batch fits as well
+constexpr size_t max_deflate_size = std::numeric_limits<uInt>::max() / 2;
+#else
+constexpr size_t max_deflate_size = std::numeric_limits<uint32_t>::max() / 2;
+#endif
+
+bool
+read_varint(const uint8_t* _data, size_t _size, size_t& _pos, uint64_t& _value)
+{
+    _value = 0;
+    for(uint32_t _shift = 0; _shift < 64; _shift += 7)
+    {
+        if(_pos >= _size) return false;
+        auto _byte = _data[_pos++];
+        _value |= static_cast<uint64_t>(_byte & 0x7f) << _shift;
+        if((_byte & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+size_t
+write_varint(uint8_t* _data, uint64_t _value)
+{
+    size_t _n = 0;
+    while(_value >= 0x80)
+    {
+        _data[_n++] = static_cast<uint8_t>(_value | 0x80);
+        _value >>= 7;
+    }
+    _data[_n++] = static_cast<uint8_t>(_value);
+    return _n;
+}
+
+// returns the size of the protobuf record at the start of the buffer once its header
+// is available (the record itself may be incomplete), zero if the header is
+// incomplete, or invalid_record if the data cannot be parsed
+size_t
+get_record_extent(const uint8_t* _data, size_t _size)
+{
+    size_t   _pos = 0;
+    uint64_t _tag = 0;
+    uint64_t _val = 0;
+
+    if(!read_varint(_data, _size, _pos, _tag)) return 0;
+    if((_tag >> 3) == 0) return invalid_record;
+
+    switch(_tag & 0x7)
+    {
+        case 0:
+            if(!read_varint(_data, _size, _pos, _val)) return 0;
+            break;
+        case 1: _pos += 8; break;
+        case 2:
+            if(!read_varint(_data, _size, _pos, _val)) return 0;
+            if(_val >= invalid_record - _pos) return invalid_record;
+            _pos += _val;
+            break;
+        case 5: _pos += 4; break;
+        default: return invalid_record;
+    }
+
+    return _pos;
+}
+
+// returns the size of the protobuf record at the start of the buffer, zero if the
+// record is incomplete, or invalid_record if the data cannot be parsed
+size_t
+get_record_size(const uint8_t* _data, size_t _size)
+{
+    auto _n = get_record_extent(_data, _size);
+    return (_n == invalid_record || _n <= _size) ? _n : 0;
+}
+
+bool
+write_all(int _fd, const uint8_t* _data, size_t _size)
+{
+    while(_size > 0)
+    {
+        auto _ret = ::write(_fd, _data, _size);
+        if(_ret < 0 && errno == EINTR) continue;
+        if(_ret <= 0) return false;
+        _data += _ret;
+        _size -= _ret;
+    }
+    return true;
+}
+}  // namespace
+
+bool
+compression_available()
+{
+#if defined(ROCPROFSYS_USE_ZLIB) && ROCPROFSYS_USE_ZLIB > 0
+    return true;
+#else
+    return false;
+#endif
+}
+
+double
+compressor::stats::ratio() const
+{
+    return (bytes_out > 0) ? (static_cast<double>(bytes_in) / bytes_out) : 0.0;
+}
+
+double
+compressor::stats::throughput() const
+{
+    return (elapsed_ns > 0) ? (static_cast<double>(bytes_in) / units::MB) /
+                                  (elapsed_ns / units::sec)
+                            : 0.0;
+}
+
+compressor::compressor(int _fd, size_t _batch_size, size_t _max_pending)
+: m_fd{ _fd }
+, m_batch_size{ std::min(std::max<size_t>(_batch_size, 1), max_deflate_size) }
+, m_max_pending{ std::max<size_t>(_max_pending, 1) }
+{
+    m_buffer.reserve(m_batch_size);
+    m_thread = std::thread{ &compressor::run, this };
+}
+
+compressor::~compressor() { finish(); }
+
+bool
+compressor::write(const char* _data, size_t _size)
+{
+    if(m_finished) return false;
+
+    const auto* _bytes = reinterpret_cast<const uint8_t*>(_data);
+    size_t      _off   = 0;
+
+    // complete the packet which was split across the previous and this call. Only the
+    // bytes of that packet are appended to the buffer
+    while(!m_invalid && m_buffer.size() > m_parsed)
+    {
+        const auto* _tail = reinterpret_cast<const uint8_t*>(m_buffer.data()) + m_parsed;
+        auto        _have = m_buffer.size() - m_parsed;
+        auto        _n    = get_record_extent(_tail, _have);
+        if(_n == invalid_record)
+        {
+            set_invalid();
+            break;
+        }
+        if(_n > 0 && _n <= _have)
+        {
+            m_parsed += _n;
+            continue;
+        }
+        if(_off == _size) break;
+
+        auto _need = (_n == 0) ? max_record_header_size : (_n - _have);
+        _need      = std::min(_need, _size - _off);
+        m_buffer.append(_data + _off, _need);
+        _off += _need;
+    }
+
+    if(m_parsed >= m_batch_size) enqueue_parsed();
+
+    // the complete packets are compressed in batches of (at most) the batch size which
+    // are split at packet boundaries. The packets are parsed in place and each batch is
+    // copied once into the buffer of the background thread
+    if(!m_invalid && m_buffer.size() == m_parsed)
+    {
+        size_t _beg = _off;
+        while(_off < _size)
+        {
+            auto _n = get_record_size(_bytes + _off, _size - _off);
+            if(_n == 0) break;
+            if(_n == invalid_record)
+            {
+                set_invalid();
+                break;
+            }
+
+            auto _batch_size = m_parsed + (_off - _beg);
+            if(_batch_size > 0 && _batch_size + _n > m_batch_size)
+            {
+                m_buffer.append(_data + _beg, _off - _beg);
+                m_parsed += (_off - _beg);
+                _beg = _off;
+                enqueue_parsed();
+            }
+            _off += _n;
+        }
+        m_buffer.append(_data + _beg, _off - _beg);
+        m_parsed += (_off - _beg);
+        if(m_parsed >= m_batch_size) enqueue_parsed();
+    }
+
+    if(m_invalid)
+    {
+        // once the packet boundaries are lost, the remainder of the stream (which
+        // starts at a packet boundary) is written as-is since compressing it would
+        // split packets across batches
+        enqueue_parsed();
+        if(!m_buffer.empty()) enqueue(batch{ true, std::move(m_buffer) });
+        m_buffer = std::string{};
+        for(; _off < _size; _off += std::min(m_batch_size, _size - _off))
+        {
+            auto _n = std::min(m_batch_size, _size - _off);
+            enqueue(batch{ true, std::string{ _data + _off, _n } });
+        }
+    }
+    else if(_off < _size)
+    {
+        // the start of a packet which is completed by the next call
+        m_buffer.append(_data + _off, _size - _off);
+    }
+
+    std::unique_lock<std::mutex> _lk{ m_mutex };
+    return !m_error;
+}
+
+void
+compressor::set_invalid()
+{
+    ROCPROFSYS_VERBOSE(0, "Unable to locate perfetto packet boundaries. Remaining "
+                          "trace data will be written uncompressed...\n");
+    m_invalid = true;
+}
+
+// moves the complete packets at the start of the buffer into a compressed batch
+void
+compressor::enqueue_parsed()
+{
+    if(m_parsed == 0) return;
+
+    auto _batch = std::string{};
+    if(m_parsed == m_buffer.size())
+    {
+        _batch   = std::move(m_buffer);
+        m_buffer = std::string{};
+        m_buffer.reserve(m_batch_size);
+    }
+    else
+    {
+        _batch = m_buffer.substr(0, m_parsed);
+        m_buffer.erase(0, m_parsed);
+    }
+    m_parsed = 0;
+    enqueue(batch{ false, std::move(_batch) });
+}
+
+bool
+compressor::finish()
+{
+    if(m_finished) return !m_error;
+
+    // an incomplete trailing packet is not split from the preceding packets
+    if(!m_buffer.empty()) enqueue(batch{ m_invalid, std::move(m_buffer) });
+    m_buffer.clear();
+    m_parsed = 0;
+
+    {
+        std::unique_lock<std::mutex> _lk{ m_mutex };
+        m_finished = true;
+    }
+    m_cv.notify_all();
+
+    if(m_thread.joinable()) m_thread.join();
+
+    return !m_error;
+}
+
+compressor::stats
+compressor::get_stats() const
+{
+    std::unique_lock<std::mutex> _lk{ m_mutex };
+    return m_stats;
+}
+
+void
+compressor::enqueue(batch&& _batch)
+{
+    {
+        // bound the amount of uncompressed data held in memory
+        std::unique_lock<std::mutex> _lk{ m_mutex };
+        m_cv.wait(_lk, [this]() { return m_pending.size() < m_max_pending || m_error; });
+        m_pending.emplace_back(std::move(_batch));
+    }
+    m_cv.notify_all();
+}
+
+void
+compressor::run()
+{
+    threading::offset_this_id(true);
+    threading::set_thread_name("omni.compress");
+
+    ROCPROFSYS_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+#if defined(ROCPROFSYS_USE_ZLIB) && ROCPROFSYS_USE_ZLIB > 0
+    auto _strm = z_stream{};
+    if(deflateInit(&_strm, Z_DEFAULT_COMPRESSION) != Z_OK)
+    {
+        std::unique_lock<std::mutex> _lk{ m_mutex };
+        m_error = true;
+        m_cv.notify_all();
+        return;
+    }
+
+    auto _output = std::string{};
+    while(true)
+    {
+        auto _batch = batch{};
+        {
+            std::unique_lock<std::mutex> _lk{ m_mutex };
+            m_cv.wait(_lk, [this]() { return !m_pending.empty() || m_finished; });
+            if(m_pending.empty()) break;
+            _batch = std::move(m_pending.front());
+            m_pending.pop_front();
+        }
+        m_cv.notify_all();
+
+        // a single packet which exceeds the size limit of a deflate call
+        if(!_batch.raw && _batch.data.size() > max_deflate_size) _batch.raw = true;
+
+        if(_batch.raw)
+        {
+            const auto* _data = reinterpret_cast<const uint8_t*>(_batch.data.data());
+            bool        _ok   = write_all(m_fd, _data, _batch.data.size());
+
+            std::unique_lock<std::mutex> _lk{ m_mutex };
+            m_stats.bytes_in += _batch.data.size();
+            m_stats.bytes_out += _batch.data.size();
+            m_stats.raw_bytes += _batch.data.size();
+            if(!_ok)
+            {
+                ROCPROFSYS_VERBOSE(-1, "Error writing perfetto trace data: %s\n",
+                                   strerror(errno));
+                m_error = true;
+                m_pending.clear();
+                m_cv.notify_all();
+                break;
+            }
+            continue;
+        }
+
+        auto _beg = std::chrono::steady_clock::now();
+
+        deflateReset(&_strm);
+        _output.resize(deflateBound(&_strm, _batch.data.size()));
+        _strm.next_in   = reinterpret_cast<Bytef*>(_batch.data.data());
+        _strm.avail_in  = _batch.data.size();
+        _strm.next_out  = reinterpret_cast<Bytef*>(_output.data());
+        _strm.avail_out = _output.size();
+
+        bool _ok = (deflate(&_strm, Z_FINISH) == Z_STREAM_END);
+        _output.resize(_strm.total_out);
+
+        // Trace.packet { TracePacket.compressed_packets: <deflated packets> }
+        auto   _header  = std::array<uint8_t, 24>{};
+        auto   _inner   = std::array<uint8_t, 12>{};
+        size_t _ninner  = write_varint(_inner.data(), (compressed_packets_field << 3) |
+                                                          length_delimited_type);
+        _ninner        += write_varint(_inner.data() + _ninner, _output.size());
+        size_t _nheader = write_varint(
+            _header.data(), (trace_packet_field << 3) | length_delimited_type);
+        _nheader += write_varint(_header.data() + _nheader, _ninner + _output.size());
+        std::memcpy(_header.data() + _nheader, _inner.data(), _ninner);
+        _nheader += _ninner;
+
+        _ok = _ok && write_all(m_fd, _header.data(), _nheader) &&
+              write_all(m_fd, reinterpret_cast<const uint8_t*>(_output.data()),
+                        _output.size());
+
+        auto _end = std::chrono::steady_clock::now();
+
+        std::unique_lock<std::mutex> _lk{ m_mutex };
+        m_stats.bytes_in += _batch.data.size();
+        m_stats.bytes_out += _nheader + _output.size();
+        m_stats.batches += 1;
+        m_stats.elapsed_ns +=
+            std::chrono::duration_cast<std::chrono::nanoseconds>(_end - _beg).count();
+        if(!_ok)
+        {
+            ROCPROFSYS_VERBOSE(-1, "Error writing compressed perfetto trace data: %s\n",
+                               strerror(errno));
+            m_error = true;
+            m_pending.clear();
+            m_cv.notify_all();
+            break;
+        }
+    }
+
+    deflateEnd(&_strm);
+#else
+    std::unique_lock<std::mutex> _lk{ m_mutex };
+    m_error = true;
+    m_pending.clear();
+    m_cv.notify_all();
+#endif
+}
+}  // namespace perfetto
+}  // namespace rocprofsys
@@ -0,0 +1,101 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace rocprofsys
+{
+namespace perfetto
+{
+/// returns true if rocprof-sys was built with zlib support
+bool
+compression_available();
+
+/// consumes a serialized perfetto trace (in arbitrarily-sized chunks) and writes
+/// it to a file descriptor as TracePacket.compressed_packets. The deflate is
+/// performed on a dedicated background thread so the caller only pays for
+/// locating the packet boundaries. If the packet boundaries cannot be located,
+/// the remainder of the stream is written uncompressed
+struct compressor
+{
+    struct stats
+    {
+        size_t bytes_in   = 0;
+        size_t bytes_out  = 0;
+        size_t batches    = 0;
+        size_t raw_bytes  = 0;  // bytes written without compression
+        double elapsed_ns = 0;
+
+        double ratio() const;
+        double throughput() const;  // MB/s of uncompressed data
+    };
+
+    explicit compressor(int _fd, size_t _batch_size = 1024 * 1024,
+                        size_t _max_pending = 8);
+    ~compressor();
+
+    compressor(const compressor&) = delete;
+    compressor(compressor&&)      = delete;
+    compressor& operator=(const compressor&) = delete;
+    compressor& operator=(compressor&&) = delete;
+
+    bool  write(const char* _data, size_t _size);
+    bool  finish();
+    stats get_stats() const;
+
+private:
+    struct batch
+    {
+        bool        raw  = false;
+        std::string data = {};
+    };
+
+    void enqueue(batch&&);
+    void enqueue_parsed();
+    void set_invalid();
+    void run();
+
+    bool                    m_error       = false;
+    bool                    m_finished    = false;
+    bool                    m_invalid     = false;
+    int                     m_fd          = -1;
+    size_t                  m_batch_size  = 0;
+    size_t                  m_max_pending = 0;
+    size_t                  m_parsed      = 0;
+    std::string             m_buffer      = {};
+    std::deque<batch>       m_pending     = {};
+    stats                   m_stats       = {};
+    mutable std::mutex      m_mutex       = {};
+    std::condition_variable m_cv          = {};
+    std::thread             m_thread      = {};
+};
+}  // namespace perfetto
+}  // namespace rocprofsys
@@ -46,13 +46,16 @@
 
 #include <cassert>
 #include <chrono>
+#include <cstring>
 #include <gnu/libc-version.h>
 #include <link.h>
 #include <linux/limits.h>
+#include <mutex>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <thread>
 #include <unistd.h>
+#include <vector>
 
 //--------------------------------------------------------------------------------------//
 
@@ -309,6 +312,12 @@ struct ROCPROFSYS_INTERNAL_API indirect
                          "rocprofsys_register_source");
         ROCPROFSYS_DLSYM(rocprofsys_register_coverage_f, m_omnihandle,
                          "rocprofsys_register_coverage");
+        ROCPROFSYS_DLSYM(rocprofsys_register_source_index_f, m_omnihandle,
+                         "rocprofsys_register_source_index");
+        ROCPROFSYS_DLSYM(rocprofsys_register_coverage_index_f, m_omnihandle,
+                         "rocprofsys_register_coverage_index");
+        ROCPROFSYS_DLSYM(rocprofsys_register_loop_counters_f, m_omnihandle,
+                         "rocprofsys_register_loop_counters");
         ROCPROFSYS_DLSYM(rocprofsys_progress_f, m_omnihandle, "rocprofsys_progress");
         ROCPROFSYS_DLSYM(rocprofsys_annotated_progress_f, m_omnihandle,
                          "rocprofsys_annotated_progress");
@@ -411,6 +420,11 @@ public:
     void (*rocprofsys_register_source_f)(const char*, const char*, size_t, size_t,
                                          const char*)                          = nullptr;
     void (*rocprofsys_register_coverage_f)(const char*, const char*, size_t)   = nullptr;
+    void (*rocprofsys_register_source_index_f)(const char*, const char*, size_t, size_t,
+                                               const char*, uint32_t*)         = nullptr;
+    void (*rocprofsys_register_coverage_index_f)(uint32_t)                     = nullptr;
+    void (*rocprofsys_register_loop_counters_f)(const char*, const char*, uint64_t*,
+                                                uint64_t*)                     = nullptr;
     void (*rocprofsys_push_trace_f)(const char*)                               = nullptr;
     void (*rocprofsys_pop_trace_f)(const char*)                                = nullptr;
     int (*rocprofsys_push_region_f)(const char*)                               = nullptr;
@@ -553,6 +567,147 @@ get_thread_status()
     return _v;
 }
 
+// enable flags allocated by rocprof-sys-instrument in the instrumented binary. The
+// inserted push/pop calls are skipped when the flag is zero
+auto&
+get_trace_guards()
+{
+    static auto* _v = new std::vector<int*>{};
+    return *_v;
+}
+
+auto&
+get_trace_guards_mutex()
+{
+    static auto* _v = new std::mutex{};
+    return *_v;
+}
+
+void
+update_trace_guards()
+{
+    auto _v = (get_active() && get_enabled().load()) ? 1 : 0;
+
+    std::unique_lock<std::mutex> _lk{ get_trace_guards_mutex() };
+    for(auto* itr : get_trace_guards())
+        __atomic_store_n(itr, _v, __ATOMIC_RELAXED);
+}
+
+// set once a guard is registered. The guard only branches around the push calls: the
+// pop calls always reach this library, which forwards a pop only when the push of the
+// same name on this thread was forwarded. This keeps the regions balanced when the
+// flag changes while a function or loop is in progress
+std::atomic<bool> trace_guarded = { false };
+
+struct guarded_push
+{
+    const char* name      = nullptr;
+    bool        forwarded = false;  // false when the thread was disabled
+};
+
+auto&
+get_guarded_pushes()
+{
+    static thread_local std::vector<guarded_push> _v = {};
+    return _v;
+}
+
+inline bool
+is_trace_guarded()
+{
+    return trace_guarded.load(std::memory_order_relaxed);
+}
+
+// returns whether the push is forwarded
+bool
+push_guarded(const char* _name)
+{
+    if(!get_active()) return false;
+    auto _forward = get_thread_enabled();
+    get_guarded_pushes().emplace_back(guarded_push{ _name, _forward });
+    return _forward;
+}
+
+// returns whether the pop is forwarded. A pop whose push was skipped by the guard does
+// not match the last push of the thread and is dropped. The names are compared by value
+// since the entry and exit snippets pass separate copies of the string
+bool
+pop_guarded(const char* _name)
+{
+    auto& _pushes = get_guarded_pushes();
+    if(_pushes.empty()) return false;
+
+    const auto* _last = _pushes.back().name;
+    if(_last != _name && (!_last || !_name || strcmp(_last, _name) != 0)) return false;
+
+    auto _forward = _pushes.back().forwarded;
+    _pushes.pop_back();
+
+    // same as the unguarded pop: a region pushed before the thread was disabled
+    // re-enables the thread when it ends, but the pop is also forwarded
+    if(_forward && !get_thread_enabled()) get_thread_enabled() = true;
+    return _forward;
+}
+
+// hot entry points bound directly to the librocprof-sys functions. Published once
+// rocprofsys_init succeeded and withdrawn before rocprofsys_finalize. A bound entry point
+// only checks the thread-enabled flag and the re-entrancy guard before the call instead
+// of going through get_active(), get_indirect() and ROCPROFSYS_DL_INVOKE
+struct direct_table
+{
+    void (*push_trace_f)(const char*) = nullptr;
+    void (*pop_trace_f)(const char*)  = nullptr;
+    int (*push_region_f)(const char*) = nullptr;
+    int (*pop_region_f)(const char*)  = nullptr;
+};
+
+direct_table                     direct_bound_table = {};
+std::atomic<const direct_table*> direct_bound       = { nullptr };
+
+void
+bind_direct(bool _bind)
+{
+    // the per-call logging of ROCPROFSYS_DL_INVOKE requires the indirect path
+    if(_bind && get_env("ROCPROFSYS_DL_DIRECT_BIND", true) && _rocprofsys_dl_verbose < 3)
+    {
+        auto& _indirect    = get_indirect();
+        direct_bound_table = { _indirect.rocprofsys_push_trace_f,
+                               _indirect.rocprofsys_pop_trace_f,
+                               _indirect.rocprofsys_push_region_f,
+                               _indirect.rocprofsys_pop_region_f };
+        if(direct_bound_table.push_trace_f && direct_bound_table.pop_trace_f &&
+           direct_bound_table.push_region_f && direct_bound_table.pop_region_f)
+            direct_bound.store(&direct_bound_table, std::memory_order_release);
+    }
+    else
+    {
+        direct_bound.store(nullptr, std::memory_order_release);
+    }
+}
+
+// returns the direct-bound entry points when the calling thread is enabled
+inline const direct_table*
+get_direct_bound()
+{
+    const auto* _v = direct_bound.load(std::memory_order_acquire);
+    return (ROCPROFSYS_LIKELY(_v != nullptr) && get_thread_enabled()) ? _v : nullptr;
+}
+
+// same re-entrancy guard as ROCPROFSYS_DL_INVOKE without the logging
+template <typename FuncT, typename... Args>
+inline auto
+invoke_direct(FuncT _func, Args... _args)
+{
+    struct decrement_guard
+    {
+        ~decrement_guard() { --common::get_guard(); }
+    } _unlk{};
+
+    using return_type = decltype(_func(_args...));
+    if(common::get_guard()++ == 0) return _func(_args...);
+    if constexpr(!std::is_void<return_type>::value) return return_type();
+}
+
 InstrumentMode&
 get_instrumented()
 {
@@ -649,6 +804,8 @@ extern "C"
             dl::get_active()           = true;
             dl::get_inited()           = true;
             dl::_rocprofsys_dl_verbose = dl::get_rocprofsys_dl_env();
+            dl::update_trace_guards();
+            dl::bind_direct(true);
             if(dl::get_instrumented() < dl::InstrumentMode::PythonProfile)
                 dl::rocprofsys_postinit((c) ? std::string{ c } : std::string{});
         }
@@ -669,17 +826,25 @@ extern "C"
             return;
         }
 
+        dl::bind_direct(false);
+
         bool _invoked = false;
         ROCPROFSYS_DL_INVOKE_STATUS(_invoked, get_indirect().rocprofsys_finalize_f);
         if(_invoked)
         {
             dl::get_active() = false;
             dl::get_finied() = true;
+            dl::update_trace_guards();
         }
     }
 
     void rocprofsys_push_trace(const char* name)
     {
+        if(ROCPROFSYS_UNLIKELY(dl::is_trace_guarded()) && !dl::push_guarded(name)) return;
+
+        if(const auto* _direct = dl::get_direct_bound())
+            return dl::invoke_direct(_direct->push_trace_f, name);
+
         if(!dl::get_active()) return;
         if(dl::get_thread_enabled())
         {
@@ -693,6 +858,11 @@ extern "C"
 
     void rocprofsys_pop_trace(const char* name)
     {
+        if(ROCPROFSYS_UNLIKELY(dl::is_trace_guarded()) && !dl::pop_guarded(name)) return;
+
+        if(const auto* _direct = dl::get_direct_bound())
+            return dl::invoke_direct(_direct->pop_trace_f, name);
+
         if(!dl::get_active()) return;
         if(dl::get_thread_enabled())
         {
@@ -706,6 +876,9 @@ extern "C"
 
     int rocprofsys_push_region(const char* name)
     {
+        if(const auto* _direct = dl::get_direct_bound())
+            return dl::invoke_direct(_direct->push_region_f, name);
+
         if(!dl::get_active()) return 0;
         if(dl::get_thread_enabled())
         {
@@ -720,6 +893,9 @@ extern "C"
 
     int rocprofsys_pop_region(const char* name)
     {
+        if(const auto* _direct = dl::get_direct_bound())
+            return dl::invoke_direct(_direct->pop_region_f, name);
+
         if(!dl::get_active()) return 0;
         if(dl::get_thread_enabled())
         {
@@ -803,15 +979,52 @@ extern "C"
                              address);
     }
 
+    void rocprofsys_register_source_index(const char* file, const char* func,
+                                          size_t line, size_t address,
+                                          const char* source, uint32_t* index)
+    {
+        ROCPROFSYS_DL_LOG(3, "%s(\"%s\", \"%s\", %zu, %zu, \"%s\")\n", __FUNCTION__,
+                          file, func, line, address, source);
+        ROCPROFSYS_DL_INVOKE(get_indirect().rocprofsys_register_source_index_f, file,
+                             func, line, address, source, index);
+    }
+
+    void rocprofsys_register_coverage_index(uint32_t index)
+    {
+        ROCPROFSYS_DL_INVOKE(get_indirect().rocprofsys_register_coverage_index_f, index);
+    }
+
+    void rocprofsys_register_loop_counters(const char* func, const char* loop,
+                                           uint64_t* entries, uint64_t* iterations)
+    {
+        ROCPROFSYS_DL_LOG(3, "%s(\"%s\", \"%s\")\n", __FUNCTION__, func, loop);
+        ROCPROFSYS_DL_INVOKE(get_indirect().rocprofsys_register_loop_counters_f, func,
+                             loop, entries, iterations);
+    }
+
+    void rocprofsys_register_trace_guard(int* guard)
+    {
+        if(!guard) return;
+        ROCPROFSYS_DL_LOG(3, "%s(%p)\n", __FUNCTION__, static_cast<void*>(guard));
+        {
+            std::unique_lock<std::mutex> _lk{ dl::get_trace_guards_mutex() };
+            dl::get_trace_guards().emplace_back(guard);
+        }
+        dl::trace_guarded.store(true);
+        dl::update_trace_guards();
+    }
+
     int rocprofsys_user_start_trace_dl(void)
     {
         dl::get_enabled().store(true);
+        dl::update_trace_guards();
         return rocprofsys_user_start_thread_trace_dl();
     }
 
     int rocprofsys_user_stop_trace_dl(void)
     {
         dl::get_enabled().store(false);
+        dl::update_trace_guards();
         return rocprofsys_user_stop_thread_trace_dl();
     }
 
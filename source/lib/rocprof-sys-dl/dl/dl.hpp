@@ -93,6 +93,15 @@ extern "C"
                                     const char* source) ROCPROFSYS_PUBLIC_API;
     void rocprofsys_register_coverage(const char* file, const char* func,
                                       size_t address) ROCPROFSYS_PUBLIC_API;
+    void rocprofsys_register_source_index(const char* file, const char* func,
+                                          size_t line, size_t address,
+                                          const char* source,
+                                          uint32_t*   index) ROCPROFSYS_PUBLIC_API;
+    void rocprofsys_register_coverage_index(uint32_t index) ROCPROFSYS_PUBLIC_API;
+    void rocprofsys_register_loop_counters(const char* func, const char* loop,
+                                           uint64_t* entries,
+                                           uint64_t* iterations) ROCPROFSYS_PUBLIC_API;
+    void rocprofsys_register_trace_guard(int* guard) ROCPROFSYS_PUBLIC_API;
     void rocprofsys_progress(const char*) ROCPROFSYS_PUBLIC_API;
     void rocprofsys_annotated_progress(const char*, rocprofsys_annotation_t*,
                                        size_t) ROCPROFSYS_PUBLIC_API;
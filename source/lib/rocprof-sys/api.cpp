@@ -167,3 +167,23 @@ rocprofsys_register_coverage(const char* file, const char* func, size_t address)
 {
     rocprofsys_register_coverage_hidden(file, func, address);
 }
+
+extern "C" void
+rocprofsys_register_source_index(const char* file, const char* func, size_t line,
+                                 size_t address, const char* source, uint32_t* index)
+{
+    rocprofsys_register_source_index_hidden(file, func, line, address, source, index);
+}
+
+extern "C" void
+rocprofsys_register_coverage_index(uint32_t index)
+{
+    rocprofsys_register_coverage_index_hidden(index);
+}
+
+extern "C" void
+rocprofsys_register_loop_counters(const char* func, const char* loop, uint64_t* entries,
+                                  uint64_t* iterations)
+{
+    rocprofsys_register_loop_counters_hidden(func, loop, entries, iterations);
+}
@@ -28,6 +28,7 @@
 #include <timemory/compat/macros.h>
 
 #include <cstddef>
+#include <cstdint>
 
 // forward decl of the API
 extern "C"
@@ -86,6 +87,22 @@ extern "C"
     void rocprofsys_register_coverage(const char* file, const char* func,
                                       size_t address) ROCPROFSYS_PUBLIC_API;
 
+    /// stores source code information and writes the (one-based) index of the site
+    void rocprofsys_register_source_index(const char* file, const char* func,
+                                          size_t line, size_t address,
+                                          const char* source,
+                                          uint32_t*   index) ROCPROFSYS_PUBLIC_API;
+
+    /// increments the coverage value of a site registered with
+    /// rocprofsys_register_source_index
+    void rocprofsys_register_coverage_index(uint32_t index) ROCPROFSYS_PUBLIC_API;
+
+    /// stores the counters of the entries and (optionally) iterations of a loop which
+    /// the instrumentation increments in place
+    void rocprofsys_register_loop_counters(const char* func, const char* loop,
+                                           uint64_t* entries,
+                                           uint64_t* iterations) ROCPROFSYS_PUBLIC_API;
+
     /// mark causal progress
     void rocprofsys_progress(const char*) ROCPROFSYS_PUBLIC_API;
 
@@ -115,6 +132,12 @@ extern "C"
                                            const char*) ROCPROFSYS_HIDDEN_API;
     void rocprofsys_register_coverage_hidden(const char*, const char*,
                                              size_t) ROCPROFSYS_HIDDEN_API;
+    void rocprofsys_register_source_index_hidden(const char*, const char*, size_t,
+                                                 size_t, const char*,
+                                                 uint32_t*) ROCPROFSYS_HIDDEN_API;
+    void rocprofsys_register_coverage_index_hidden(uint32_t) ROCPROFSYS_HIDDEN_API;
+    void rocprofsys_register_loop_counters_hidden(const char*, const char*, uint64_t*,
+                                                  uint64_t*) ROCPROFSYS_HIDDEN_API;
     void rocprofsys_progress_hidden(const char*) ROCPROFSYS_HIDDEN_API;
     void rocprofsys_annotated_progress_hidden(const char*, rocprofsys_annotation_t*,
                                               size_t) ROCPROFSYS_HIDDEN_API;
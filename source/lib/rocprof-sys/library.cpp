@@ -41,6 +41,7 @@
 #include "library/causal/data.hpp"
 #include "library/causal/experiment.hpp"
 #include "library/causal/sampling.hpp"
+#include "library/components/comm_data.hpp"
 #include "library/components/exit_gotcha.hpp"
 #include "library/components/fork_gotcha.hpp"
 #include "library/components/mpi_gotcha.hpp"
@@ -48,6 +49,9 @@
 #include "library/components/pthread_gotcha.hpp"
 #include "library/components/rocprofiler.hpp"
 #include "library/coverage.hpp"
+#include "library/lock_contention.hpp"
+#include "library/loop_counters.hpp"
+#include "library/mpi_wait_state.hpp"
 #include "library/ompt.hpp"
 #include "library/process_sampler.hpp"
 #include "library/ptl.hpp"
@@ -790,7 +794,7 @@ rocprofsys_finalize_hidden(void)
     {
         if(!instrumentation_bundles::get()) continue;
         const auto& _info = thread_info::get(i, SequentTID);
-        auto&       itr   = instrumentation_bundles::get()->at(i);
+        const auto& itr   = std::as_const(*instrumentation_bundles::get()).at(i);
         while(itr != nullptr && !itr->empty())
         {
             int _lvl = 1;
@@ -907,6 +911,24 @@ rocprofsys_finalize_hidden(void)
         sampling::post_process();
     }
 
+    if(lock_contention::enabled())
+    {
+        ROCPROFSYS_VERBOSE_F(1, "Post-processing the lock contention...\n");
+        lock_contention::post_process();
+    }
+
+    if(get_use_mpip() || get_use_rcclp())
+    {
+        ROCPROFSYS_VERBOSE_F(1, "Post-processing the communication data...\n");
+        component::comm_data::post_process();
+    }
+
+    if(get_use_mpip() && mpi_wait_state::enabled())
+    {
+        ROCPROFSYS_VERBOSE_F(1, "Post-processing the MPI wait states...\n");
+        mpi_wait_state::post_process();
+    }
+
     if(get_use_causal())
     {
         ROCPROFSYS_VERBOSE_F(1, "Finishing the causal experiments...\n");
@@ -929,6 +951,12 @@ rocprofsys_finalize_hidden(void)
         coverage::post_process();
     }
 
+    if(loop_counters::size() > 0)
+    {
+        ROCPROFSYS_VERBOSE_F(1, "Post-processing the loop counters...\n");
+        loop_counters::post_process();
+    }
+
     tracing::copy_timemory_hash_ids();
 
     bool _perfetto_output_error = false;
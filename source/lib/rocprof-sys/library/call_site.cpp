@@ -0,0 +1,131 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/call_site.hpp"
+#include "core/common.hpp"
+#include "core/debug.hpp"
+
+#include <timemory/utility/demangle.hpp>
+
+#include <mutex>
+#include <utility>
+
+#include <dlfcn.h>
+#include <link.h>
+#include <unwind.h>
+
+namespace rocprofsys
+{
+namespace call_site
+{
+namespace
+{
+using text_range_t = std::pair<uintptr_t, uintptr_t>;
+
+text_range_t text_range = { 0, 0 };
+
+int
+find_text_range(dl_phdr_info* _info, size_t, void* _data)
+{
+    auto* _range = static_cast<text_range_t*>(_data);
+    auto  _addr  = reinterpret_cast<uintptr_t>(&find_text_range);
+    for(int i = 0; i < _info->dlpi_phnum; ++i)
+    {
+        const auto& _phdr = _info->dlpi_phdr[i];
+        if(_phdr.p_type != PT_LOAD || (_phdr.p_flags & PF_X) == 0) continue;
+
+        auto _beg = _info->dlpi_addr + _phdr.p_vaddr;
+        auto _end = _beg + _phdr.p_memsz;
+        if(_addr >= _beg && _addr < _end)
+        {
+            *_range = { _beg, _end };
+            return 1;
+        }
+    }
+    return 0;
+}
+
+struct unwind_data
+{
+    int       frames = 0;
+    uintptr_t site   = 0;
+};
+
+// stops at the first frame outside of this library so that only the frames of the
+// wrappers are unwound instead of a fixed depth
+_Unwind_Reason_Code
+find_site(_Unwind_Context* _ctx, void* _arg)
+{
+    constexpr int max_frames = 16;
+
+    auto* _data = static_cast<unwind_data*>(_arg);
+    auto  _addr = static_cast<uintptr_t>(_Unwind_GetIP(_ctx));
+    if(_addr == 0 || ++_data->frames > max_frames) return _URC_END_OF_STACK;
+    if(_addr >= text_range.first && _addr < text_range.second) return _URC_NO_REASON;
+
+    _data->site = _addr;
+    return _URC_END_OF_STACK;
+}
+}  // namespace
+
+void
+configure()
+{
+    static std::once_flag _once{};
+    std::call_once(_once, []() {
+        dl_iterate_phdr(&find_text_range, &text_range);
+
+        // the first unwind initializes the lookup of the unwind tables
+        get();
+    });
+}
+
+uintptr_t
+get()
+{
+    auto _data = unwind_data{};
+    _Unwind_Backtrace(&find_site, &_data);
+    return _data.site;
+}
+
+std::string
+get_name(uintptr_t _site)
+{
+    if(_site == 0) return std::string{ "??" };
+
+    Dl_info _info = {};
+    if(dladdr(reinterpret_cast<void*>(_site), &_info) != 0)
+    {
+        if(_info.dli_sname && _info.dli_saddr)
+            return JOIN("", demangle(_info.dli_sname), "+",
+                        as_hex(_site - reinterpret_cast<uintptr_t>(_info.dli_saddr), 0));
+        if(_info.dli_fname && _info.dli_fbase)
+        {
+            auto _fname = std::string{ _info.dli_fname };
+            return JOIN("", _fname.substr(_fname.find_last_of('/') + 1), "+",
+                        as_hex(_site - reinterpret_cast<uintptr_t>(_info.dli_fbase), 0));
+        }
+    }
+    return as_hex(_site);
+}
+}  // namespace call_site
+}  // namespace rocprofsys
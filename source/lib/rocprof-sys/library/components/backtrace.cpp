@@ -20,10 +20,12 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include "binary/analysis.hpp"
 #include "core/common.hpp"
 #include "core/components/fwd.hpp"
 #include "core/config.hpp"
 #include "core/debug.hpp"
+#include "core/frame_pointer.hpp"
 #include "core/perfetto.hpp"
 #include "core/state.hpp"
 #include "library/components/ensure_storage.hpp"
@@ -74,12 +76,52 @@ namespace rocprofsys
 {
 namespace component
 {
+namespace
+{
+// after this many samples, a thread whose frame-pointer chain is invalid for the
+// majority of samples stops trying and always uses libunwind
+constexpr size_t frame_pointer_probation = 64;
+
+struct frame_pointer_state
+{
+    bool                        enabled  = false;
+    size_t                      nvalid   = 0;
+    size_t                      ninvalid = 0;
+    frame_pointer::stack_bounds bounds   = {};
+};
+
+auto&
+get_frame_pointer_state()
+{
+    static thread_local auto _v = frame_pointer_state{};
+    return _v;
+}
+
+bool
+use_frame_pointer_unwinder()
+{
+    static bool _v =
+        frame_pointer::is_supported && get_sampling_unwinder() == "frame-pointer";
+    return _v;
+}
+}  // namespace
+
 std::vector<backtrace::entry_type>
 backtrace::get() const
 {
     std::vector<entry_type> _v = {};
     if(size() == 0) return _v;
 
+    if(!m_frames.empty())
+    {
+        _v.reserve(m_frames.size());
+        for(auto itr : m_frames)
+        {
+            auto _entry = binary::lookup_ipaddr_entry<false>(itr);
+            if(_entry) _v.emplace_back(*_entry);
+        }
+    }
+    else
     {
         static auto _cache = cache_type{ get_sampling_include_inlines() };
         auto_lock_t _lk{ type_mutex<backtrace>() };
@@ -180,7 +222,67 @@ backtrace::empty() const
 size_t
 backtrace::size() const
 {
-    return m_data.size();
+    return (m_frames.empty()) ? m_data.size() : m_frames.size();
+}
+
+void
+backtrace::configure(bool _setup, int64_t _tid)
+{
+    if(!use_frame_pointer_unwinder()) return;
+
+    auto& _state = get_frame_pointer_state();
+    if(_setup)
+    {
+        // must be called on the sampled thread since the bounds are for its stack
+        _state         = frame_pointer_state{};
+        _state.bounds  = frame_pointer::get_stack_bounds();
+        _state.enabled = static_cast<bool>(_state.bounds);
+        if(!_state.enabled)
+        {
+            ROCPROFSYS_VERBOSE(1,
+                               "[backtrace] unable to determine the stack bounds of "
+                               "thread %li. Using libunwind...\n",
+                               _tid);
+        }
+    }
+    else if(_state.nvalid + _state.ninvalid > 0)
+    {
+        ROCPROFSYS_VERBOSE(
+            (_state.enabled) ? 2 : 1,
+            "[backtrace] thread %li: %zu samples unwound via frame pointers, %zu fell "
+            "back to libunwind%s\n",
+            _tid, _state.nvalid, _state.ninvalid,
+            (_state.enabled) ? ""
+                             : ". The frame-pointer unwinder was disabled for this "
+                               "thread (compile with -fno-omit-frame-pointer)");
+    }
+}
+
+bool
+backtrace::sample_frame_pointer(int signo)
+{
+    auto& _state = get_frame_pointer_state();
+    if(!_state.enabled) return false;
+
+    auto  _restorer = frame_pointer::get_signal_restorer(signo);
+    void* _sp       = __builtin_frame_address(0);
+    auto* _uc       = frame_pointer::find_signal_context(_sp, _restorer, _state.bounds);
+
+    auto _frames = std::array<uintptr_t, stack_depth>{};
+    auto _n = frame_pointer::unwind(_uc, _state.bounds, _frames.data(), _frames.size());
+
+    if(_n == 0)
+    {
+        ++_state.ninvalid;
+        if(_state.nvalid + _state.ninvalid >= frame_pointer_probation &&
+           _state.ninvalid > _state.nvalid)
+            _state.enabled = false;
+        return false;
+    }
+
+    ++_state.nvalid;
+    m_frames = std::make_pair(_frames, _n);
+    return true;
 }
 
 void
@@ -191,6 +293,10 @@ backtrace::sample(int signo)
     // on RedHat, the unw_step within get_unw_stack involves a mutex lock
     ROCPROFSYS_SCOPED_THREAD_STATE(ThreadState::Internal);
 
+    // the frame-pointer unwinder starts from the interrupted context so, unlike
+    // libunwind, there are no signal handler frames to ignore
+    if(use_frame_pointer_unwinder() && sample_frame_pointer(signo)) return;
+
     using namespace tim::backtrace;
     constexpr bool   with_signal_frame = false;
     constexpr size_t ignore_depth      = 3;
@@ -201,6 +307,7 @@ backtrace::sample(int signo)
     // 4a. funlockfile       [common but not explicitly in call-stack]
     // 4b. __resume_rt       [common but not explicitly in call-stack]
     // 4c. killpg            [common but not explicitly in call-stack]
+    m_frames.clear();
     m_data = get_unw_stack<stack_depth, ignore_depth, with_signal_frame>();
 }
 }  // namespace component
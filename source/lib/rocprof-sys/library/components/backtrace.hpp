@@ -24,6 +24,7 @@
 
 #include "core/common.hpp"
 #include "core/components/fwd.hpp"
+#include "core/containers/static_vector.hpp"
 #include "core/defines.hpp"
 #include "core/timemory.hpp"
 #include "library/thread_data.hpp"
@@ -50,6 +51,7 @@ struct backtrace : comp::empty_base
     static constexpr size_t stack_depth = ROCPROFSYS_MAX_UNWIND_DEPTH;
 
     using data_t            = tim::unwind::stack<stack_depth>;
+    using frame_data_t      = container::static_vector<uintptr_t, stack_depth>;
     using cache_type        = typename data_t::cache_type;
     using entry_type        = tim::unwind::processed_entry;
     using clock_type        = std::chrono::steady_clock;
@@ -72,6 +74,7 @@ struct backtrace : comp::empty_base
 
     static void start();
     static void stop();
+    static void configure(bool, int64_t);
 
     void                    sample(int = -1);
     bool                    empty() const;
@@ -80,7 +83,10 @@ struct backtrace : comp::empty_base
     data_t                  get_data() const { return m_data; }
 
 private:
-    data_t m_data = {};
+    bool sample_frame_pointer(int);
+
+    data_t       m_data   = {};
+    frame_data_t m_frames = {};
 };
 }  // namespace component
 }  // namespace rocprofsys
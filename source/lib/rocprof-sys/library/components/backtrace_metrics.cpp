@@ -199,8 +199,8 @@ backtrace_metrics::configure(bool _setup, int64_t _tid)
     auto& _running    = get_sampler_running(_tid);
     bool  _is_running = (!_running) ? false : *_running;
 
-    ensure_storage<comp::trip_count, sampling_wall_clock, sampling_cpu_clock, hw_counters,
-                   sampling_percent>{}();
+    ensure_storage<comp::trip_count, sampling_wall_clock, sampling_cpu_clock,
+                   sampling_offcpu_clock, hw_counters, sampling_percent>{}();
 
     if(_setup && !_is_running)
     {
@@ -417,6 +417,10 @@ ROCPROFSYS_INSTANTIATE_EXTERN_COMPONENT(
     TIMEMORY_ESC(data_tracker<double, rocprofsys::component::backtrace_cpu_clock>), true,
     double)
 
+ROCPROFSYS_INSTANTIATE_EXTERN_COMPONENT(
+    TIMEMORY_ESC(data_tracker<double, rocprofsys::component::backtrace_offcpu_clock>),
+    true, double)
+
 ROCPROFSYS_INSTANTIATE_EXTERN_COMPONENT(
     TIMEMORY_ESC(data_tracker<double, rocprofsys::component::backtrace_fraction>), true,
     double)
@@ -21,6 +21,7 @@
 // SOFTWARE.
 
 #include "library/components/backtrace_timestamp.hpp"
+#include "library/sampling_controller.hpp"
 #include "library/thread_info.hpp"
 
 #include <timemory/components/timing/backends.hpp>
@@ -43,10 +44,14 @@ backtrace_timestamp::is_valid() const
 }
 
 void
-backtrace_timestamp::sample(int)
+backtrace_timestamp::sample(int _signo)
 {
-    m_tid  = tim::threading::get_id();
-    m_real = tim::get_clock_real_now<uint64_t, std::nano>();
+    // first component of the sampling bundle: starts the measurement of the handler
+    // cost for the adaptive sampling controller
+    m_weight = sampling::controller::begin_sample();
+    m_signal = _signo;
+    m_tid    = tim::threading::get_id();
+    m_real   = tim::get_clock_real_now<uint64_t, std::nano>();
 }
 }  // namespace component
 }  // namespace rocprofsys
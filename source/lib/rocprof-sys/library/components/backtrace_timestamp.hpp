@@ -62,11 +62,15 @@ struct backtrace_timestamp : comp::empty_base
 
     auto get_tid() const { return m_tid; }
     auto get_timestamp() const { return m_real; }
+    auto get_weight() const { return m_weight; }
+    auto get_signal() const { return m_signal; }
     bool is_valid() const;
 
 private:
-    int64_t  m_tid  = 0;
-    uint64_t m_real = 0;
+    int64_t  m_tid    = 0;
+    uint64_t m_real   = 0;
+    float    m_weight = 1.0f;
+    int      m_signal = -1;
 };
 }  // namespace component
 }  // namespace rocprofsys
@@ -33,6 +33,7 @@
 #include "library/ptl.hpp"
 #include "library/runtime.hpp"
 #include "library/sampling.hpp"
+#include "library/sampling_controller.hpp"
 #include "library/thread_info.hpp"
 
 #include <timemory/backends/papi.hpp>
@@ -175,7 +176,13 @@ callchain::size() const
 void
 callchain::sample(int signo)
 {
-    if(signo != get_sampling_overflow_signal()) return;
+    // last component of the sampling bundle: completes the measurement of the handler
+    // cost for the adaptive sampling controller
+    if(signo != get_sampling_overflow_signal())
+    {
+        sampling::controller::end_sample();
+        return;
+    }
 
     // on RedHat, the unw_step within get_unw_stack involves a mutex lock
     ROCPROFSYS_SCOPED_THREAD_STATE(ThreadState::Internal);
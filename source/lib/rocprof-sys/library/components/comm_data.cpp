@@ -21,57 +21,351 @@
 // SOFTWARE.
 
 #include "library/components/comm_data.hpp"
+#include "core/categories.hpp"
 #include "core/components/fwd.hpp"
 #include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/locking.hpp"
 #include "core/perfetto.hpp"
+#include "library/mpi_wait_state.hpp"
+#include "library/thread_data.hpp"
 #include "library/tracing.hpp"
 
 #include <timemory/backends/mpi.hpp>
+#include <timemory/backends/threading.hpp>
 #include <timemory/manager.hpp>
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/settings/settings.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
 #include <timemory/units.hpp>
+#include <timemory/utility/filepath.hpp>
 #include <timemory/utility/locking.hpp>
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+#include <tuple>
+#include <vector>
+
 namespace rocprofsys
 {
 namespace component
 {
 namespace
 {
-template <typename Tp, typename... Args>
+// bytes accumulated by a thread since the last counter sample
+struct counter_bucket
+{
+    uint64_t beg   = 0;
+    uint64_t last  = 0;
+    uint64_t value = 0;
+    uint64_t count = 0;
+};
+
+template <typename Tp>
+using counter_buckets = thread_data<counter_bucket, Tp>;
+
+template <typename Tp>
 void
-write_perfetto_counter_track(uint64_t _val)
+emit_perfetto_counter(uint64_t _ts, uint64_t _val)
 {
     using counter_track = rocprofsys::perfetto_counter_track<Tp>;
 
+    auto _emplace = [](const size_t _idx) {
+        if(!counter_track::exists(_idx))
+        {
+            std::string _label =
+                (_idx > 0) ? JOIN(" ", Tp::label, JOIN("", '[', _idx, ']')) : Tp::label;
+            counter_track::emplace(_idx, _label, "bytes");
+        }
+    };
+
+    const size_t          _idx = 0;
+    static std::once_flag _once{};
+    std::call_once(_once, _emplace, _idx);
+
+    // the track is the running total across all threads. The samples of the threads
+    // are not emitted in timestamp order so the total is accumulated and paired with
+    // its timestamp under the same lock and the timestamp never goes backwards, i.e.
+    // a late sample is emitted at the timestamp of the last sample of the track
+    static auto     _mutex   = locking::atomic_mutex{};
+    static uint64_t _total   = 0;
+    static uint64_t _last_ts = 0;
+
+    auto _lk = locking::atomic_lock{ _mutex };
+    _total += _val;
+    _last_ts = std::max(_last_ts, _ts);
+
+    TRACE_COUNTER(Tp::value, counter_track::at(_idx, 0), _last_ts, _total);
+}
+
+template <typename Tp, typename... Args>
+void
+write_perfetto_counter_track(uint64_t _val)
+{
     if(rocprofsys::get_use_perfetto() &&
        rocprofsys::get_state() == rocprofsys::State::Active)
     {
-        auto _emplace = [](const size_t _idx) {
-            if(!counter_track::exists(_idx))
-            {
-                std::string _label = (_idx > 0)
-                                         ? JOIN(" ", Tp::label, JOIN("", '[', _idx, ']'))
-                                         : Tp::label;
-                counter_track::emplace(_idx, _label, "bytes");
-            }
-        };
+        static const uint64_t _period =
+            config::get_perfetto_comm_counter_period() * units::msec;
 
-        const size_t          _idx = 0;
-        static std::once_flag _once{};
-        std::call_once(_once, _emplace, _idx);
+        auto _now = rocprofsys::tracing::now<uint64_t>();
+        if(_period == 0) return emit_perfetto_counter<Tp>(_now, _val);
 
-        static std::mutex _mutex{};
-        static uint64_t   value = 0;
-        uint64_t          _now  = 0;
+        // one sample per thread per period, timestamped at the last call in the period
+        auto& _bucket =
+            counter_buckets<Tp>::instance(construct_on_thread{ threading::get_id() });
+        if(_bucket->count > 0 && (_now - _bucket->beg) >= _period)
         {
-            std::unique_lock<std::mutex> _lk{ _mutex };
-            _now = rocprofsys::tracing::now<uint64_t>();
-            _val = (value += _val);
+            emit_perfetto_counter<Tp>(_bucket->last, _bucket->value);
+            *_bucket = counter_bucket{};
         }
 
-        TRACE_COUNTER(Tp::value, counter_track::at(_idx, 0), _now, _val);
+        if(_bucket->count++ == 0) _bucket->beg = _now;
+        _bucket->last = _now;
+        _bucket->value += _val;
+    }
+}
+
+// emits the final partial period of every thread
+template <typename Tp>
+void
+flush_perfetto_counter_track()
+{
+    if(!counter_buckets<Tp>::get()) return;
+
+    for(auto& itr : *counter_buckets<Tp>::get())
+    {
+        if(!itr || itr->count == 0) continue;
+        emit_perfetto_counter<Tp>(itr->last, itr->value);
+        *itr = counter_bucket{};
+    }
+}
+
+#if defined(ROCPROFSYS_USE_MPI)
+// log2 buckets: bucket 0 holds zero-byte messages (or MPI_ANY_TAG), bucket N holds
+// values in [2^(N-1), 2^N)
+constexpr size_t comm_size_buckets = 48;
+constexpr size_t comm_tag_buckets  = 16;
+constexpr int    comm_unknown_peer = -1;
+
+enum comm_direction : uint8_t
+{
+    comm_send = 0,
+    comm_recv,
+    comm_directions
+};
+
+size_t
+get_log2_bucket(uint64_t _v, size_t _nbuckets)
+{
+    if(_v == 0) return 0;
+    return std::min<size_t>(64 - __builtin_clzll(_v), _nbuckets - 1);
+}
+
+size_t
+get_tag_bucket(int _tag)
+{
+    // MPI_ANY_TAG (and any other negative tag) is bucket 0
+    if(_tag < 0) return 0;
+    return 1 + get_log2_bucket(_tag, comm_tag_buckets - 1);
+}
+
+using mpi_comm_info_ptr = std::shared_ptr<const comm_data::mpi_comm_info>;
+
+int
+delete_comm_info(MPI_Comm, int, void* _attr, void*)
+{
+    delete static_cast<mpi_comm_info_ptr*>(_attr);
+    return MPI_SUCCESS;
+}
+
+int
+get_comm_info_keyval()
+{
+    static int _v = []() {
+        int _keyval = MPI_KEYVAL_INVALID;
+        if(PMPI_Comm_create_keyval(MPI_COMM_NULL_COPY_FN, &delete_comm_info, &_keyval,
+                                   nullptr) != MPI_SUCCESS)
+        {
+            ROCPROFSYS_WARNING_F(0, "unable to create the MPI attribute which caches "
+                                    "the communicator data\n");
+            _keyval = MPI_KEYVAL_INVALID;
+        }
+        return _keyval;
+    }();
+    return _v;
+}
+
+const mpi_comm_info_ptr*
+find_comm_info(MPI_Comm _comm, int _keyval)
+{
+    void* _attr  = nullptr;
+    int   _found = 0;
+    if(_keyval == MPI_KEYVAL_INVALID ||
+       PMPI_Comm_get_attr(_comm, _keyval, &_attr, &_found) != MPI_SUCCESS || _found == 0)
+        return nullptr;
+    return static_cast<const mpi_comm_info_ptr*>(_attr);
+}
+
+struct comm_peer_entry
+{
+    uint64_t                              comm       = 0;  // mpi_comm_info::id
+    int32_t                               peer       = 0;
+    int32_t                               world_peer = comm_unknown_peer;
+    uint32_t                              tag_bucket = 0;
+    bool                                  used       = false;
+    std::array<uint64_t, comm_directions> bytes      = {};
+    std::array<uint64_t, comm_directions> count      = {};
+};
+
+// per-thread aggregation of the point-to-point traffic keyed by (communicator id, peer,
+// tag bucket). The table is a flat, power-of-two sized, open-addressed array which is
+// only ever touched by the owning thread so the hot path is a hash plus a few adds.
+// The peer is translated to its rank in MPI_COMM_WORLD when an entry is created
+struct comm_profile
+{
+    using histogram_t = std::array<uint64_t, comm_size_buckets>;
+
+    std::vector<comm_peer_entry>             entries   = {};
+    size_t                                   size      = 0;
+    std::array<histogram_t, comm_directions> histogram = {};
+
+    comm_peer_entry& find(uint64_t _comm, int _peer, uint32_t _tag_bucket);
+
+private:
+    void rehash(size_t _capacity);
+};
+
+using comm_profile_instances = thread_data<comm_profile, category::mpi>;
+
+size_t
+get_entry_hash(uint64_t _comm, int _peer, uint32_t _tag_bucket)
+{
+    auto _v = (static_cast<uint64_t>(_comm) * 0x9e3779b97f4a7c15ULL) ^
+              (static_cast<uint64_t>(static_cast<uint32_t>(_peer)) << 5) ^ _tag_bucket;
+    return static_cast<size_t>(_v ^ (_v >> 29));
+}
+
+void
+comm_profile::rehash(size_t _capacity)
+{
+    auto _old = std::vector<comm_peer_entry>(_capacity);
+    std::swap(_old, entries);
+    for(const auto& itr : _old)
+    {
+        if(!itr.used) continue;
+        auto _idx = get_entry_hash(itr.comm, itr.peer, itr.tag_bucket);
+        while(entries[_idx & (_capacity - 1)].used)
+            ++_idx;
+        entries[_idx & (_capacity - 1)] = itr;
     }
 }
+
+comm_peer_entry&
+comm_profile::find(uint64_t _comm, int _peer, uint32_t _tag_bucket)
+{
+    if(entries.empty()) rehash(64);
+
+    auto _mask = entries.size() - 1;
+    auto _idx  = get_entry_hash(_comm, _peer, _tag_bucket);
+    while(true)
+    {
+        auto& itr = entries[_idx & _mask];
+        if(!itr.used) break;
+        if(itr.comm == _comm && itr.peer == _peer && itr.tag_bucket == _tag_bucket)
+            return itr;
+        ++_idx;
+    }
+
+    // keep the load factor <= 0.5
+    if(2 * (size + 1) > entries.size())
+    {
+        rehash(2 * entries.size());
+        return find(_comm, _peer, _tag_bucket);
+    }
+
+    auto& _entry      = entries[_idx & _mask];
+    _entry.comm       = _comm;
+    _entry.peer       = _peer;
+    _entry.tag_bucket = _tag_bucket;
+    _entry.used       = true;
+    ++size;
+    return _entry;
+}
+
+// translation of a communicator-local rank to its rank in MPI_COMM_WORLD. Only done
+// when a new (communicator, peer, tag) is seen
+int
+get_world_rank(const comm_data::mpi_comm_info& _info, int _peer)
+{
+    if(_peer < 0 || _peer >= static_cast<int>(_info.world.size()))
+        return comm_unknown_peer;
+    auto _rank = _info.world.at(_peer);
+    return (_rank == MPI_UNDEFINED) ? comm_unknown_peer : _rank;
+}
+
+bool
+use_comm_matrix()
+{
+    static bool _v = get_use_mpip() && config::get_mpip_comm_matrix();
+    return _v;
+}
+
+auto&
+get_comm_profile()
+{
+    return comm_profile_instances::instance(construct_on_thread{ threading::get_id() });
+}
+
+void
+record_message(comm_direction _dir, uint64_t _bytes)
+{
+    if(!use_comm_matrix() || get_state() != State::Active) return;
+    auto& _data = get_comm_profile();
+    ++_data->histogram[_dir][get_log2_bucket(_bytes, comm_size_buckets)];
+}
+
+void
+record_message(comm_direction _dir, MPI_Comm _comm, int _peer, int _tag, uint64_t _bytes)
+{
+    // MPI_PROC_NULL transfers nothing
+    if(!use_comm_matrix() || get_state() != State::Active || _peer == MPI_PROC_NULL)
+        return;
+
+    auto& _data = get_comm_profile();
+    ++_data->histogram[_dir][get_log2_bucket(_bytes, comm_size_buckets)];
+
+    auto _info = comm_data::get_mpi_comm_info(_comm);
+    if(!_info) return;
+
+    auto& _entry = _data->find(_info->id, _peer, get_tag_bucket(_tag));
+    if(_entry.count[comm_send] + _entry.count[comm_recv] == 0)
+        _entry.world_peer = get_world_rank(*_info, _peer);
+    _entry.bytes[_dir] += _bytes;
+    _entry.count[_dir] += 1;
+}
+
+std::string
+get_bucket_label(size_t _bucket, bool _is_tag)
+{
+    if(_is_tag)
+    {
+        if(_bucket == 0) return "any";
+        --_bucket;
+    }
+    if(_bucket == 0) return "0";
+    auto _lo = uint64_t{ 1 } << (_bucket - 1);
+    return JOIN("", '[', _lo, ',', 2 * _lo, ')');
+}
+#endif
 }  // namespace
 
 void
@@ -105,16 +399,279 @@ comm_data::configure()
     comm_data_tracker_t::set_format_flags(_fmt_flags);
 }
 
+#if defined(ROCPROFSYS_USE_MPI)
+std::vector<int>
+comm_data::mpi_world_ranks(MPI_Comm _comm)
+{
+    int _inter = 0;
+    int _size  = 0;
+    PMPI_Comm_test_inter(_comm, &_inter);
+    if(_inter != 0)
+        PMPI_Comm_remote_size(_comm, &_size);
+    else
+        PMPI_Comm_size(_comm, &_size);
+
+    auto _local = std::vector<int>(std::max<int>(_size, 0));
+    auto _world = std::vector<int>(_local.size(), MPI_UNDEFINED);
+    std::iota(_local.begin(), _local.end(), 0);
+
+    MPI_Group _comm_group  = MPI_GROUP_NULL;
+    MPI_Group _world_group = MPI_GROUP_NULL;
+    if(_inter != 0)
+        PMPI_Comm_remote_group(_comm, &_comm_group);
+    else
+        PMPI_Comm_group(_comm, &_comm_group);
+    PMPI_Comm_group(MPI_COMM_WORLD, &_world_group);
+    PMPI_Group_translate_ranks(_comm_group, _size, _local.data(), _world_group,
+                               _world.data());
+    PMPI_Group_free(&_comm_group);
+    PMPI_Group_free(&_world_group);
+
+    return _world;
+}
+
+std::shared_ptr<const comm_data::mpi_comm_info>
+comm_data::get_mpi_comm_info(MPI_Comm _comm)
+{
+    if(_comm == MPI_COMM_NULL) return nullptr;
+
+    auto _keyval = get_comm_info_keyval();
+    if(const auto* _cached = find_comm_info(_comm, _keyval)) return *_cached;
+
+    // the data of a communicator is created once even when several threads use the
+    // communicator for the first time concurrently
+    static auto     _mutex = std::mutex{};
+    static uint64_t _count = 0;
+
+    std::unique_lock<std::mutex> _lk{ _mutex };
+    if(const auto* _cached = find_comm_info(_comm, _keyval)) return *_cached;
+
+    auto _info   = std::make_shared<mpi_comm_info>();
+    int  _inter  = 0;
+    _info->id    = ++_count;
+    _info->world = mpi_world_ranks(_comm);
+    PMPI_Comm_test_inter(_comm, &_inter);
+    if(_inter == 0)
+    {
+        auto _sorted = _info->world;
+        std::sort(_sorted.begin(), _sorted.end());
+
+        // FNV-1a of the sorted membership is identical on every rank of the comm
+        _info->hash = 0xcbf29ce484222325ULL;
+        for(auto itr : _sorted)
+        {
+            _info->hash ^= static_cast<uint32_t>(itr);
+            _info->hash *= 0x100000001b3ULL;
+        }
+        _info->valid  = !_sorted.empty() && _sorted.front() >= 0;
+        _info->leader = (_info->valid) ? _sorted.front() : -1;
+    }
+
+    auto _v = mpi_comm_info_ptr{ std::move(_info) };
+    if(_keyval != MPI_KEYVAL_INVALID)
+        PMPI_Comm_set_attr(_comm, _keyval, new mpi_comm_info_ptr{ _v });
+    return _v;
+}
+#endif
+
+void
+comm_data::post_process()
+{
+    if(get_use_perfetto())
+    {
+        flush_perfetto_counter_track<mpi_send>();
+        flush_perfetto_counter_track<mpi_recv>();
+        flush_perfetto_counter_track<rccl_send>();
+        flush_perfetto_counter_track<rccl_recv>();
+    }
+
+#if defined(ROCPROFSYS_USE_MPI)
+    if(!use_comm_matrix() || !comm_profile_instances::get()) return;
+
+    // merge the thread-local tables
+    using entry_key_t = std::tuple<int, uint64_t, uint32_t>;
+    using histogram_t = comm_profile::histogram_t;
+
+    auto _entries   = std::map<entry_key_t, comm_peer_entry>{};
+    auto _histogram = std::array<histogram_t, comm_directions>{};
+    for(const auto& itr : *comm_profile_instances::get())
+    {
+        if(!itr) continue;
+        for(const auto& eitr : itr->entries)
+        {
+            if(!eitr.used) continue;
+            auto& _entry =
+                _entries[entry_key_t{ eitr.world_peer, eitr.comm, eitr.tag_bucket }];
+            _entry.comm       = eitr.comm;
+            _entry.peer       = eitr.peer;
+            _entry.world_peer = eitr.world_peer;
+            _entry.tag_bucket = eitr.tag_bucket;
+            for(size_t i = 0; i < comm_directions; ++i)
+            {
+                _entry.bytes[i] += eitr.bytes[i];
+                _entry.count[i] += eitr.count[i];
+            }
+        }
+        for(size_t i = 0; i < comm_directions; ++i)
+            for(size_t j = 0; j < comm_size_buckets; ++j)
+                _histogram[i][j] += itr->histogram[i][j];
+    }
+
+    // per-rank breakdown by (peer, communicator, tag bucket)
+    {
+        auto _fname = tim::settings::compose_output_filename("comm-peers", ".txt");
+        auto _ofs   = std::ofstream{};
+        if(tim::filepath::open(_ofs, _fname))
+        {
+            if(get_verbose() >= 0)
+                operation::file_output_message<tim::project::rocprofsys>{}(
+                    _fname, std::string{ "MPI peer communication" });
+
+            _ofs << std::left << std::setw(8) << "# peer" << std::setw(20) << "comm id"
+                 << std::setw(12) << "tags" << std::right << std::setw(12)
+                 << "send count" << std::setw(18) << "send bytes" << std::setw(12)
+                 << "recv count" << std::setw(18) << "recv bytes" << "\n";
+            for(const auto& itr : _entries)
+            {
+                const auto& _entry = itr.second;
+                auto        _peer  = (_entry.world_peer == comm_unknown_peer)
+                                         ? std::string{ "any" }
+                                         : std::to_string(_entry.world_peer);
+                _ofs << std::left << std::setw(8) << _peer << std::setw(20)
+                     << _entry.comm << std::setw(12)
+                     << get_bucket_label(_entry.tag_bucket, true) << std::right
+                     << std::setw(12) << _entry.count[comm_send] << std::setw(18)
+                     << _entry.bytes[comm_send] << std::setw(12)
+                     << _entry.count[comm_recv] << std::setw(18)
+                     << _entry.bytes[comm_recv] << "\n";
+            }
+        }
+        else
+        {
+            ROCPROFSYS_VERBOSE(0,
+                               "Error opening MPI peer communication output file: %s\n",
+                               _fname.c_str());
+        }
+    }
+
+    int _initialized = 0;
+    int _finalized   = 0;
+    PMPI_Initialized(&_initialized);
+    PMPI_Finalized(&_finalized);
+    if(_initialized == 0 || _finalized != 0)
+    {
+        ROCPROFSYS_VERBOSE(1, "MPI is not active, the communication matrix is not "
+                              "reduced across ranks\n");
+        return;
+    }
+
+    int _rank = 0;
+    int _size = 1;
+    PMPI_Comm_rank(MPI_COMM_WORLD, &_rank);
+    PMPI_Comm_size(MPI_COMM_WORLD, &_size);
+
+    // row layout: send bytes [N], send count [N], recv bytes [N], recv count [N],
+    // recv bytes and count from an unknown peer (MPI_ANY_SOURCE), send histogram,
+    // recv histogram
+    const size_t _n       = _size;
+    const size_t _row_len = (4 * _n) + 2 + (comm_directions * comm_size_buckets);
+    auto         _row     = std::vector<uint64_t>(_row_len, 0);
+    for(const auto& itr : _entries)
+    {
+        const auto& _entry = itr.second;
+        if(_entry.world_peer == comm_unknown_peer ||
+           _entry.world_peer >= static_cast<int>(_n))
+        {
+            _row.at(4 * _n) += _entry.bytes[comm_recv];
+            _row.at(4 * _n + 1) += _entry.count[comm_recv];
+            continue;
+        }
+        auto _peer = static_cast<size_t>(_entry.world_peer);
+        _row.at(_peer) += _entry.bytes[comm_send];
+        _row.at(_n + _peer) += _entry.count[comm_send];
+        _row.at(2 * _n + _peer) += _entry.bytes[comm_recv];
+        _row.at(3 * _n + _peer) += _entry.count[comm_recv];
+    }
+    for(size_t i = 0; i < comm_directions; ++i)
+        std::copy(_histogram[i].begin(), _histogram[i].end(),
+                  _row.begin() + (4 * _n) + 2 + (i * comm_size_buckets));
+
+    auto _rows = std::vector<uint64_t>((_rank == 0) ? (_n * _row_len) : 0);
+    PMPI_Gather(_row.data(), _row_len, MPI_UINT64_T, _rows.data(), _row_len,
+                MPI_UINT64_T, 0, MPI_COMM_WORLD);
+
+    if(_rank != 0) return;
+
+    using matrix_t  = std::vector<std::vector<uint64_t>>;
+    auto _get_block = [&_rows, _n, _row_len](size_t _offset, size_t _len) {
+        auto _v = matrix_t(_n);
+        for(size_t i = 0; i < _n; ++i)
+        {
+            auto _beg = _rows.begin() + (i * _row_len) + _offset;
+            _v.at(i)  = std::vector<uint64_t>(_beg, _beg + _len);
+        }
+        return _v;
+    };
+
+    auto _buckets = std::vector<std::string>{};
+    for(size_t i = 0; i < comm_size_buckets; ++i)
+        _buckets.emplace_back(get_bucket_label(i, false));
+
+    std::stringstream oss{};
+    {
+        namespace cereal = tim::cereal;
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+        const size_t _hist_offset = (4 * _n) + 2;
+        ar->setNextName("rocprofsys");
+        ar->startNode();
+        ar->setNextName("comm_matrix");
+        ar->startNode();
+        (*ar)(cereal::make_nvp("ranks", _n));
+        (*ar)(cereal::make_nvp("send_bytes", _get_block(0, _n)));
+        (*ar)(cereal::make_nvp("send_count", _get_block(_n, _n)));
+        (*ar)(cereal::make_nvp("recv_bytes", _get_block(2 * _n, _n)));
+        (*ar)(cereal::make_nvp("recv_count", _get_block(3 * _n, _n)));
+        (*ar)(cereal::make_nvp("recv_unknown_peer", _get_block(4 * _n, 2)));
+        (*ar)(cereal::make_nvp("message_size_buckets", _buckets));
+        (*ar)(cereal::make_nvp("send_message_sizes",
+                               _get_block(_hist_offset, comm_size_buckets)));
+        (*ar)(cereal::make_nvp(
+            "recv_message_sizes",
+            _get_block(_hist_offset + comm_size_buckets, comm_size_buckets)));
+        ar->finishNode();
+        ar->finishNode();
+    }
+
+    auto _fname = tim::settings::compose_output_filename("comm-matrix", ".json");
+    auto _ofs   = std::ofstream{};
+    if(!tim::filepath::open(_ofs, _fname))
+    {
+        ROCPROFSYS_VERBOSE(0, "Error opening MPI communication matrix output file: %s\n",
+                           _fname.c_str());
+        return;
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<tim::project::rocprofsys>{}(
+            _fname, std::string{ "MPI communication matrix" });
+    _ofs << oss.str() << "\n";
+#endif
+}
+
 #if defined(ROCPROFSYS_USE_MPI)
 // MPI_Send
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, int count,
-                 MPI_Datatype datatype, int dst, int tag, MPI_Comm)
+                 MPI_Datatype datatype, int dst, int tag, MPI_Comm comm)
 {
+    mpi_wait_state::enter_send(_data.tool_id.c_str(), true, comm, dst, tag);
+
     int _size = mpi_type_size(datatype);
     if(_size == 0) return;
 
     write_perfetto_counter_track<mpi_send>(count * _size);
+    record_message(comm_send, comm, dst, tag, count * _size);
 
     if(!rocprofsys::get_use_timemory()) return;
     auto      _name = std::string_view{ _data.tool_id };
@@ -128,12 +685,17 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, int cou
 // MPI_Recv
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, void*, int count,
-                 MPI_Datatype datatype, int dst, int tag, MPI_Comm, MPI_Status*)
+                 MPI_Datatype datatype, int dst, int tag, MPI_Comm comm,
+                 MPI_Status* status)
 {
+    mpi_wait_state::enter_recv(_data.tool_id.c_str(), true, comm, dst, tag, status,
+                               nullptr);
+
     int _size = mpi_type_size(datatype);
     if(_size == 0) return;
 
     write_perfetto_counter_track<mpi_recv>(count * _size);
+    record_message(comm_recv, comm, dst, tag, count * _size);
 
     if(!rocprofsys::get_use_timemory()) return;
     auto      _name = std::string_view{ _data.tool_id };
@@ -147,12 +709,15 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, void*, int count,
 // MPI_Isend
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, int count,
-                 MPI_Datatype datatype, int dst, int tag, MPI_Comm, MPI_Request*)
+                 MPI_Datatype datatype, int dst, int tag, MPI_Comm comm, MPI_Request*)
 {
+    mpi_wait_state::enter_send(_data.tool_id.c_str(), false, comm, dst, tag);
+
     int _size = mpi_type_size(datatype);
     if(_size == 0) return;
 
     write_perfetto_counter_track<mpi_send>(count * _size);
+    record_message(comm_send, comm, dst, tag, count * _size);
 
     if(!rocprofsys::get_use_timemory()) return;
     auto      _name = std::string_view{ _data.tool_id };
@@ -166,12 +731,17 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, int cou
 // MPI_Irecv
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, void*, int count,
-                 MPI_Datatype datatype, int dst, int tag, MPI_Comm, MPI_Request*)
+                 MPI_Datatype datatype, int dst, int tag, MPI_Comm comm,
+                 MPI_Request* request)
 {
+    mpi_wait_state::enter_recv(_data.tool_id.c_str(), false, comm, dst, tag, nullptr,
+                               request);
+
     int _size = mpi_type_size(datatype);
     if(_size == 0) return;
 
     write_perfetto_counter_track<mpi_recv>(count * _size);
+    record_message(comm_recv, comm, dst, tag, count * _size);
 
     if(!rocprofsys::get_use_timemory()) return;
     auto      _name = std::string_view{ _data.tool_id };
@@ -185,12 +755,15 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, void*, int count,
 // MPI_Bcast
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, void*, int count,
-                 MPI_Datatype datatype, int root, MPI_Comm)
+                 MPI_Datatype datatype, int root, MPI_Comm comm)
 {
+    mpi_wait_state::enter_collective(_data.tool_id.c_str(), comm);
+
     int _size = mpi_type_size(datatype);
     if(_size == 0) return;
 
     write_perfetto_counter_track<mpi_send>(count * _size);
+    record_message(comm_send, count * _size);
 
     if(!rocprofsys::get_use_timemory()) return;
     auto      _name = std::string_view{ _data.tool_id };
@@ -202,13 +775,17 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, void*, int count,
 // MPI_Allreduce
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, void*, int count,
-                 MPI_Datatype datatype, MPI_Op, MPI_Comm)
+                 MPI_Datatype datatype, MPI_Op, MPI_Comm comm)
 {
+    mpi_wait_state::enter_collective(_data.tool_id.c_str(), comm);
+
     int _size = mpi_type_size(datatype);
     if(_size == 0) return;
 
     write_perfetto_counter_track<mpi_recv>(count * _size);
     write_perfetto_counter_track<mpi_send>(count * _size);
+    record_message(comm_recv, count * _size);
+    record_message(comm_send, count * _size);
 
     if(!rocprofsys::get_use_timemory()) return;
     add(_data, count * _size);
@@ -218,14 +795,20 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, void*,
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, int sendcount,
                  MPI_Datatype sendtype, int dst, int sendtag, void*, int recvcount,
-                 MPI_Datatype recvtype, int src, int recvtag, MPI_Comm, MPI_Status*)
+                 MPI_Datatype recvtype, int src, int recvtag, MPI_Comm comm,
+                 MPI_Status* status)
 {
+    mpi_wait_state::enter_sendrecv(_data.tool_id.c_str(), comm, dst, sendtag, src,
+                                   recvtag, status);
+
     int _send_size = mpi_type_size(sendtype);
     int _recv_size = mpi_type_size(recvtype);
     if(_send_size == 0 || _recv_size == 0) return;
 
     write_perfetto_counter_track<mpi_send>(sendcount * _send_size);
     write_perfetto_counter_track<mpi_recv>(recvcount * _recv_size);
+    record_message(comm_send, comm, dst, sendtag, sendcount * _send_size);
+    record_message(comm_recv, comm, src, recvtag, recvcount * _recv_size);
 
     if(!rocprofsys::get_use_timemory()) return;
     auto      _name = std::string_view{ _data.tool_id };
@@ -256,14 +839,18 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, int sen
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, int sendcount,
                  MPI_Datatype sendtype, void*, int recvcount, MPI_Datatype recvtype,
-                 int root, MPI_Comm)
+                 int root, MPI_Comm comm)
 {
+    mpi_wait_state::enter_collective(_data.tool_id.c_str(), comm);
+
     int _send_size = mpi_type_size(sendtype);
     int _recv_size = mpi_type_size(recvtype);
     if(_send_size == 0 || _recv_size == 0) return;
 
     write_perfetto_counter_track<mpi_send>(sendcount * _send_size);
     write_perfetto_counter_track<mpi_recv>(recvcount * _recv_size);
+    record_message(comm_send, sendcount * _send_size);
+    record_message(comm_recv, recvcount * _recv_size);
 
     if(!rocprofsys::get_use_timemory()) return;
     auto      _name = std::string_view{ _data.tool_id };
@@ -279,14 +866,18 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, int sen
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, int sendcount,
                  MPI_Datatype sendtype, void*, int recvcount, MPI_Datatype recvtype,
-                 MPI_Comm)
+                 MPI_Comm comm)
 {
+    mpi_wait_state::enter_collective(_data.tool_id.c_str(), comm);
+
     int _send_size = mpi_type_size(sendtype);
     int _recv_size = mpi_type_size(recvtype);
     if(_send_size == 0 || _recv_size == 0) return;
 
     write_perfetto_counter_track<mpi_send>(sendcount * _send_size);
     write_perfetto_counter_track<mpi_recv>(recvcount * _recv_size);
+    record_message(comm_send, sendcount * _send_size);
+    record_message(comm_recv, recvcount * _recv_size);
 
     if(!rocprofsys::get_use_timemory()) return;
     auto      _name = std::string_view{ _data.tool_id };
@@ -295,6 +886,77 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, int sen
     add(JOIN('/', _name, "send"), sendcount * _send_size);
     add(JOIN('/', _name, "recv"), recvcount * _recv_size);
 }
+
+// MPI_Barrier
+void
+comm_data::audit(const gotcha_data& _data, audit::incoming, MPI_Comm comm)
+{
+    mpi_wait_state::enter_collective(_data.tool_id.c_str(), comm);
+}
+
+// MPI_Wait
+void
+comm_data::audit(const gotcha_data& _data, audit::incoming, MPI_Request* request,
+                 MPI_Status* status)
+{
+    if(_data.tool_id == "MPI_Wait")
+        mpi_wait_state::enter_completion(1, request, nullptr, nullptr, nullptr, status);
+}
+
+// MPI_Test
+void
+comm_data::audit(const gotcha_data& _data, audit::incoming, MPI_Request* request,
+                 int* flag, MPI_Status* status)
+{
+    if(_data.tool_id == "MPI_Test")
+        mpi_wait_state::enter_completion(1, request, flag, nullptr, nullptr, status);
+}
+
+// MPI_Waitall
+void
+comm_data::audit(const gotcha_data& _data, audit::incoming, int count,
+                 MPI_Request* requests, MPI_Status* statuses)
+{
+    if(_data.tool_id == "MPI_Waitall")
+        mpi_wait_state::enter_completion(count, requests, nullptr, nullptr, nullptr,
+                                         statuses);
+}
+
+// MPI_Testall
+// MPI_Waitany
+void
+comm_data::audit(const gotcha_data& _data, audit::incoming, int count,
+                 MPI_Request* requests, int* value, MPI_Status* statuses)
+{
+    if(_data.tool_id == "MPI_Testall")
+        mpi_wait_state::enter_completion(count, requests, value, nullptr, nullptr,
+                                         statuses);
+    else if(_data.tool_id == "MPI_Waitany")
+        mpi_wait_state::enter_completion(count, requests, nullptr, nullptr, value,
+                                         statuses);
+}
+
+// MPI_Testany
+// MPI_Waitsome
+// MPI_Testsome
+void
+comm_data::audit(const gotcha_data& _data, audit::incoming, int count,
+                 MPI_Request* requests, int* first, int* second, MPI_Status* statuses)
+{
+    if(_data.tool_id == "MPI_Testany")
+        mpi_wait_state::enter_completion(count, requests, second, nullptr, first,
+                                         statuses);
+    else if(_data.tool_id == "MPI_Waitsome" || _data.tool_id == "MPI_Testsome")
+        mpi_wait_state::enter_completion(count, requests, nullptr, first, second,
+                                         statuses);
+}
+
+// return of any wrapped MPI function
+void
+comm_data::audit(const gotcha_data&, audit::outgoing, int)
+{
+    mpi_wait_state::exit();
+}
 #endif
 
 #if defined(ROCPROFSYS_USE_RCCL)
@@ -48,6 +48,7 @@
 #include <set>
 #include <string>
 #include <utility>
+#include <vector>
 
 ROCPROFSYS_COMPONENT_ALIAS(comm_data_tracker_t,
                            ::tim::component::data_tracker<float, project::rocprofsys>)
@@ -95,6 +96,11 @@ struct comm_data : base<comm_data, void>
     static void preinit();
     static void configure();
     static void global_finalize();
+
+    // flushes the pending perfetto counter samples, writes the per-peer breakdown and
+    // reduces the communication matrix across ranks when ROCPROFSYS_MPIP_COMM_MATRIX
+    // is enabled. Must be called by every rank before MPI is finalized
+    static void post_process();
     static void start() {}
     static void stop() {}
 
@@ -106,6 +112,25 @@ struct comm_data : base<comm_data, void>
         return _size;
     }
 
+    // rank in MPI_COMM_WORLD of each rank of the communicator (of the remote group for
+    // an inter-communicator). MPI_UNDEFINED when there is no equivalent world rank
+    static std::vector<int> mpi_world_ranks(MPI_Comm _comm);
+
+    struct mpi_comm_info
+    {
+        bool             valid  = false;  // intra-communicator of world ranks
+        uint64_t         id     = 0;      // unique per communicator in this process
+        uint64_t         hash   = 0;      // of the membership, same on every rank
+        int              leader = -1;     // lowest world rank of the members
+        std::vector<int> world  = {};     // see mpi_world_ranks
+    };
+
+    // the data is cached as an attribute of the communicator which MPI deletes when
+    // the communicator is freed, i.e. a communicator handle which is re-used after
+    // MPI_Comm_free never returns the data of the freed communicator. Returns nullptr
+    // for MPI_COMM_NULL
+    static std::shared_ptr<const mpi_comm_info> get_mpi_comm_info(MPI_Comm _comm);
+
     // MPI_Send
     static void audit(const gotcha_data& _data, audit::incoming, const void*, int count,
                       MPI_Datatype datatype, int dst, int tag, MPI_Comm);
@@ -146,6 +171,35 @@ struct comm_data : base<comm_data, void>
     static void audit(const gotcha_data& _data, audit::incoming, const void*,
                       int sendcount, MPI_Datatype sendtype, void*, int recvcount,
                       MPI_Datatype recvtype, MPI_Comm);
+
+    // MPI_Barrier
+    static void audit(const gotcha_data& _data, audit::incoming, MPI_Comm);
+
+    // MPI_Wait
+    static void audit(const gotcha_data& _data, audit::incoming, MPI_Request*,
+                      MPI_Status*);
+
+    // MPI_Test
+    static void audit(const gotcha_data& _data, audit::incoming, MPI_Request*, int*,
+                      MPI_Status*);
+
+    // MPI_Waitall
+    static void audit(const gotcha_data& _data, audit::incoming, int, MPI_Request*,
+                      MPI_Status*);
+
+    // MPI_Testall
+    // MPI_Waitany
+    static void audit(const gotcha_data& _data, audit::incoming, int, MPI_Request*,
+                      int*, MPI_Status*);
+
+    // MPI_Testany
+    // MPI_Waitsome
+    // MPI_Testsome
+    static void audit(const gotcha_data& _data, audit::incoming, int, MPI_Request*,
+                      int*, int*, MPI_Status*);
+
+    // return of any wrapped MPI function. Completes the wait-state record of the call
+    static void audit(const gotcha_data&, audit::outgoing, int);
 #endif
 
 #if defined(ROCPROFSYS_USE_RCCL)
@@ -24,6 +24,7 @@
 #include "core/common.hpp"
 #include "core/components/fwd.hpp"
 #include "core/config.hpp"
+#include "core/cpu_freq_files.hpp"
 #include "core/debug.hpp"
 #include "core/defines.hpp"
 #include "core/perfetto.hpp"
@@ -36,12 +37,39 @@
 #include <timemory/utility/procfs/cpuinfo.hpp>
 #include <timemory/utility/type_list.hpp>
 
+#include <memory>
+#include <unistd.h>
+#include <vector>
+
 namespace cpuinfo = tim::procfs::cpuinfo;
 
 namespace rocprofsys
 {
 namespace component
 {
+namespace
+{
+// one descriptor per enabled cpu (in the iteration order of get_enabled_cpus()).
+// a value of -1 means the cpufreq sysfs entry is unavailable and the frequency
+// for that cpu is read from /proc/cpuinfo instead
+auto&
+get_sysfs_fds()
+{
+    static auto _v = std::vector<int>{};
+    return _v;
+}
+
+void
+close_sysfs_fds()
+{
+    for(auto& itr : get_sysfs_fds())
+    {
+        if(itr >= 0) ::close(itr);
+    }
+    get_sysfs_fds().clear();
+}
+}  // namespace
+
 cpu_freq::cpu_id_set_t&
 cpu_freq::get_enabled_cpus()
 {
@@ -154,6 +182,27 @@ cpu_freq::configure()
                        ":: unable to open /proc/cpuinfo");
 
     get_enabled_cpus() = _enabled_freqs;
+
+    close_sysfs_fds();
+    size_t _nsysfs = 0;
+    for(auto itr : get_enabled_cpus())
+    {
+        auto _fd = cpu_freq_files::open_cur_freq(itr);
+        if(_fd >= 0) ++_nsysfs;
+        get_sysfs_fds().emplace_back(_fd);
+    }
+
+    ROCPROFSYS_VERBOSE(2,
+                       "[cpu_freq::config] reading %zu of %zu cpu frequencies from sysfs "
+                       "(remainder from /proc/cpuinfo)\n",
+                       _nsysfs, get_enabled_cpus().size());
+}
+
+void
+cpu_freq::finalize()
+{
+    close_sysfs_fds();
+    get_enabled_cpus().clear();
 }
 
 std::string
@@ -167,14 +216,30 @@ cpu_freq::record()
 {
     auto& enabled_cpu_freqs = get_enabled_cpus();
 
+    auto& _fds              = get_sysfs_fds();
+
     std::vector<uint64_t> _freqs{};
     if(!enabled_cpu_freqs.empty())
     {
         _freqs.reserve(enabled_cpu_freqs.size());
-        auto&& _freq = cpuinfo::freq{};
+        // only parse /proc/cpuinfo when at least one cpu has no usable sysfs entry
+        auto   _cpuinfo = std::unique_ptr<cpuinfo::freq>{};
+        size_t _n       = 0;
         for(const auto& itr : enabled_cpu_freqs)
         {
-            _freqs.emplace_back(_freq(itr) * tim::units::MHz);
+            uint64_t _value = 0;
+            auto     _fd    = (_n < _fds.size()) ? _fds.at(_n) : -1;
+            if(_fd >= 0 && cpu_freq_files::read_cur_freq(_fd, _value))
+            {
+                _value *= (tim::units::MHz / 1000);
+            }
+            else
+            {
+                if(!_cpuinfo) _cpuinfo = std::make_unique<cpuinfo::freq>();
+                _value = (*_cpuinfo)(itr) * tim::units::MHz;
+            }
+            _freqs.emplace_back(_value);
+            ++_n;
         }
     }
 
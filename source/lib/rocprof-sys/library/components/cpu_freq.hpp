@@ -53,6 +53,7 @@ struct cpu_freq
     static std::string display_unit();
 
     static void          configure();
+    static void          finalize();
     static cpu_id_set_t& get_enabled_cpus();
     static value_type    record();
 
@@ -25,21 +25,70 @@
 #include "core/debug.hpp"
 #include "core/utility.hpp"
 #include "library/components/category_region.hpp"
+#include "library/call_site.hpp"
+#include "library/lock_contention.hpp"
 #include "library/runtime.hpp"
 #include "library/thread_info.hpp"
+#include "library/tracing.hpp"
 
 #include <timemory/backends/threading.hpp>
 #include <timemory/utility/signals.hpp>
 #include <timemory/utility/types.hpp>
 
+#include <cerrno>
 #include <cstdint>
 #include <pthread.h>
 #include <stdexcept>
+#include <string_view>
 
 namespace rocprofsys
 {
 namespace component
 {
+namespace
+{
+struct local_dtor
+{
+    explicit local_dtor(bool& _v)
+    : _protect{ _v }
+    {}
+    ~local_dtor() { _protect = false; }
+    bool& _protect;
+};
+
+auto
+get_lock_op(std::string_view _name)
+{
+    using lock_op = pthread_mutex_gotcha::lock_op;
+
+    if(_name.find("unlock") != std::string_view::npos) return lock_op::release;
+    if(_name.find("try") != std::string_view::npos) return lock_op::try_acquire;
+    if(_name == "pthread_rwlock_wrlock") return lock_op::acquire_write;
+    if(_name == "pthread_mutex_lock" || _name == "pthread_rwlock_rdlock" ||
+       _name == "pthread_spin_lock")
+        return lock_op::acquire;
+    return lock_op::other;
+}
+
+int
+try_acquire(pthread_mutex_t* _lock, bool)
+{
+    return pthread_mutex_trylock(_lock);
+}
+
+int
+try_acquire(pthread_spinlock_t* _lock, bool)
+{
+    return pthread_spin_trylock(_lock);
+}
+
+int
+try_acquire(pthread_rwlock_t* _lock, bool _write)
+{
+    return (_write) ? pthread_rwlock_trywrlock(_lock) : pthread_rwlock_tryrdlock(_lock);
+}
+}  // namespace
+
 pthread_mutex_gotcha::hash_array_t&
 pthread_mutex_gotcha::get_hashes()
 {
@@ -96,6 +145,8 @@ pthread_mutex_gotcha::configure()
     pthread_mutex_gotcha_t::get_initializer() = []() {
         if(!tim::settings::enabled() || get_use_causal()) return;
 
+        lock_contention::configure();
+
         if(config::get_trace_thread_locks())
         {
             pthread_mutex_gotcha_t::configure(
@@ -167,7 +218,8 @@ pthread_mutex_gotcha::shutdown()
 }
 
 pthread_mutex_gotcha::pthread_mutex_gotcha(const gotcha_data_t& _data)
-: m_data{ &_data }
+: m_op{ get_lock_op(_data.tool_id) }
+, m_data{ &_data }
 {}
 
 template <typename... Args>
@@ -190,14 +242,7 @@ pthread_mutex_gotcha::operator()(uintptr_t&&, int (*_callee)(Args...),
         return (*_callee)(_args...);
     }
 
-    struct local_dtor
-    {
-        explicit local_dtor(bool& _v)
-        : _protect{ _v }
-        {}
-        ~local_dtor() { _protect = false; }
-        bool& _protect;
-    } _dtor{ m_protect = true };
+    auto _dtor = local_dtor{ m_protect = true };
 
     bundle_t::audit(std::string_view{ m_data->tool_id }, audit::incoming{}, _args...);
     auto _ret = (*_callee)(_args...);
@@ -206,11 +251,52 @@ pthread_mutex_gotcha::operator()(uintptr_t&&, int (*_callee)(Args...),
     return _ret;
 }
 
+template <typename LockT>
+int
+pthread_mutex_gotcha::contended(int (*_callee)(LockT*), LockT* _lock) const
+{
+    auto _addr = reinterpret_cast<uintptr_t>(_lock);
+
+    // the holder bookkeeping below is a no-op unless lock holders are tracked
+    if(m_op == lock_op::release)
+    {
+        if(!is_disabled())
+        {
+            auto _dtor = local_dtor{ m_protect = true };
+            lock_contention::released(_addr);
+        }
+        return (*_callee)(_lock);
+    }
+    else if(m_op != lock_op::acquire && m_op != lock_op::acquire_write)
+    {
+        return (*_callee)(_lock);
+    }
+
+    // uncontended acquisitions are not measured and do not generate any events
+    auto _ret = try_acquire(_lock, m_op == lock_op::acquire_write);
+    if(_ret != EBUSY) return _ret;
+
+    if(is_disabled() || !m_data) return (*_callee)(_lock);
+
+    auto _dtor = local_dtor{ m_protect = true };
+
+    lock_contention::begin_wait(_addr);
+    auto _beg = tracing::now();
+    _ret      = (*_callee)(_lock);
+    auto _end = tracing::now();
+
+    lock_contention::record_wait(m_data->tool_id.c_str(), _addr, call_site::get(), _beg,
+                                 _end);
+
+    return _ret;
+}
+
 int
 pthread_mutex_gotcha::operator()(int (*_callee)(pthread_mutex_t*),
                                  pthread_mutex_t* _mutex) const
 {
     if(get_state() != ::rocprofsys::State::Active || m_protect) return (*_callee)(_mutex);
+    if(lock_contention::enabled()) return contended(_callee, _mutex);
     return (*this)(reinterpret_cast<uintptr_t>(_mutex), _callee, _mutex);
 }
 
@@ -219,6 +305,7 @@ pthread_mutex_gotcha::operator()(int (*_callee)(pthread_spinlock_t*),
                                  pthread_spinlock_t* _lock) const
 {
     if(get_state() != ::rocprofsys::State::Active || m_protect) return (*_callee)(_lock);
+    if(lock_contention::enabled()) return contended(_callee, _lock);
     return (*this)(reinterpret_cast<uintptr_t>(_lock), _callee, _lock);
 }
 
@@ -227,6 +314,7 @@ pthread_mutex_gotcha::operator()(int (*_callee)(pthread_rwlock_t*),
                                  pthread_rwlock_t* _lock) const
 {
     if(get_state() != ::rocprofsys::State::Active || m_protect) return (*_callee)(_lock);
+    if(lock_contention::enabled()) return contended(_callee, _lock);
     return (*this)(reinterpret_cast<uintptr_t>(_lock), _callee, _lock);
 }
 
@@ -61,6 +61,16 @@ struct pthread_mutex_gotcha : comp::base<pthread_mutex_gotcha, void>
     int operator()(int (*)(pthread_barrier_t*), pthread_barrier_t*) const;
     int operator()(int (*)(pthread_t, void**), pthread_t, void**) const;
 
+    // classification of the wrapped function for the contention-only mode
+    enum class lock_op : uint8_t
+    {
+        other = 0,      // barriers and join are always traced
+        acquire,        // pthread_mutex_lock, pthread_rwlock_rdlock, pthread_spin_lock
+        acquire_write,  // pthread_rwlock_wrlock
+        try_acquire,
+        release,
+    };
+
 private:
     static bool          is_disabled();
     static hash_array_t& get_hashes();
@@ -68,7 +78,11 @@ private:
     template <typename... Args>
     auto operator()(uintptr_t&&, int (*)(Args...), Args...) const;
 
+    template <typename LockT>
+    int contended(int (*)(LockT*), LockT*) const;
+
     mutable bool         m_protect = false;
+    lock_op              m_op      = lock_op::other;
     const gotcha_data_t* m_data    = nullptr;
 };
 
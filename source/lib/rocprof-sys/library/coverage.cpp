@@ -32,8 +32,12 @@
 #include <timemory/utility/popen.hpp>
 
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <map>
 #include <mutex>
+#include <optional>
+#include <shared_mutex>
 #include <string>
 #include <string_view>
 #include <type_traits>
@@ -51,11 +55,17 @@ namespace
 template <typename... Tp>
 using uomap_t = std::unordered_map<Tp...>;
 //
-using coverage_thread_data_type =
-    uomap_t<std::string_view, uomap_t<std::string_view, std::map<size_t, size_t>>>;
+// hit counts of each thread, indexed by the dense index assigned to the site when
+// it was registered
+using coverage_thread_data_type = std::vector<uint64_t>;
 //
 using coverage_data_vector = std::vector<coverage_data>;
 //
+// dense index of the registered sites, only used to deduplicate the registrations and
+// by the (file, function, address) variant of the coverage API
+using coverage_index_map =
+    uomap_t<std::string_view, uomap_t<std::string_view, std::map<size_t, uint32_t>>>;
+//
 using coverage_data_map =
     uomap_t<std::string_view,
             uomap_t<std::string_view, std::map<size_t, coverage_data_vector::iterator>>>;
@@ -85,10 +95,68 @@ get_coverage_data()
 }
 //
 auto&
+get_coverage_index()
+{
+    static auto _v = coverage_index_map{};
+    return _v;
+}
+//
+auto&
+get_coverage_index_mutex()
+{
+    static auto _v = std::shared_mutex{};
+    return _v;
+}
+//
+auto&
+get_coverage_sites()
+{
+    static auto _v = std::atomic<uint32_t>{ 0 };
+    return _v;
+}
+//
+auto&
 get_coverage_count(int64_t _tid = tim::threading::get_id())
 {
     return coverage_thread_data::instance(construct_on_thread{ _tid });
 }
+//
+uint32_t
+register_site(const char* file, const char* func, size_t line, size_t address,
+              const char* source)
+{
+    std::unique_lock<std::shared_mutex> _lk{ get_coverage_index_mutex() };
+
+    auto& _index = get_coverage_index()[file][func];
+    auto  itr    = _index.find(address);
+    if(itr != _index.end()) return itr->second;
+
+    auto _idx = static_cast<uint32_t>(get_coverage_data().size());
+    get_coverage_data().emplace_back(
+        coverage_data{ size_t{ 0 }, address, line, file, func,
+                       (source && strlen(source) > 0) ? source : func });
+
+    get_code_coverage().size += 1;
+    get_code_coverage().possible.modules.emplace(file);
+    get_code_coverage().possible.functions.emplace(func);
+    get_code_coverage().possible.addresses.emplace(address);
+
+    _index.emplace(address, _idx);
+    get_coverage_sites().store(_idx + 1, std::memory_order_release);
+    return _idx;
+}
+//
+inline void
+increment(uint32_t _idx)
+{
+    auto& _counts = get_coverage_count();
+    if(ROCPROFSYS_UNLIKELY(_idx >= _counts->size()))
+    {
+        _counts->resize(std::max<size_t>(
+            _idx + 1, get_coverage_sites().load(std::memory_order_acquire)));
+    }
+    ++(*_counts)[_idx];
+}
 }  // namespace
 
 //--------------------------------------------------------------------------------------//
@@ -96,8 +164,6 @@ get_coverage_count(int64_t _tid = tim::threading::get_id())
 void
 post_process()
 {
-    using data_tuple_t = coverage_data::data_tuple_t;
-
     if(get_post_processed()) return;
     get_post_processed() = true;
 
@@ -114,68 +180,24 @@ post_process()
         return;
     }
 
-    auto _data = coverage_thread_data_type{};
+    // the registered sites are never removed so the index of the site in the coverage
+    // data is the index into the per-thread counts
+    for(const auto& itr : *coverage_thread_data::get())
     {
-        auto _coverage_map = coverage_data_map{};
-        auto _find         = [&_coverage_data, &_coverage_map](data_tuple_t&& _v) {
-            auto& _cache = _coverage_map[std::get<0>(_v)][std::get<1>(_v)];
-            auto  mitr   = _cache.find(std::get<2>(_v));
-            if(mitr != _cache.end()) return std::make_pair(mitr->second, true);
-
-            for(auto itr = _coverage_data.begin(); itr != _coverage_data.end(); ++itr)
-            {
-                if(*itr == _v)
-                {
-                    _cache[std::get<2>(_v)] = itr;
-                    return std::make_pair(itr, true);
-                }
-            }
-            return std::make_pair(_coverage_data.end(), false);
-        };
-
-        for(size_t i = 0; i < coverage_thread_data::size(); ++i)
-        {
-            const auto& _thr_data = *get_coverage_count(i);
-            for(const auto& file : _thr_data)
-            {
-                for(const auto& func : file.second)
-                {
-                    for(const auto& addr : func.second)
-                    {
-                        _data[file.first][func.first][addr.first] += addr.second;
-                        auto&& _v = _find({ file.first, func.first, addr.first });
-                        if(_v.second)
-                        {
-                            _v.first->count += addr.second;
-                        }
-                        else
-                        {
-                            ROCPROFSYS_VERBOSE_F(0,
-                                                 "Warning! No matching coverage data for "
-                                                 "%s :: %s (0x%x)\n",
-                                                 func.first.data(), file.first.data(),
-                                                 (unsigned int) addr.first);
-                        }
-                    }
-                }
-            }
-        }
+        if(!itr) continue;
+        auto _n = std::min(itr->size(), _coverage_data.size());
+        for(size_t i = 0; i < _n; ++i)
+            _coverage_data.at(i).count += itr->at(i);
     }
 
-    for(const auto& file : _data)
+    for(const auto& itr : _coverage_data)
     {
-        for(const auto& func : file.second)
+        if(itr.count > 0)
         {
-            for(const auto& addr : func.second)
-            {
-                if(addr.second > 0)
-                {
-                    _coverage.count += 1;
-                    _coverage.covered.modules.emplace(file.first);
-                    _coverage.covered.functions.emplace(func.first);
-                    _coverage.covered.addresses.emplace(addr.first);
-                }
-            }
+            _coverage.count += 1;
+            _coverage.covered.modules.emplace(itr.module);
+            _coverage.covered.functions.emplace(itr.function);
+            _coverage.covered.addresses.emplace(itr.address);
         }
     }
 
@@ -306,25 +328,27 @@ rocprofsys_register_source_hidden(const char* file, const char* func, size_t lin
 {
     if(coverage::get_post_processed()) return;
 
-    using coverage_data = coverage::coverage_data;
-
     ROCPROFSYS_BASIC_VERBOSE_F(4, "[0x%x] :: %-20s :: %20s:%zu :: %s\n",
                                (unsigned int) address, func, file, line, source);
 
-    coverage::get_coverage_data().emplace_back(
-        coverage_data{ size_t{ 0 }, address, line, file, func,
-                       (source && strlen(source) > 0) ? source : func });
+    coverage::register_site(file, func, line, address, source);
+}
 
-    coverage::get_code_coverage().size += 1;
-    coverage::get_code_coverage().possible.modules.emplace(file);
-    coverage::get_code_coverage().possible.functions.emplace(func);
-    coverage::get_code_coverage().possible.addresses.emplace(address);
+//--------------------------------------------------------------------------------------//
 
-    // initialize
-    for(size_t i = 0; i < coverage::coverage_thread_data::size(); ++i)
-    {
-        (*coverage::get_coverage_count(i))[file][func].emplace(address, 0);
-    }
+extern "C" void
+rocprofsys_register_source_index_hidden(const char* file, const char* func, size_t line,
+                                        size_t address, const char* source,
+                                        uint32_t* index)
+{
+    if(coverage::get_post_processed()) return;
+
+    ROCPROFSYS_BASIC_VERBOSE_F(4, "[0x%x] :: %-20s :: %20s:%zu :: %s\n",
+                               (unsigned int) address, func, file, line, source);
+
+    // zero is reserved for a site which has not been registered yet
+    auto _idx = coverage::register_site(file, func, line, address, source);
+    if(index) *index = _idx + 1;
 }
 
 //--------------------------------------------------------------------------------------//
@@ -341,7 +365,43 @@ rocprofsys_register_coverage_hidden(const char* file, const char* func, size_t a
 
     ROCPROFSYS_BASIC_VERBOSE_F(3, "[0x%x] %-20s :: %20s\n", (unsigned int) address, func,
                                file);
-    (*coverage::get_coverage_count())[file][func][address] += 1;
+
+    auto _idx = std::optional<uint32_t>{};
+    {
+        std::shared_lock<std::shared_mutex> _lk{ coverage::get_coverage_index_mutex() };
+        auto& _index = coverage::get_coverage_index();
+        auto  fitr   = _index.find(file);
+        if(fitr != _index.end())
+        {
+            auto itr = fitr->second.find(func);
+            if(itr != fitr->second.end())
+            {
+                auto aitr = itr->second.find(address);
+                if(aitr != itr->second.end()) _idx = aitr->second;
+            }
+        }
+    }
+
+    if(_idx)
+        coverage::increment(*_idx);
+    else
+        ROCPROFSYS_BASIC_VERBOSE_F(2, "No matching coverage data for %s :: %s (0x%x)\n",
+                                   func, file, (unsigned int) address);
+}
+
+//--------------------------------------------------------------------------------------//
+
+extern "C" void
+rocprofsys_register_coverage_index_hidden(uint32_t index)
+{
+    if(index == 0 || coverage::get_post_processed()) return;
+    if(rocprofsys::get_state() < rocprofsys::State::Active &&
+       !rocprofsys_init_tooling_hidden())
+        return;
+    else if(rocprofsys::get_state() >= rocprofsys::State::Finalized)
+        return;
+
+    coverage::increment(index - 1);
 }
 
 //--------------------------------------------------------------------------------------//
@@ -24,6 +24,7 @@
 #include "core/common.hpp"
 #include "core/components/fwd.hpp"
 #include "core/config.hpp"
+#include "core/cpu_freq_files.hpp"
 #include "core/debug.hpp"
 #include "core/defines.hpp"
 #include "core/perfetto.hpp"
@@ -64,6 +65,8 @@ void init_perfetto_counter_tracks(type_list<Types...>)
 {
     (perfetto_counter_track<Types>::init(), ...);
 }
+
+cpu_freq_files::statm_file statm = {};
 }  // namespace
 }  // namespace cpu_freq
 }  // namespace rocprofsys
@@ -93,12 +96,21 @@ sample()
 {
     auto _ts = tim::get_clock_real_now<size_t, std::nano>();
 
-    auto _rcache = tim::rusage_cache{ RUSAGE_SELF };
-    auto _freqs  = component::cpu_freq{}.sample();
+    auto    _rcache = tim::rusage_cache{ RUSAGE_SELF };
+    auto    _freqs  = component::cpu_freq{}.sample();
+    int64_t _virt   = 0;
+    int64_t _rss    = 0;
+
+    // a single read of /proc/self/statm provides both the virtual and resident size
+    if(!statm.read(_virt, _rss))
+    {
+        _virt = tim::get_virt_mem();
+        _rss  = tim::get_page_rss();
+    }
 
     // user and kernel mode times are in microseconds
     data.emplace_back(
-        _ts, tim::get_page_rss(), tim::get_virt_mem(), _rcache.get_peak_rss(),
+        _ts, _rss, _virt, _rcache.get_peak_rss(),
         _rcache.get_num_priority_context_switch() +
             _rcache.get_num_voluntary_context_switch(),
         _rcache.get_num_major_page_faults() + _rcache.get_num_minor_page_faults(),
@@ -241,14 +253,15 @@ post_process()
 
     _process_cpu_rusage();
 
-    auto& enabled_cpu_freqs = component::cpu_freq::get_enabled_cpus();
+    const auto& enabled_cpu_freqs = component::cpu_freq::get_enabled_cpus();
     for(auto itr = enabled_cpu_freqs.begin(); itr != enabled_cpu_freqs.end(); ++itr)
     {
         auto _idx    = *itr;
         auto _offset = std::distance(enabled_cpu_freqs.begin(), itr);
         _process_frequencies(_idx, _offset);
     }
-    enabled_cpu_freqs.clear();
+    component::cpu_freq::finalize();
+    statm.close();
 }
 }  // namespace cpu_freq
 }  // namespace rocprofsys
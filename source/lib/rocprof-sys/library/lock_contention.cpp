@@ -0,0 +1,549 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/lock_contention.hpp"
+#include "core/categories.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/timemory.hpp"
+#include "library/call_site.hpp"
+#include "library/thread_data.hpp"
+#include "library/thread_info.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/backends/threading.hpp>
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/settings/settings.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace rocprofsys
+{
+namespace lock_contention
+{
+namespace
+{
+struct wait_key
+{
+    uintptr_t lock = 0;
+    uintptr_t site = 0;
+
+    bool operator==(const wait_key& _v) const
+    {
+        return lock == _v.lock && site == _v.site;
+    }
+};
+
+struct wait_key_hash
+{
+    size_t operator()(const wait_key& _v) const
+    {
+        return std::hash<uintptr_t>{}(_v.lock) ^ (std::hash<uintptr_t>{}(_v.site) << 1);
+    }
+};
+
+// wait time histogram with power-of-two nanosecond buckets
+struct wait_stats
+{
+    static constexpr size_t num_buckets = 64;
+
+    const char*                        name    = nullptr;
+    uint64_t                           count   = 0;
+    uint64_t                           total   = 0;
+    uint64_t                           max     = 0;
+    std::array<uint64_t, num_buckets> buckets = {};
+
+    wait_stats& operator+=(uint64_t _wait)
+    {
+        auto _idx = (_wait == 0) ? 0 : (63 - __builtin_clzll(_wait));
+        ++count;
+        total += _wait;
+        max = std::max(max, _wait);
+        ++buckets.at(_idx);
+        return *this;
+    }
+
+    wait_stats& operator+=(const wait_stats& _v)
+    {
+        if(!name) name = _v.name;
+        count += _v.count;
+        total += _v.total;
+        max = std::max(max, _v.max);
+        for(size_t i = 0; i < num_buckets; ++i)
+            buckets.at(i) += _v.buckets.at(i);
+        return *this;
+    }
+
+    // upper bound of the bucket containing the given percentile
+    uint64_t percentile(double _p) const
+    {
+        auto     _target = static_cast<uint64_t>(_p * count);
+        uint64_t _cumsum = 0;
+        for(size_t i = 0; i < num_buckets; ++i)
+        {
+            _cumsum += buckets.at(i);
+            if(_cumsum > _target || _cumsum == count)
+                return std::min<uint64_t>((uint64_t{ 2 } << i) - 1, max);
+        }
+        return max;
+    }
+};
+
+// the most recent release of a lock by a thread while another thread was waiting
+struct lock_slot
+{
+    std::atomic<uintptr_t> lock         = { 0 };
+    std::atomic<int64_t>   owner        = { -1 };
+    std::atomic<uint32_t>  waiters      = { 0 };
+    std::atomic<int64_t>   release_tid  = { -1 };
+    std::atomic<uintptr_t> release_site = { 0 };
+    std::atomic<uint64_t>  release_ts   = { 0 };
+};
+
+// a contended wait above the threshold and the holder it is attributed to
+struct wait_event
+{
+    const char* name        = nullptr;
+    uintptr_t   lock        = 0;
+    uintptr_t   site        = 0;
+    uint64_t    beg         = 0;
+    uint64_t    end         = 0;
+    int64_t     tid         = -1;
+    int64_t     holder_tid  = -1;
+    uintptr_t   holder_site = 0;
+    uint64_t    release_ts  = 0;
+};
+
+// edges of the wait-for graph use wait_key{ holder call-site, waiter call-site }
+struct holder_data
+{
+    std::unordered_map<wait_key, wait_stats, wait_key_hash> edges = {};
+};
+
+struct graph_node
+{
+    std::string address = {};
+    std::string name    = {};
+
+    template <typename ArchiveT>
+    void serialize(ArchiveT& ar, const unsigned)
+    {
+        namespace cereal = tim::cereal;
+        ar(cereal::make_nvp("address", address), cereal::make_nvp("name", name));
+    }
+};
+
+struct graph_edge
+{
+    std::string function = {};
+    size_t      holder   = 0;
+    size_t      waiter   = 0;
+    uint64_t    count    = 0;
+    uint64_t    total_ns = 0;
+    uint64_t    max_ns   = 0;
+    uint64_t    p99_ns   = 0;
+
+    template <typename ArchiveT>
+    void serialize(ArchiveT& ar, const unsigned)
+    {
+        namespace cereal = tim::cereal;
+        ar(cereal::make_nvp("function", function), cereal::make_nvp("holder", holder),
+           cereal::make_nvp("waiter", waiter), cereal::make_nvp("count", count),
+           cereal::make_nvp("total_ns", total_ns), cereal::make_nvp("max_ns", max_ns),
+           cereal::make_nvp("p99_ns", p99_ns));
+    }
+};
+
+constexpr size_t   num_lock_slots = 4096;
+constexpr size_t   num_slot_probe = 8;
+constexpr uint64_t flow_id_base   = 0x4c4f434b00000000ULL;
+
+using wait_map_t            = std::unordered_map<wait_key, wait_stats, wait_key_hash>;
+using wait_data_instances   = thread_data<wait_map_t, category::pthread>;
+using holder_data_instances = thread_data<holder_data, category::pthread>;
+using lock_slot_array_t     = std::array<lock_slot, num_lock_slots>;
+
+bool                               is_enabled     = false;
+bool                               track_holders  = false;
+uint64_t                           wait_threshold = 0;
+std::unique_ptr<lock_slot_array_t> lock_slots     = {};
+std::atomic<uint64_t>              flow_count     = { 0 };
+
+// open-addressing table keyed by the lock address. Only locks which were contended
+// claim a slot and slots are never released: when the table is full, the lock is
+// simply not tracked and a warning is emitted once
+lock_slot*
+find_slot(uintptr_t _lock, bool _claim)
+{
+    if(!lock_slots) return nullptr;
+
+    auto _idx = static_cast<size_t>((_lock >> 3) * 0x9e3779b97f4a7c15ULL);
+    for(size_t i = 0; i < num_slot_probe; ++i)
+    {
+        auto& _slot = lock_slots->at((_idx + i) % num_lock_slots);
+        auto  _cur  = _slot.lock.load(std::memory_order_acquire);
+        if(_cur == _lock) return &_slot;
+        if(_cur == 0)
+        {
+            if(!_claim) return nullptr;
+            if(_slot.lock.compare_exchange_strong(_cur, _lock) || _cur == _lock)
+                return &_slot;
+        }
+    }
+
+    static auto _warned = std::atomic<bool>{ false };
+    if(_claim && !_warned.exchange(true))
+    {
+        ROCPROFSYS_WARNING_F(0,
+                             "[lock-contention] the table of %zu contended locks is "
+                             "saturated. The waits on the locks which do not fit are "
+                             "not attributed to their holders\n",
+                             num_lock_slots);
+    }
+    return nullptr;
+}
+
+void
+write_wait_for_graph(const wait_map_t& _edges)
+{
+    auto _nodes   = std::vector<graph_node>{};
+    auto _node_id = std::map<uintptr_t, size_t>{};
+    auto _get_id  = [&_nodes, &_node_id](uintptr_t _site) {
+        auto itr = _node_id.find(_site);
+        if(itr != _node_id.end()) return itr->second;
+        _nodes.emplace_back(graph_node{ as_hex(_site), call_site::get_name(_site) });
+        return _node_id.emplace(_site, _nodes.size() - 1).first->second;
+    };
+
+    auto _graph = std::vector<graph_edge>{};
+    for(const auto& itr : _edges)
+    {
+        const auto& _stats = itr.second;
+        _graph.emplace_back(graph_edge{ (_stats.name) ? _stats.name : "??",
+                                        _get_id(itr.first.lock), _get_id(itr.first.site),
+                                        _stats.count, _stats.total, _stats.max,
+                                        _stats.percentile(0.99) });
+    }
+
+    std::sort(_graph.begin(), _graph.end(), [](const auto& _lhs, const auto& _rhs) {
+        return _lhs.total_ns > _rhs.total_ns;
+    });
+
+    if(!_graph.empty())
+    {
+        const auto& _top = _graph.front();
+        ROCPROFSYS_VERBOSE(1,
+                           "[lock-contention] largest serialization point: %s held at "
+                           "%s blocked %s for %.3f msec (%lu waits)\n",
+                           _top.function.c_str(), _nodes.at(_top.holder).name.c_str(),
+                           _nodes.at(_top.waiter).name.c_str(), _top.total_ns / 1.0e6,
+                           static_cast<unsigned long>(_top.count));
+    }
+
+    std::stringstream oss{};
+    {
+        namespace cereal = tim::cereal;
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+        ar->setNextName("rocprofsys");
+        ar->startNode();
+        ar->setNextName("lock_wait_graph");
+        ar->startNode();
+        (*ar)(cereal::make_nvp("nodes", _nodes));
+        (*ar)(cereal::make_nvp("edges", _graph));
+        ar->finishNode();
+        ar->finishNode();
+    }
+
+    auto _fname = tim::settings::compose_output_filename("lock-wait-graph", ".json");
+    auto _ofs   = std::ofstream{};
+    if(!tim::filepath::open(_ofs, _fname))
+    {
+        ROCPROFSYS_VERBOSE(0, "Error opening lock wait-for graph output file: %s\n",
+                           _fname.c_str());
+        return;
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<tim::project::rocprofsys>{}(
+            _fname, std::string{ "lock wait-for graph" });
+    _ofs << oss.str() << "\n";
+}
+
+// emits the wait as a slice on the lock track of the waiting thread and, when the
+// release by the holder was published, a flow from the release to the wake-up
+void
+emit_wait_event(const wait_event& itr)
+{
+    auto _get_track = [](int64_t _tid) -> std::optional<::perfetto::Track> {
+        if(_tid < 0) return std::nullopt;
+        const auto& _info = thread_info::get(_tid, SequentTID);
+        if(!_info || !_info->index_data) return std::nullopt;
+        return tracing::get_perfetto_track(
+            category::pthread{},
+            [](auto _seq_id, auto _sys_id) {
+                return TIMEMORY_JOIN(" ", "Thread", _seq_id, "Locks", _sys_id);
+            },
+            _info->index_data->sequent_value, _info->index_data->system_value);
+    };
+
+    auto _waiter = _get_track(itr.tid);
+    if(!_waiter) return;
+
+    auto _annotate = [&itr](::perfetto::EventContext ctx) {
+        if(config::get_perfetto_annotations())
+        {
+            tracing::add_perfetto_annotation(ctx, "lock", as_hex(itr.lock));
+            tracing::add_perfetto_annotation(ctx, "site", as_hex(itr.site));
+            tracing::add_perfetto_annotation(ctx, "holder_tid", itr.holder_tid);
+            tracing::add_perfetto_annotation(ctx, "holder_site", as_hex(itr.holder_site));
+            tracing::add_perfetto_annotation(ctx, "wait_ns", itr.end - itr.beg);
+        }
+    };
+
+    tracing::push_perfetto_track(category::pthread{}, itr.name, *_waiter, itr.beg,
+                                 _annotate);
+    tracing::pop_perfetto_track(category::pthread{}, itr.name, *_waiter, itr.end);
+
+    // flow from the release by the holder to the wake-up of the waiter
+    auto _holder = (itr.release_ts > 0) ? _get_track(itr.holder_tid) : std::nullopt;
+    if(!_holder) return;
+
+    auto _flow_id = flow_id_base + flow_count.fetch_add(1, std::memory_order_relaxed);
+    tracing::mark_perfetto_track(category::pthread{}, "lock released", *_holder,
+                                 itr.release_ts,
+                                 ::perfetto::Flow::ProcessScoped(_flow_id), _annotate);
+    tracing::mark_perfetto_track(category::pthread{}, "lock acquired", *_waiter, itr.end,
+                                 ::perfetto::TerminatingFlow::ProcessScoped(_flow_id),
+                                 _annotate);
+}
+}  // namespace
+
+bool
+enabled()
+{
+    return is_enabled;
+}
+
+void
+configure()
+{
+    is_enabled = config::get_trace_thread_lock_contention();
+    if(!is_enabled) return;
+
+    wait_threshold =
+        static_cast<uint64_t>(config::get_trace_thread_lock_wait_threshold() * 1000.0);
+    track_holders = config::get_trace_thread_lock_holders();
+    if(track_holders && !lock_slots) lock_slots = std::make_unique<lock_slot_array_t>();
+    call_site::configure();
+}
+
+void
+released(uintptr_t _lock)
+{
+    if(!track_holders) return;
+
+    // locks which were never contended do not have a slot: a single load
+    auto* _slot = find_slot(_lock, false);
+    if(!_slot) return;
+
+    auto _tid = threading::get_id();
+    if(_slot->waiters.load(std::memory_order_relaxed) > 0)
+    {
+        _slot->release_tid.store(_tid, std::memory_order_relaxed);
+        _slot->release_site.store(call_site::get(), std::memory_order_relaxed);
+        _slot->release_ts.store(tracing::now(), std::memory_order_release);
+    }
+
+    // the owner is only known for contended acquisitions. Clear it so that a later
+    // wait is never attributed to a thread which no longer holds the lock
+    if(_slot->owner.load(std::memory_order_relaxed) == _tid)
+        _slot->owner.store(-1, std::memory_order_relaxed);
+}
+
+void
+begin_wait(uintptr_t _lock)
+{
+    if(!track_holders) return;
+    auto* _slot = find_slot(_lock, true);
+    if(_slot) _slot->waiters.fetch_add(1, std::memory_order_relaxed);
+}
+
+void
+record_wait(const char* _name, uintptr_t _lock, uintptr_t _site, uint64_t _beg,
+            uint64_t _end)
+{
+    auto  _tid  = threading::get_id();
+    auto  _wait = (_end > _beg) ? (_end - _beg) : uint64_t{ 0 };
+    auto& _data = wait_data_instances::instance(construct_on_thread{ _tid });
+
+    auto& _stats = (*_data)[wait_key{ _lock, _site }];
+    _stats.name  = _name;
+    _stats += _wait;
+
+    if(track_holders)
+    {
+        auto* _slot = find_slot(_lock, false);
+        if(!_slot) return;
+
+        _slot->waiters.fetch_sub(1, std::memory_order_relaxed);
+
+        // the holder is the thread which released the lock during the wait. If the
+        // release was not published (e.g. the lock was released before this thread
+        // registered as a waiter), fall back to the owner recorded by the previous
+        // contended acquisition, if it still holds the lock, with an unknown
+        // call-site
+        auto _event       = wait_event{ _name, _lock, _site, _beg, _end, _tid };
+        _event.release_ts = _slot->release_ts.load(std::memory_order_acquire);
+        if(_event.release_ts >= _beg && _event.release_ts <= _end)
+        {
+            _event.holder_tid  = _slot->release_tid.load(std::memory_order_relaxed);
+            _event.holder_site = _slot->release_site.load(std::memory_order_relaxed);
+        }
+        else
+        {
+            _event.holder_tid = _slot->owner.load(std::memory_order_relaxed);
+            _event.release_ts = 0;
+        }
+        _slot->owner.store(_tid, std::memory_order_relaxed);
+
+        auto& _holder = holder_data_instances::instance(construct_on_thread{ _tid });
+        auto& _edge   = _holder->edges[wait_key{ _event.holder_site, _site }];
+        _edge.name    = _name;
+        _edge += _wait;
+
+        if(_wait >= wait_threshold && get_use_perfetto()) emit_wait_event(_event);
+        return;
+    }
+
+    if(_wait >= wait_threshold && get_use_perfetto())
+    {
+        tracing::push_perfetto_ts(
+            category::pthread{}, _name, _beg, [&](::perfetto::EventContext ctx) {
+                if(config::get_perfetto_annotations())
+                {
+                    tracing::add_perfetto_annotation(ctx, "lock", as_hex(_lock));
+                    tracing::add_perfetto_annotation(ctx, "site", as_hex(_site));
+                    tracing::add_perfetto_annotation(ctx, "wait_ns", _wait);
+                }
+            });
+        tracing::pop_perfetto_ts(category::pthread{}, _name, _end);
+    }
+}
+
+void
+post_process()
+{
+    if(!is_enabled || !wait_data_instances::get()) return;
+
+    auto _combined = wait_map_t{};
+    for(const auto& itr : *wait_data_instances::get())
+    {
+        if(!itr) continue;
+        for(const auto& iitr : *itr)
+            _combined[iitr.first] += iitr.second;
+    }
+
+    auto _sorted = std::vector<std::pair<wait_key, wait_stats>>{ _combined.begin(),
+                                                                 _combined.end() };
+    std::sort(_sorted.begin(), _sorted.end(), [](const auto& _lhs, const auto& _rhs) {
+        return _lhs.second.total > _rhs.second.total;
+    });
+
+    uint64_t _count = 0;
+    uint64_t _total = 0;
+    for(const auto& itr : _sorted)
+    {
+        _count += itr.second.count;
+        _total += itr.second.total;
+    }
+
+    ROCPROFSYS_VERBOSE(1,
+                       "[lock-contention] %lu contended acquisitions from %zu lock + "
+                       "call-site pairs waited %.3f msec in total\n",
+                       static_cast<unsigned long>(_count), _sorted.size(),
+                       _total / 1.0e6);
+
+    if(_sorted.empty()) return;
+
+    auto _fname = tim::settings::compose_output_filename("lock-contention", ".txt");
+    auto _ofs   = std::ofstream{};
+    if(!tim::filepath::open(_ofs, _fname))
+    {
+        ROCPROFSYS_VERBOSE(0, "Error opening lock contention output file: %s\n",
+                           _fname.c_str());
+        return;
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<tim::project::rocprofsys>{}(
+            _fname, std::string{ "lock contention" });
+
+    auto _usec = [](uint64_t _v) { return static_cast<double>(_v) / 1.0e3; };
+
+    _ofs << std::left << std::setw(24) << "# function" << std::setw(20) << "lock"
+         << std::right << std::setw(10) << "count" << std::setw(16) << "total (usec)"
+         << std::setw(14) << "mean (usec)" << std::setw(14) << "max (usec)"
+         << std::setw(14) << "p99 (usec)" << "  call-site\n";
+    _ofs << std::fixed << std::setprecision(3);
+    for(const auto& itr : _sorted)
+    {
+        const auto& _stats = itr.second;
+        _ofs << std::left << std::setw(24) << ((_stats.name) ? _stats.name : "??")
+             << std::setw(20) << as_hex(itr.first.lock) << std::right << std::setw(10)
+             << _stats.count << std::setw(16) << _usec(_stats.total) << std::setw(14)
+             << _usec(_stats.total) / std::max<uint64_t>(_stats.count, 1)
+             << std::setw(14) << _usec(_stats.max) << std::setw(14)
+             << _usec(_stats.percentile(0.99)) << "  "
+             << call_site::get_name(itr.first.site) << "\n";
+    }
+    _ofs.close();
+
+    if(!track_holders || !holder_data_instances::get()) return;
+
+    auto _edges = wait_map_t{};
+    for(const auto& itr : *holder_data_instances::get())
+    {
+        if(!itr) continue;
+        for(const auto& iitr : itr->edges)
+            _edges[iitr.first] += iitr.second;
+    }
+
+    write_wait_for_graph(_edges);
+}
+}  // namespace lock_contention
+}  // namespace rocprofsys
@@ -0,0 +1,61 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+
+namespace rocprofsys
+{
+namespace lock_contention
+{
+// whether ROCPROFSYS_TRACE_THREAD_LOCK_CONTENTION is enabled. Only valid after
+// configure() has been invoked by the pthread_mutex_gotcha initializer
+bool
+enabled();
+
+void
+configure();
+
+// the functions below are no-ops unless ROCPROFSYS_TRACE_THREAD_LOCK_HOLDERS is
+// enabled. Uncontended acquisitions are never recorded: begin_wait() registers the
+// calling thread as a waiter (claiming a slot for the lock) and released() publishes
+// the thread and call-site of the holder when another thread is waiting
+void
+released(uintptr_t _lock);
+
+void
+begin_wait(uintptr_t _lock);
+
+// called by the waiting thread once it has acquired the lock. Aggregates the wait
+// per lock address and call-site and emits a trace slice when the wait exceeds
+// ROCPROFSYS_TRACE_THREAD_LOCK_WAIT_THRESHOLD. When holders are tracked, the wait is
+// also attributed to the holder call-site -> waiter call-site edge of the wait-for
+// graph and the trace slice is emitted with a flow event from the release by the holder
+void
+record_wait(const char* _name, uintptr_t _lock, uintptr_t _site, uint64_t _beg,
+            uint64_t _end);
+
+void
+post_process();
+}  // namespace lock_contention
+}  // namespace rocprofsys
@@ -0,0 +1,265 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/loop_counters.hpp"
+#include "api.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/timemory.hpp"
+
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/settings/settings.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace rocprofsys
+{
+namespace loop_counters
+{
+namespace
+{
+struct loop_counter
+{
+    std::string function   = {};
+    std::string loop       = {};
+    uint64_t*   entries    = nullptr;
+    uint64_t*   iterations = nullptr;
+};
+
+struct loop_count
+{
+    std::string function   = {};
+    std::string loop       = {};
+    uint64_t    entries    = 0;
+    uint64_t    iterations = 0;
+    bool        has_iters  = false;
+
+    double trip_count() const
+    {
+        return (entries > 0) ? (static_cast<double>(iterations) / entries) : 0.0;
+    }
+
+    template <typename ArchiveT>
+    void serialize(ArchiveT& ar, const unsigned)
+    {
+        namespace cereal = tim::cereal;
+        ar(cereal::make_nvp("function", function), cereal::make_nvp("loop", loop),
+           cereal::make_nvp("entries", entries));
+        if(has_iters)
+        {
+            ar(cereal::make_nvp("iterations", iterations),
+               cereal::make_nvp("trip_count", trip_count()));
+        }
+    }
+};
+
+auto&
+get_loop_counters()
+{
+    static auto* _v = new std::vector<loop_counter>{};
+    return *_v;
+}
+
+// the addresses of the entry counters which were registered, to ignore the duplicate
+// registrations (e.g. a function instrumented from several points)
+auto&
+get_registered_counters()
+{
+    static auto* _v = new std::unordered_set<const uint64_t*>{};
+    return *_v;
+}
+
+auto&
+get_loop_counters_mutex()
+{
+    static auto* _v = new std::mutex{};
+    return *_v;
+}
+
+auto&
+get_post_processed()
+{
+    static auto* _v = new bool{ false };
+    return *_v;
+}
+
+uint64_t
+load(const uint64_t* _v)
+{
+    return (_v) ? __atomic_load_n(_v, __ATOMIC_RELAXED) : 0;
+}
+}  // namespace
+
+size_t
+size()
+{
+    std::unique_lock<std::mutex> _lk{ get_loop_counters_mutex() };
+    return get_loop_counters().size();
+}
+
+void
+post_process()
+{
+    if(get_post_processed()) return;
+    get_post_processed() = true;
+
+    auto _data = std::vector<loop_count>{};
+    {
+        std::unique_lock<std::mutex> _lk{ get_loop_counters_mutex() };
+        for(const auto& itr : get_loop_counters())
+        {
+            _data.emplace_back(loop_count{ itr.function, itr.loop, load(itr.entries),
+                                           load(itr.iterations),
+                                           itr.iterations != nullptr });
+        }
+    }
+
+    if(_data.empty()) return;
+
+    // the functions with the most loop iterations (entries when the iterations are not
+    // counted) first and the loops within each function in the same order
+    auto _count = [](const loop_count& _v) {
+        return (_v.has_iters) ? _v.iterations : _v.entries;
+    };
+
+    auto _hotness = std::map<std::string, uint64_t>{};
+    for(const auto& itr : _data)
+        _hotness[itr.function] += _count(itr);
+
+    std::sort(_data.begin(), _data.end(), [&](const auto& _lhs, const auto& _rhs) {
+        auto _lhot = _hotness.at(_lhs.function);
+        auto _rhot = _hotness.at(_rhs.function);
+        if(_lhot != _rhot) return _lhot > _rhot;
+        if(_lhs.function != _rhs.function) return _lhs.function < _rhs.function;
+        if(_count(_lhs) != _count(_rhs)) return _count(_lhs) > _count(_rhs);
+        return _lhs.loop < _rhs.loop;
+    });
+
+    auto _get_setting = [](const std::string& _v) {
+        auto&& _b = config::get_setting_value<bool>(_v);
+        ROCPROFSYS_CI_THROW(!_b, "Error! No configuration setting named '%s'",
+                            _v.c_str());
+        return _b.value_or(true);
+    };
+
+    if(_get_setting("ROCPROFSYS_TEXT_OUTPUT"))
+    {
+        auto _fname = tim::settings::compose_output_filename("loop-counts", ".txt");
+        std::ofstream ofs{};
+        if(tim::filepath::open(ofs, _fname))
+        {
+            if(get_verbose() >= 0)
+                operation::file_output_message<tim::project::rocprofsys>{}(
+                    _fname, std::string{ "loop-counts" });
+
+            auto _function = std::string{};
+            for(const auto& itr : _data)
+            {
+                if(itr.function != _function)
+                {
+                    _function = itr.function;
+                    ofs << ((&itr == &_data.front()) ? "" : "\n") << _function << "\n"
+                        << std::setw(16) << "entries" << std::setw(16) << "iterations"
+                        << std::setw(12) << "trip count"
+                        << "  loop\n";
+                }
+
+                ofs << std::setw(16) << itr.entries;
+                if(itr.has_iters)
+                {
+                    ofs << std::setw(16) << itr.iterations << std::setw(12) << std::fixed
+                        << std::setprecision(1) << itr.trip_count();
+                }
+                else
+                {
+                    ofs << std::setw(16) << "-" << std::setw(12) << "-";
+                }
+                ofs << "  " << itr.loop << "\n";
+            }
+        }
+        else
+        {
+            ROCPROFSYS_THROW("Error opening loop counts output file: %s",
+                             _fname.c_str());
+        }
+    }
+
+    if(_get_setting("ROCPROFSYS_JSON_OUTPUT"))
+    {
+        std::stringstream oss{};
+        {
+            namespace cereal = tim::cereal;
+            auto ar =
+                tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+            ar->setNextName("rocprofsys");
+            ar->startNode();
+            (*ar)(cereal::make_nvp("loop_counts", _data));
+            ar->finishNode();
+        }
+        auto _fname = tim::settings::compose_output_filename("loop-counts", ".json");
+        std::ofstream ofs{};
+        if(tim::filepath::open(ofs, _fname))
+        {
+            if(get_verbose() >= 0)
+                operation::file_output_message<tim::project::rocprofsys>{}(
+                    _fname, std::string{ "loop-counts" });
+            ofs << oss.str() << "\n";
+        }
+        else
+        {
+            ROCPROFSYS_THROW("Error opening loop counts output file: %s",
+                             _fname.c_str());
+        }
+    }
+}
+}  // namespace loop_counters
+}  // namespace rocprofsys
+
+//--------------------------------------------------------------------------------------//
+
+namespace loop_counters = rocprofsys::loop_counters;
+
+extern "C" void
+rocprofsys_register_loop_counters_hidden(const char* func, const char* loop,
+                                         uint64_t* entries, uint64_t* iterations)
+{
+    if(!func || !loop || !entries || loop_counters::get_post_processed()) return;
+
+    ROCPROFSYS_BASIC_VERBOSE_F(4, "%-20s :: %s\n", func, loop);
+
+    std::unique_lock<std::mutex> _lk{ loop_counters::get_loop_counters_mutex() };
+    if(!loop_counters::get_registered_counters().emplace(entries).second) return;
+    loop_counters::get_loop_counters().emplace_back(
+        loop_counters::loop_counter{ func, loop, entries, iterations });
+}
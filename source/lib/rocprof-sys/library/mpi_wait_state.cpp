@@ -0,0 +1,898 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/mpi_wait_state.hpp"
+#include "core/categories.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/state.hpp"
+#include "library/call_site.hpp"
+#include "library/components/comm_data.hpp"
+#include "library/thread_data.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/backends/threading.hpp>
+
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/settings/settings.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace rocprofsys
+{
+namespace mpi_wait_state
+{
+namespace
+{
+#if defined(ROCPROFSYS_USE_MPI)
+enum record_kind : uint8_t
+{
+    kind_send = 0,
+    kind_recv,
+    kind_collective,
+    kind_collective_result,
+};
+
+// fixed-size so that the records can be exchanged between ranks as contiguous bytes
+struct call_record
+{
+    uint64_t enter    = 0;
+    uint64_t exit     = 0;
+    uint64_t seq      = 0;
+    uint64_t comm     = 0;   // hash of the world ranks in the communicator
+    int32_t  peer     = -1;  // world rank of the partner (of the origin when exchanged)
+    int32_t  tag      = 0;   // MPI_ANY_TAG when unknown
+    uint32_t site     = 0;
+    uint8_t  kind     = kind_send;
+    uint8_t  blocking = 0;
+    uint16_t resolved = 0;  // zero when the partner or sequence number is unknown
+};
+
+// communicators are identified across ranks by a hash of their membership. The data
+// is shared with the comm matrix and released by MPI when the communicator is freed
+using comm_info     = component::comm_data::mpi_comm_info;
+using comm_info_ptr = std::shared_ptr<const comm_info>;
+
+struct pending_call
+{
+    bool                       active   = false;
+    size_t                     nrecords = 0;
+    MPI_Status*                status   = nullptr;
+    MPI_Request*               request  = nullptr;
+    comm_info_ptr              info     = {};
+    std::array<call_record, 2> records  = {};
+};
+
+// the request handles are copied on entry since the completed requests are reset to
+// MPI_REQUEST_NULL
+struct pending_completion
+{
+    bool                   active   = false;
+    int*                   flag     = nullptr;
+    int*                   outcount = nullptr;
+    int*                   indices  = nullptr;
+    MPI_Status*            statuses = nullptr;
+    std::vector<uintptr_t> handles  = {};
+};
+
+using site_key_t = std::pair<const char*, uintptr_t>;
+
+// the records of each thread. The mutex is only contended when another thread
+// completes a wildcard receive of this thread and during post_process
+struct thread_records
+{
+    std::mutex                     mutex    = {};
+    std::vector<call_record>       records  = {};
+    std::map<site_key_t, uint32_t> site_ids = {};  // cache of the process-wide ids
+    uint64_t                       dropped  = 0;
+};
+
+using thread_records_instances = thread_data<thread_records, category::mpi>;
+
+// a non-blocking wildcard receive waiting for the status of its completion
+struct wildcard_recv
+{
+    thread_records* owner = nullptr;
+    size_t          index = 0;  // position in owner->records
+    comm_info_ptr   info  = {};
+};
+
+struct wait_totals
+{
+    uint64_t calls         = 0;
+    uint64_t time          = 0;
+    uint64_t late_sender   = 0;
+    uint64_t late_receiver = 0;
+    uint64_t imbalance     = 0;
+    uint64_t unmatched     = 0;
+
+    uint64_t wait() const { return late_sender + late_receiver + imbalance; }
+
+    wait_totals& operator+=(const wait_totals& _rhs)
+    {
+        calls += _rhs.calls;
+        time += _rhs.time;
+        late_sender += _rhs.late_sender;
+        late_receiver += _rhs.late_receiver;
+        imbalance += _rhs.imbalance;
+        unmatched += _rhs.unmatched;
+        return *this;
+    }
+};
+
+using stream_key_t = std::tuple<int, uint64_t, int>;  // world rank, comm, tag
+
+constexpr size_t max_records = (1 << 20);  // summed over all threads
+constexpr int    sync_rounds = 8;
+constexpr int    sync_tag    = 0x7a17;
+
+std::mutex                         site_mutex       = {};
+std::map<site_key_t, uint32_t>     site_ids         = {};
+std::vector<site_key_t>            sites            = {};
+std::mutex                         wildcard_mutex   = {};
+std::map<uintptr_t, wildcard_recv> wildcard_recvs   = {};
+std::mutex                         collective_mutex = {};
+std::map<uint64_t, uint64_t>       collective_seq   = {};
+std::atomic<size_t>                num_records      = { 0 };
+std::atomic<size_t>                num_wildcards    = { 0 };
+std::atomic<bool>                  warned_dropped   = { false };
+thread_local pending_call          pending          = {};
+thread_local pending_completion    completion       = {};
+
+thread_records&
+get_thread_records()
+{
+    auto _tid = threading::get_id();
+    return *thread_records_instances::instance(construct_on_thread{ _tid });
+}
+
+bool
+is_persistent(const char* _name)
+{
+    // MPI_{Send,Recv,...}_init share the signatures of the non-blocking calls but do
+    // not transfer a message until MPI_Start
+    return std::string_view{ _name }.find("_init") != std::string_view::npos;
+}
+
+// the process-wide registry is only locked the first time a thread sees a call-site
+uint32_t
+get_site_id(thread_records& _data, const char* _name, uintptr_t _site)
+{
+    auto _key = site_key_t{ _name, _site };
+    auto itr  = _data.site_ids.find(_key);
+    if(itr != _data.site_ids.end()) return itr->second;
+
+    std::unique_lock<std::mutex> _lk{ site_mutex };
+    auto                         _id = site_ids.find(_key);
+    if(_id == site_ids.end())
+    {
+        sites.emplace_back(_key);
+        _id = site_ids.emplace(_key, sites.size() - 1).first;
+    }
+    return _data.site_ids.emplace(_key, _id->second).first->second;
+}
+
+// the partner is resolved when both the world rank of the peer and the tag are known.
+// The sequence numbers are assigned in post_process
+bool
+set_partner(call_record& _rec, const comm_info& _info, int _peer, int _tag)
+{
+    _rec.peer = -1;
+    _rec.tag  = _tag;
+    if(_peer >= 0 && _peer < static_cast<int>(_info.world.size()))
+        _rec.peer = _info.world.at(_peer);
+    _rec.resolved = (_rec.peer >= 0 && _tag != MPI_ANY_TAG) ? 1 : 0;
+    return (_rec.resolved != 0);
+}
+
+bool
+has_status(const MPI_Status* _status)
+{
+    return (_status != nullptr && _status != MPI_STATUS_IGNORE &&
+            _status != MPI_STATUSES_IGNORE);
+}
+
+// the source of a cancelled receive is undefined
+bool
+set_partner(call_record& _rec, const comm_info& _info, MPI_Status* _status)
+{
+    int _cancelled = 0;
+    if(!has_status(_status) || PMPI_Test_cancelled(_status, &_cancelled) != MPI_SUCCESS ||
+       _cancelled != 0)
+        return false;
+    return set_partner(_rec, _info, _status->MPI_SOURCE, _status->MPI_TAG);
+}
+
+// the request may have been started by another thread
+void
+complete_wildcard(uintptr_t _handle, MPI_Status* _status)
+{
+    auto _entry = wildcard_recv{};
+    {
+        std::unique_lock<std::mutex> _lk{ wildcard_mutex };
+        auto                         itr = wildcard_recvs.find(_handle);
+        if(itr == wildcard_recvs.end()) return;
+
+        _entry = std::move(itr->second);
+        wildcard_recvs.erase(itr);
+        num_wildcards = wildcard_recvs.size();
+    }
+
+    auto&                        _owner = *_entry.owner;
+    std::unique_lock<std::mutex> _lk{ _owner.mutex };
+    if(_entry.index < _owner.records.size())
+        set_partner(_owner.records.at(_entry.index), *_entry.info, _status);
+}
+
+void
+begin(size_t _nrecords, comm_info_ptr _info, MPI_Status* _status,
+      MPI_Request* _request = nullptr)
+{
+    pending.active   = true;
+    pending.nrecords = _nrecords;
+    pending.info     = std::move(_info);
+    pending.status   = _status;
+    pending.request  = _request;
+
+    auto _now = tracing::now();
+    for(size_t i = 0; i < _nrecords; ++i)
+        pending.records[i].enter = _now;
+}
+
+// returns the offset of the local clock relative to the clock of rank 0 from the
+// ping-pong with the smallest round-trip time
+int64_t
+get_clock_offset(MPI_Comm _comm, int _rank, int _size)
+{
+    int64_t _offset = 0;
+    if(_rank == 0)
+    {
+        auto _offsets = std::vector<int64_t>(_size, 0);
+        for(int i = 1; i < _size; ++i)
+        {
+            auto _best = std::numeric_limits<uint64_t>::max();
+            for(int j = 0; j < sync_rounds; ++j)
+            {
+                uint64_t _remote = 0;
+                uint64_t _beg    = tracing::now();
+                PMPI_Send(&_beg, 1, MPI_UINT64_T, i, sync_tag, _comm);
+                PMPI_Recv(&_remote, 1, MPI_UINT64_T, i, sync_tag, _comm,
+                          MPI_STATUS_IGNORE);
+                uint64_t _end = tracing::now();
+                if(_end - _beg < _best)
+                {
+                    _best = _end - _beg;
+                    _offsets.at(i) = static_cast<int64_t>(_remote) -
+                                     static_cast<int64_t>(_beg + (_best / 2));
+                }
+            }
+        }
+        PMPI_Scatter(_offsets.data(), 1, MPI_INT64_T, &_offset, 1, MPI_INT64_T, 0,
+                     _comm);
+    }
+    else
+    {
+        for(int j = 0; j < sync_rounds; ++j)
+        {
+            uint64_t _beg = 0;
+            PMPI_Recv(&_beg, 1, MPI_UINT64_T, 0, sync_tag, _comm, MPI_STATUS_IGNORE);
+            uint64_t _now = tracing::now();
+            PMPI_Send(&_now, 1, MPI_UINT64_T, 0, sync_tag, _comm);
+        }
+        PMPI_Scatter(nullptr, 1, MPI_INT64_T, &_offset, 1, MPI_INT64_T, 0, _comm);
+    }
+    return _offset;
+}
+
+// the counts and displacements are in records so that they do not overflow an int
+// before the number of records does
+std::vector<call_record>
+exchange_records(MPI_Comm _comm, const std::vector<std::vector<call_record>>& _outgoing)
+{
+    MPI_Datatype _record_type = MPI_DATATYPE_NULL;
+    PMPI_Type_contiguous(sizeof(call_record), MPI_BYTE, &_record_type);
+    PMPI_Type_commit(&_record_type);
+
+    const auto _size         = _outgoing.size();
+    auto       _send_counts  = std::vector<int>(_size, 0);
+    auto       _send_displs  = std::vector<int>(_size, 0);
+    auto       _recv_counts  = std::vector<int>(_size, 0);
+    auto       _recv_displs  = std::vector<int>(_size, 0);
+    auto       _send_records = std::vector<call_record>{};
+    for(size_t i = 0; i < _size; ++i)
+    {
+        _send_displs.at(i) = _send_records.size();
+        _send_counts.at(i) = _outgoing.at(i).size();
+        _send_records.insert(_send_records.end(), _outgoing.at(i).begin(),
+                             _outgoing.at(i).end());
+    }
+
+    PMPI_Alltoall(_send_counts.data(), 1, MPI_INT, _recv_counts.data(), 1, MPI_INT,
+                  _comm);
+
+    size_t _total = 0;
+    for(size_t i = 0; i < _size; ++i)
+    {
+        _recv_displs.at(i) = _total;
+        _total += _recv_counts.at(i);
+    }
+
+    auto _recv_records = std::vector<call_record>(_total);
+    PMPI_Alltoallv(_send_records.data(), _send_counts.data(), _send_displs.data(),
+                   _record_type, _recv_records.data(), _recv_counts.data(),
+                   _recv_displs.data(), _record_type, _comm);
+    PMPI_Type_free(&_record_type);
+    return _recv_records;
+}
+
+// sequence numbers follow the order in which the sends and receives of each (peer,
+// comm, tag) stream were posted. A receive whose source or tag is never known may have
+// matched a message of any stream it accepts, which shifts the matching of every later
+// receive on those streams, so they are left unresolved from that point on
+void
+assign_sequence_numbers(std::vector<call_record>& _records)
+{
+    auto _send_seq = std::map<stream_key_t, uint64_t>{};
+    auto _recv_seq = std::map<stream_key_t, uint64_t>{};
+    auto _unknown  = std::vector<call_record>{};
+
+    auto _is_shifted = [&_unknown](const call_record& _rec) {
+        return std::any_of(_unknown.begin(), _unknown.end(), [&_rec](const auto& itr) {
+            return (itr.comm == _rec.comm && (itr.peer < 0 || itr.peer == _rec.peer) &&
+                    (itr.tag == MPI_ANY_TAG || itr.tag == _rec.tag));
+        });
+    };
+
+    for(auto& itr : _records)
+    {
+        auto _key = stream_key_t{ itr.peer, itr.comm, itr.tag };
+        if(itr.kind == kind_send)
+        {
+            if(itr.resolved != 0) itr.seq = _send_seq[_key]++;
+        }
+        else if(itr.kind == kind_recv)
+        {
+            if(itr.resolved == 0)
+                _unknown.emplace_back(itr);
+            else if(_is_shifted(itr))
+                itr.resolved = 0;
+            else
+                itr.seq = _recv_seq[_key]++;
+        }
+    }
+}
+
+uint64_t
+get_wait(uint64_t _beg, uint64_t _end)
+{
+    return (_end > _beg) ? (_end - _beg) : 0;
+}
+
+void
+write_site_summary(const std::vector<site_key_t>&  _sites,
+                   const std::vector<wait_totals>& _totals)
+{
+    auto _order = std::vector<size_t>(_totals.size());
+    for(size_t i = 0; i < _order.size(); ++i)
+        _order.at(i) = i;
+    std::sort(_order.begin(), _order.end(), [&_totals](auto _lhs, auto _rhs) {
+        return _totals.at(_lhs).wait() > _totals.at(_rhs).wait();
+    });
+
+    auto _fname = tim::settings::compose_output_filename("mpi-wait-states", ".txt");
+    auto _ofs   = std::ofstream{};
+    if(!tim::filepath::open(_ofs, _fname))
+    {
+        ROCPROFSYS_VERBOSE(0, "Error opening MPI wait-state output file: %s\n",
+                           _fname.c_str());
+        return;
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<tim::project::rocprofsys>{}(
+            _fname, std::string{ "MPI wait states" });
+
+    auto _msec = [](uint64_t _v) { return static_cast<double>(_v) / 1.0e6; };
+
+    _ofs << std::left << std::setw(20) << "# function" << std::right << std::setw(10)
+         << "calls" << std::setw(14) << "time (msec)" << std::setw(18)
+         << "late-sender" << std::setw(18) << "late-receiver" << std::setw(18)
+         << "imbalance" << std::setw(12) << "unmatched" << "  call-site\n";
+    _ofs << std::fixed << std::setprecision(3);
+    for(auto i : _order)
+    {
+        const auto& _total = _totals.at(i);
+        if(_total.calls == 0) continue;
+        _ofs << std::left << std::setw(20) << _sites.at(i).first << std::right
+             << std::setw(10) << _total.calls << std::setw(14) << _msec(_total.time)
+             << std::setw(18) << _msec(_total.late_sender) << std::setw(18)
+             << _msec(_total.late_receiver) << std::setw(18) << _msec(_total.imbalance)
+             << std::setw(12) << _total.unmatched << "  "
+             << call_site::get_name(_sites.at(i).second) << "\n";
+    }
+}
+
+void
+write_rank_summary(const std::vector<uint64_t>& _data, size_t _nfields)
+{
+    auto _fname = tim::settings::compose_output_filename("mpi-imbalance", ".txt");
+    auto _ofs   = std::ofstream{};
+    if(!tim::filepath::open(_ofs, _fname))
+    {
+        ROCPROFSYS_VERBOSE(0, "Error opening MPI imbalance output file: %s\n",
+                           _fname.c_str());
+        return;
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<tim::project::rocprofsys>{}(
+            _fname, std::string{ "MPI imbalance summary" });
+
+    auto _msec = [](uint64_t _v) { return static_cast<double>(_v) / 1.0e6; };
+
+    _ofs << "# times are in msec. wait = late-sender + late-receiver + imbalance\n";
+    _ofs << std::left << std::setw(8) << "# rank" << std::right << std::setw(14)
+         << "mpi time" << std::setw(14) << "late-sender" << std::setw(14)
+         << "late-receiver" << std::setw(14) << "imbalance" << std::setw(10) << "wait %"
+         << std::setw(12) << "unmatched" << std::setw(10) << "dropped" << "\n";
+    _ofs << std::fixed << std::setprecision(3);
+    for(size_t i = 0; i < _data.size() / _nfields; ++i)
+    {
+        const auto* _v    = _data.data() + (i * _nfields);
+        auto        _wait = _v[1] + _v[2] + _v[3];
+        _ofs << std::left << std::setw(8) << i << std::right << std::setw(14)
+             << _msec(_v[0]) << std::setw(14) << _msec(_v[1]) << std::setw(14)
+             << _msec(_v[2]) << std::setw(14) << _msec(_v[3]) << std::setw(10)
+             << ((_v[0] > 0) ? (100.0 * _wait / _v[0]) : 0.0) << std::setw(12) << _v[4]
+             << std::setw(10) << _v[5] << "\n";
+    }
+}
+#endif
+}  // namespace
+
+bool
+enabled()
+{
+    static bool _v = []() {
+        auto _enabled = get_use_mpip() && config::get_mpip_wait_state();
+        if(_enabled) call_site::configure();
+        return _enabled;
+    }();
+    return _v;
+}
+
+#if defined(ROCPROFSYS_USE_MPI)
+void
+enter_send(const char* _name, bool _blocking, MPI_Comm _comm, int _dst, int _tag)
+{
+    if(!enabled() || pending.active || _dst == MPI_PROC_NULL || is_persistent(_name))
+        return;
+
+    auto _site = call_site::get();
+
+    auto _info = component::comm_data::get_mpi_comm_info(_comm);
+    if(!_info || !_info->valid) return;
+
+    auto& _rec    = pending.records[0];
+    _rec          = call_record{};
+    _rec.kind     = kind_send;
+    _rec.blocking = (_blocking) ? 1 : 0;
+    _rec.comm     = _info->hash;
+    _rec.site     = get_site_id(get_thread_records(), _name, _site);
+    set_partner(_rec, *_info, _dst, _tag);
+
+    begin(1, std::move(_info), nullptr);
+}
+
+void
+enter_recv(const char* _name, bool _blocking, MPI_Comm _comm, int _src, int _tag,
+           MPI_Status* _status, MPI_Request* _request)
+{
+    if(!enabled() || pending.active || _src == MPI_PROC_NULL || is_persistent(_name))
+        return;
+
+    auto _site = call_site::get();
+
+    auto _info = component::comm_data::get_mpi_comm_info(_comm);
+    if(!_info || !_info->valid) return;
+
+    auto& _rec    = pending.records[0];
+    _rec          = call_record{};
+    _rec.kind     = kind_recv;
+    _rec.blocking = (_blocking) ? 1 : 0;
+    _rec.comm     = _info->hash;
+    _rec.site     = get_site_id(get_thread_records(), _name, _site);
+    // wildcards are resolved from the status when the call or the request completes
+    auto _resolved = set_partner(_rec, *_info, _src, _tag);
+
+    begin(1, std::move(_info), _status, (_resolved || _blocking) ? nullptr : _request);
+}
+
+void
+enter_sendrecv(const char* _name, MPI_Comm _comm, int _dst, int _send_tag, int _src,
+               int _recv_tag, MPI_Status* _status)
+{
+    if(!enabled() || pending.active) return;
+
+    auto _site = call_site::get();
+
+    auto _info = component::comm_data::get_mpi_comm_info(_comm);
+    if(!_info || !_info->valid) return;
+
+    // the wait of the call is classified from the receive half only
+    auto _site_id = get_site_id(get_thread_records(), _name, _site);
+    auto _nrecs   = size_t{ 0 };
+    if(_dst != MPI_PROC_NULL)
+    {
+        auto& _rec = pending.records[_nrecs++];
+        _rec       = call_record{};
+        _rec.kind  = kind_send;
+        _rec.comm  = _info->hash;
+        _rec.site  = _site_id;
+        set_partner(_rec, *_info, _dst, _send_tag);
+    }
+    if(_src != MPI_PROC_NULL)
+    {
+        auto& _rec    = pending.records[_nrecs++];
+        _rec          = call_record{};
+        _rec.kind     = kind_recv;
+        _rec.blocking = 1;
+        _rec.comm     = _info->hash;
+        _rec.site     = _site_id;
+        set_partner(_rec, *_info, _src, _recv_tag);
+    }
+
+    if(_nrecs > 0) begin(_nrecs, std::move(_info), _status);
+}
+
+void
+enter_collective(const char* _name, MPI_Comm _comm)
+{
+    if(!enabled() || pending.active) return;
+
+    auto _site = call_site::get();
+
+    auto _info = component::comm_data::get_mpi_comm_info(_comm);
+    if(!_info || !_info->valid) return;
+
+    // the records of a collective are sent to the lowest world rank of the comm and
+    // are sequenced per membership since duplicated communicators share the hash
+    auto& _rec    = pending.records[0];
+    _rec          = call_record{};
+    _rec.kind     = kind_collective;
+    _rec.blocking = 1;
+    _rec.comm     = _info->hash;
+    _rec.peer     = _info->leader;
+    _rec.site     = get_site_id(get_thread_records(), _name, _site);
+    _rec.resolved = 1;
+    {
+        std::unique_lock<std::mutex> _lk{ collective_mutex };
+        _rec.seq = collective_seq[_info->hash]++;
+    }
+
+    begin(1, std::move(_info), nullptr);
+}
+
+void
+enter_completion(int _count, MPI_Request* _requests, int* _flag, int* _outcount,
+                 int* _indices, MPI_Status* _statuses)
+{
+    if(!enabled() || num_wildcards.load(std::memory_order_relaxed) == 0 ||
+       _requests == nullptr || _count <= 0)
+        return;
+
+    completion.active   = true;
+    completion.flag     = _flag;
+    completion.outcount = _outcount;
+    completion.indices  = _indices;
+    completion.statuses = _statuses;
+    completion.handles.resize(_count);
+    for(int i = 0; i < _count; ++i)
+        completion.handles.at(i) = (uintptr_t) _requests[i];  // NOLINT
+}
+#endif
+
+void
+exit()
+{
+#if defined(ROCPROFSYS_USE_MPI)
+    if(completion.active)
+    {
+        completion.active = false;
+        if(completion.flag != nullptr && *completion.flag == 0) return;
+
+        // a wildcard receive without a status is left unresolved
+        auto  _ignore   = !has_status(completion.statuses);
+        auto& _handles  = completion.handles;
+        auto  _status_i = [_ignore](size_t _idx) {
+            return (_ignore) ? nullptr : completion.statuses + _idx;
+        };
+
+        if(completion.indices != nullptr)
+        {
+            // MPI_UNDEFINED is negative when no request completed
+            auto _n = (completion.outcount != nullptr) ? *completion.outcount : 1;
+            for(int i = 0; i < _n; ++i)
+            {
+                auto _idx = completion.indices[i];
+                if(_idx >= 0 && static_cast<size_t>(_idx) < _handles.size())
+                    complete_wildcard(_handles.at(_idx), _status_i(i));
+            }
+        }
+        else
+        {
+            for(size_t i = 0; i < _handles.size(); ++i)
+                complete_wildcard(_handles.at(i), _status_i(i));
+        }
+        return;
+    }
+
+    if(!pending.active) return;
+
+    auto _now      = tracing::now();
+    pending.active = false;
+
+    auto&                        _data     = get_thread_records();
+    auto                         _wildcard = std::optional<size_t>{};
+    std::unique_lock<std::mutex> _lk{ _data.mutex };
+    for(size_t i = 0; i < pending.nrecords; ++i)
+    {
+        auto& _rec = pending.records[i];
+        _rec.exit  = _now;
+        if(_rec.kind == kind_recv && _rec.resolved == 0 && _rec.blocking != 0)
+            set_partner(_rec, *pending.info, pending.status);
+
+        if(num_records.fetch_add(1, std::memory_order_relaxed) < max_records)
+        {
+            // the source and tag of a non-blocking wildcard receive are resolved by the
+            // call which completes the request
+            if(pending.request != nullptr && _rec.kind == kind_recv)
+                _wildcard = _data.records.size();
+            _data.records.emplace_back(_rec);
+        }
+        else
+        {
+            ++_data.dropped;
+        }
+    }
+    _lk.unlock();
+
+    // the request cannot be completed before it is returned to the caller
+    if(_wildcard)
+    {
+        auto                         _handle = (uintptr_t)(*pending.request);  // NOLINT
+        std::unique_lock<std::mutex> _wlk{ wildcard_mutex };
+        wildcard_recvs[_handle] = wildcard_recv{ &_data, *_wildcard, pending.info };
+        num_wildcards           = wildcard_recvs.size();
+    }
+
+    if(_data.dropped > 0 && !warned_dropped.exchange(true))
+    {
+        ROCPROFSYS_WARNING_F(0,
+                             "the limit of %zu MPI calls recorded for the wait-state "
+                             "analysis was reached, later calls are not analyzed and are "
+                             "reported in the 'dropped' column\n",
+                             max_records);
+    }
+
+    // the communicator may be freed before the next call of this thread
+    pending.info.reset();
+#endif
+}
+
+void
+post_process()
+{
+#if defined(ROCPROFSYS_USE_MPI)
+    if(!enabled()) return;
+
+    int _initialized = 0;
+    int _finalized   = 0;
+    PMPI_Initialized(&_initialized);
+    PMPI_Finalized(&_finalized);
+    if(_initialized == 0 || _finalized != 0)
+    {
+        ROCPROFSYS_VERBOSE(1, "MPI is not active, the MPI wait states are not "
+                              "analyzed\n");
+        return;
+    }
+
+    MPI_Comm _comm = MPI_COMM_NULL;
+    PMPI_Comm_dup(MPI_COMM_WORLD, &_comm);
+
+    int _rank = 0;
+    int _size = 1;
+    PMPI_Comm_rank(_comm, &_rank);
+    PMPI_Comm_size(_comm, &_size);
+
+    auto _offset  = get_clock_offset(_comm, _rank, _size);
+    auto _local   = std::vector<call_record>{};
+    auto _sites   = std::vector<site_key_t>{};
+    auto _dropped = uint64_t{ 0 };
+    if(thread_records_instances::get())
+    {
+        for(const auto& itr : *thread_records_instances::get())
+        {
+            if(!itr) continue;
+            std::unique_lock<std::mutex> _lk{ itr->mutex };
+            _local.insert(_local.end(), itr->records.begin(), itr->records.end());
+            _dropped += itr->dropped;
+        }
+    }
+    {
+        std::unique_lock<std::mutex> _lk{ site_mutex };
+        _sites = sites;
+    }
+
+    // messages between a pair of ranks are matched in the order they were posted
+    std::stable_sort(_local.begin(), _local.end(),
+                     [](const auto& _lhs, const auto& _rhs) {
+                         return _lhs.enter < _rhs.enter;
+                     });
+
+    assign_sequence_numbers(_local);
+
+    // convert to the time-base of rank 0
+    for(auto& itr : _local)
+    {
+        itr.enter = static_cast<uint64_t>(static_cast<int64_t>(itr.enter) - _offset);
+        itr.exit  = static_cast<uint64_t>(static_cast<int64_t>(itr.exit) - _offset);
+    }
+
+    // sends and receives go to the partner, collectives go to the leader of the comm
+    auto _outgoing = std::vector<std::vector<call_record>>(_size);
+    for(const auto& itr : _local)
+    {
+        if(itr.resolved == 0 || itr.peer < 0 || itr.peer >= _size) continue;
+        auto _rec = itr;
+        _rec.peer = _rank;
+        _outgoing.at(itr.peer).emplace_back(_rec);
+    }
+
+    using match_key_t      = std::tuple<uint8_t, int, uint64_t, int, uint64_t>;
+    using collective_key_t = std::pair<uint64_t, uint64_t>;
+
+    auto _remote  = std::map<match_key_t, uint64_t>{};
+    auto _arrival = std::map<collective_key_t, std::pair<uint64_t, std::vector<int>>>{};
+    for(const auto& itr : exchange_records(_comm, _outgoing))
+    {
+        if(itr.kind == kind_collective)
+        {
+            auto& _entry = _arrival[collective_key_t{ itr.comm, itr.seq }];
+            _entry.first = std::max(_entry.first, itr.enter);
+            _entry.second.emplace_back(itr.peer);
+        }
+        else
+        {
+            _remote.emplace(match_key_t{ itr.kind, itr.peer, itr.comm, itr.tag, itr.seq },
+                            itr.enter);
+        }
+    }
+
+    // the leaders return the entry of the last rank to arrive to every participant
+    auto _results = std::vector<std::vector<call_record>>(_size);
+    for(const auto& itr : _arrival)
+    {
+        auto _rec  = call_record{};
+        _rec.kind  = kind_collective_result;
+        _rec.comm  = itr.first.first;
+        _rec.seq   = itr.first.second;
+        _rec.enter = itr.second.first;
+        for(auto ritr : itr.second.second)
+            _results.at(ritr).emplace_back(_rec);
+    }
+
+    auto _last_arrival = std::map<collective_key_t, uint64_t>{};
+    for(const auto& itr : exchange_records(_comm, _results))
+        _last_arrival[collective_key_t{ itr.comm, itr.seq }] = itr.enter;
+
+    // late-sender: a blocking receive entered before the matching send.
+    // late-receiver: a blocking send entered before the matching receive.
+    // imbalance: a collective entered before the last rank of the communicator.
+    // Non-blocking calls only contribute to the call count and time
+    auto _totals = std::vector<wait_totals>(_sites.size());
+    for(const auto& itr : _local)
+    {
+        auto& _total = _totals.at(itr.site);
+        _total.calls += 1;
+        _total.time += get_wait(itr.enter, itr.exit);
+        if(itr.blocking == 0) continue;
+
+        if(itr.resolved == 0)
+        {
+            ++_total.unmatched;
+        }
+        else if(itr.kind == kind_recv)
+        {
+            auto _match = _remote.find(
+                match_key_t{ kind_send, itr.peer, itr.comm, itr.tag, itr.seq });
+            if(_match == _remote.end() || _match->second > itr.exit)
+                ++_total.unmatched;
+            else
+                _total.late_sender += get_wait(itr.enter, _match->second);
+        }
+        else if(itr.kind == kind_send)
+        {
+            auto _match = _remote.find(
+                match_key_t{ kind_recv, itr.peer, itr.comm, itr.tag, itr.seq });
+            if(_match == _remote.end())
+                ++_total.unmatched;
+            else
+                _total.late_receiver +=
+                    get_wait(itr.enter, std::min(_match->second, itr.exit));
+        }
+        else if(itr.kind == kind_collective)
+        {
+            auto _match = _last_arrival.find(collective_key_t{ itr.comm, itr.seq });
+            if(_match == _last_arrival.end())
+                ++_total.unmatched;
+            else
+                _total.imbalance +=
+                    get_wait(itr.enter, std::min(_match->second, itr.exit));
+        }
+    }
+
+    write_site_summary(_sites, _totals);
+
+    auto _rank_total = wait_totals{};
+    for(const auto& itr : _totals)
+        _rank_total += itr;
+
+    ROCPROFSYS_VERBOSE(1,
+                       "[mpi-wait-state] %lu calls, %.3f msec in MPI: late-sender %.3f "
+                       "msec, late-receiver %.3f msec, imbalance %.3f msec\n",
+                       static_cast<unsigned long>(_rank_total.calls),
+                       _rank_total.time / 1.0e6, _rank_total.late_sender / 1.0e6,
+                       _rank_total.late_receiver / 1.0e6, _rank_total.imbalance / 1.0e6);
+
+    constexpr size_t num_fields = 6;
+    auto             _summary   = std::array<uint64_t, num_fields>{
+        _rank_total.time,      _rank_total.late_sender, _rank_total.late_receiver,
+        _rank_total.imbalance, _rank_total.unmatched,   _dropped
+    };
+    auto _summaries = std::vector<uint64_t>((_rank == 0) ? (_size * num_fields) : 0);
+    PMPI_Gather(_summary.data(), num_fields, MPI_UINT64_T, _summaries.data(), num_fields,
+                MPI_UINT64_T, 0, _comm);
+
+    if(_rank == 0) write_rank_summary(_summaries, num_fields);
+
+    PMPI_Comm_free(&_comm);
+#endif
+}
+}  // namespace mpi_wait_state
+}  // namespace rocprofsys
@@ -0,0 +1,81 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "core/defines.hpp"
+
+#if defined(ROCPROFSYS_USE_MPI)
+#    include <mpi.h>
+#endif
+
+#include <cstdint>
+
+namespace rocprofsys
+{
+namespace mpi_wait_state
+{
+// whether ROCPROFSYS_MPIP_WAIT_STATE is enabled
+bool
+enabled();
+
+#if defined(ROCPROFSYS_USE_MPI)
+// invoked by the comm_data wrappers on entry of a point-to-point or collective call.
+// The record is completed by exit() when the wrapped function returns. The status is
+// used to resolve the source and tag of a blocking receive from MPI_ANY_SOURCE or
+// with MPI_ANY_TAG. The request of a non-blocking wildcard receive is resolved by the
+// call which completes it
+void
+enter_send(const char* _name, bool _blocking, MPI_Comm _comm, int _dst, int _tag);
+
+void
+enter_recv(const char* _name, bool _blocking, MPI_Comm _comm, int _src, int _tag,
+           MPI_Status* _status, MPI_Request* _request);
+
+void
+enter_sendrecv(const char* _name, MPI_Comm _comm, int _dst, int _send_tag, int _src,
+               int _recv_tag, MPI_Status* _status);
+
+void
+enter_collective(const char* _name, MPI_Comm _comm);
+
+// invoked on entry of the MPI_Wait* and MPI_Test* calls. The wildcard receives which
+// the call completes are resolved from the statuses when it returns. _flag is the
+// completion flag of the test calls. _indices are the completed requests of the
+// any/some calls, _outcount their number for the some calls (one for the any calls).
+// Both are null when every request is completed
+void
+enter_completion(int _count, MPI_Request* _requests, int* _flag, int* _outcount,
+                 int* _indices, MPI_Status* _statuses);
+#endif
+
+void
+exit();
+
+// synchronizes the clocks of the ranks, exchanges the entry timestamps of the matching
+// sends, receives and collectives and writes the wait-state classification per call
+// site and the per-rank imbalance summary. Must be called by every rank before MPI
+// is finalized
+void
+post_process();
+}  // namespace mpi_wait_state
+}  // namespace rocprofsys
@@ -48,6 +48,7 @@
 #include <sys/mman.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <utility>
 
 #if !defined(ROCPROFSYS_RETURN_ERROR_MSG)
 #    define ROCPROFSYS_RETURN_ERROR_MSG(COND, ...)                                       \
@@ -662,5 +663,12 @@ get_instance(int64_t _tid)
     }
     return _data->at(_tid);
 }
+
+const std::unique_ptr<perf_event>&
+find_instance(int64_t _tid)
+{
+    const auto& _data = get_instances();
+    return std::as_const(*_data).at(_tid);
+}
 }  // namespace perf
 }  // namespace rocprofsys
@@ -208,5 +208,10 @@ private:
 /// provides thread-local instance of perf_event
 std::unique_ptr<perf_event>&
 get_instance(int64_t _tid);
+
+/// instance of the thread without allocating storage for it. Empty when the thread
+/// never created one
+const std::unique_ptr<perf_event>&
+find_instance(int64_t _tid);
 }  // namespace perf
 }  // namespace rocprofsys
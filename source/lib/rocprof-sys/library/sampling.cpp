@@ -21,6 +21,8 @@
 // SOFTWARE.
 
 #include "library/sampling.hpp"
+#include "library/sampling_controller.hpp"
+#include "library/sampling_profile.hpp"
 #include "core/common.hpp"
 #include "core/components/fwd.hpp"
 #include "core/config.hpp"
@@ -69,13 +71,19 @@
 #include <timemory/utility/types.hpp>
 #include <timemory/variadic.hpp>
 
+#include <algorithm>
 #include <array>
+#include <cctype>
 #include <chrono>
+#include <cmath>
 #include <condition_variable>
 #include <csignal>
 #include <cstring>
 #include <ctime>
 #include <initializer_list>
+#include <limits>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <regex>
 #include <sstream>
@@ -129,6 +137,7 @@ using component::sampling_gpu_busy;
 using component::sampling_gpu_memory;
 using component::sampling_gpu_power;
 using component::sampling_gpu_temp;
+using component::sampling_offcpu_clock;
 using component::sampling_percent;
 using component::sampling_wall_clock;
 }  // namespace sampling
@@ -255,6 +264,14 @@ get_sampler(int64_t _tid = threading::get_id())
     return _v->at(_tid);
 }
 
+// does not allocate the storage of threads which never created a sampler
+const unique_ptr_t<sampler_t>&
+find_sampler(int64_t _tid)
+{
+    static const auto* _v = sampler_instances::get();
+    return _v->at(_tid);
+}
+
 unique_ptr_t<bundle_t>&
 get_sampler_init(int64_t _tid = threading::get_id())
 {
@@ -569,6 +586,8 @@ configure(bool _setup, int64_t _tid)
         if(trait::runtime_enabled<backtrace_metrics>::get())
             backtrace_metrics::configure(_setup, _tid);
 
+        backtrace::configure(_setup, _tid);
+
         // NOTE: signals need to be unblocked by calling function
         sampling::block_signals(*_signal_types);
 
@@ -717,6 +736,13 @@ configure(bool _setup, int64_t _tid)
         sampling::get_sampler_init(_tid)->sample();
         start_duration_thread();
         _sampler->start();
+
+        if(controller::enabled())
+        {
+            auto _timer_signals = *_signal_types;
+            _timer_signals.erase(get_sampling_overflow_signal());
+            controller::configure(_setup, _tid, _timer_signals);
+        }
     }
     else if(!_setup && _sampler && _is_running)
     {
@@ -730,6 +756,8 @@ configure(bool _setup, int64_t _tid)
 
         notify_duration_thread();
 
+        if(_tid == threading::get_id()) controller::configure(_setup, _tid, {});
+
         if(_tid == 0)
         {
             // this propagates to all threads
@@ -746,15 +774,15 @@ configure(bool _setup, int64_t _tid)
         {
             for(int64_t i = 1; i < ROCPROFSYS_MAX_THREADS; ++i)
             {
-                if(sampling::get_sampler(i)) sampling::get_sampler(i)->stop();
-                if(perf::get_instance(i)) perf::get_instance(i)->stop();
+                if(sampling::find_sampler(i)) sampling::find_sampler(i)->stop();
+                if(perf::find_instance(i)) perf::find_instance(i)->stop();
             }
 
             for(int64_t i = 1; i < ROCPROFSYS_MAX_THREADS; ++i)
             {
-                if(sampling::get_sampler(i))
+                if(sampling::find_sampler(i))
                 {
-                    sampling::get_sampler(i)->reset();
+                    sampling::find_sampler(i)->reset();
                     *get_sampler_running(i) = false;
                 }
             }
@@ -769,6 +797,8 @@ configure(bool _setup, int64_t _tid)
         if(trait::runtime_enabled<backtrace_metrics>::get())
             backtrace_metrics::configure(_setup, _tid);
 
+        if(_tid == threading::get_id()) backtrace::configure(_setup, _tid);
+
         ROCPROFSYS_DEBUG("Sampler destroyed for thread %lu\n", _tid);
     }
 
@@ -777,9 +807,13 @@ configure(bool _setup, int64_t _tid)
 
 struct timer_sampling_data
 {
+    int                                       m_signal  = -1;
     int64_t                                   m_tid     = -1;
     uint64_t                                  m_beg     = 0;
     uint64_t                                  m_end     = 0;
+    int64_t                                   m_cpu     = -1;  // thread cpu time (nsec)
+    int64_t                                   m_offcpu  = 0;   // wall - cpu (nsec)
+    float                                     m_weight  = 1.0f;
     std::vector<tim::unwind::processed_entry> m_stack   = {};
     backtrace_metrics                         m_metrics = {};
 };
@@ -806,6 +840,60 @@ void
 post_process_timemory(int64_t, const std::vector<timer_sampling_data>&,
                       const std::vector<overflow_sampling_data>&);
 
+// one profile per timer (keyed by its signal) so that the pprof period is the interval
+// of the sampler which produced the samples. The "time" value is the interval of the
+// sampler scaled by the weight of the sample. Each configured hardware counter adds a
+// value with the change of the counter since the previous sample on the thread
+struct sampling_profiles
+{
+    std::map<int, stack_profile> timer = {};
+
+    stack_profile overflow = stack_profile{ { { "samples", "count" },
+                                              { "wall", "nanoseconds" } } };
+    stack_profile offcpu   = stack_profile{ { { "offcpu", "nanoseconds" },
+                                            { "samples", "count" } } };
+    uint64_t      beg      = std::numeric_limits<uint64_t>::max();
+    uint64_t      end      = 0;
+
+    stack_profile& get_timer(int _signal, const std::vector<std::string>& _hw_labels)
+    {
+        auto itr = timer.find(_signal);
+        if(itr != timer.end()) return itr->second;
+
+        auto _types = std::vector<stack_profile::value_type>{ { "samples", "count" },
+                                                              { "time", "nanoseconds" },
+                                                              { "wall", "nanoseconds" },
+                                                              { "cpu", "nanoseconds" } };
+        for(const auto& litr : _hw_labels)
+            _types.emplace_back(stack_profile::value_type{ litr, "count" });
+        return timer.emplace(_signal, stack_profile{ std::move(_types) }).first->second;
+    }
+};
+
+// interval (in nanoseconds) of the timer which delivers the signal
+int64_t
+get_timer_period(int _signal)
+{
+    auto _freq = (_signal == get_sampling_realtime_signal())
+                     ? get_sampling_realtime_freq()
+                     : get_sampling_cputime_freq();
+    return static_cast<int64_t>(1.0e9 / std::max(_freq, 1.0e-3));
+}
+
+const char*
+get_timer_clock(int _signal)
+{
+    return (_signal == get_sampling_realtime_signal()) ? "realtime" : "cputime";
+}
+
+void
+post_process_profiles(int64_t, sampling_profiles&,
+                      const std::vector<timer_sampling_data>&,
+                      const std::vector<overflow_sampling_data>&);
+
+void
+write_profiles(const sampling_profiles&);
+
 auto static_strings = std::set<std::string>{};
 
 }  // namespace
@@ -903,9 +991,14 @@ post_process()
     for(auto& itr : get_sampler_allocators())
         if(itr) itr->flush();
 
+    auto _profiles = (get_sampling_folded_output() || get_sampling_pprof_output() ||
+                      get_sampling_offcpu())
+                         ? std::make_unique<sampling_profiles>()
+                         : std::unique_ptr<sampling_profiles>{};
+
     for(size_t i = 0; i < thread_info::get_peak_num_threads(); ++i)
     {
-        auto& _sampler = get_sampler(i);
+        const auto& _sampler = find_sampler(i);
 
         if(!_sampler)
         {
@@ -984,6 +1077,8 @@ post_process()
 
             if(get_use_perfetto()) post_process_perfetto(i, _timer_data, _overflow_data);
             if(get_use_timemory()) post_process_timemory(i, _timer_data, _overflow_data);
+            if(_profiles)
+                post_process_profiles(i, *_profiles, _timer_data, _overflow_data);
         }
         else
         {
@@ -995,13 +1090,17 @@ post_process()
         }
     }
 
+    if(_profiles) write_profiles(*_profiles);
+
     ROCPROFSYS_VERBOSE(3 || get_debug_sampling(),
                        "Destroying samplers and allocators...\n");
 
     get_offload_file().reset();  // remove the temporary file
 
     for(size_t i = 0; i < thread_info::get_peak_num_threads(); ++i)
-        get_sampler(i).reset();
+    {
+        if(find_sampler(i)) get_sampler(i).reset();
+    }
 
     for(auto& itr : get_sampler_allocators())
     {
@@ -1040,11 +1139,32 @@ post_process_timer_data(int64_t _tid, const bundle_t* _init,
         if(!_bt_data || !_bt_time || _bt_data->empty() || _bt_time->get_tid() != _tid)
             continue;
 
-        auto _ret    = timer_sampling_data{};
-        _ret.m_tid   = _bt_time->get_tid();
-        _ret.m_beg   = _last->get<backtrace_timestamp>()->get_timestamp();
-        _ret.m_end   = _bt_time->get_timestamp();
-        _ret.m_stack = backtrace::filter_and_patch(_bt_data->get());
+        auto _ret     = timer_sampling_data{};
+        _ret.m_signal = _bt_time->get_signal();
+        _ret.m_tid    = _bt_time->get_tid();
+        _ret.m_beg    = _last->get<backtrace_timestamp>()->get_timestamp();
+        _ret.m_end    = _bt_time->get_timestamp();
+        _ret.m_weight = _bt_time->get_weight();
+        _ret.m_stack  = backtrace::filter_and_patch(_bt_data->get());
+
+        // the thread cpu time is recorded in every sample regardless of whether the
+        // HW counters (and thus the full metrics difference below) are available
+        if(_bt_metrics && _last_metrics && (*_bt_metrics)(category::thread_cpu_time{}) &&
+           (*_last_metrics)(category::thread_cpu_time{}))
+        {
+            _ret.m_cpu = std::max<int64_t>(
+                _bt_metrics->get_cpu_timestamp() - _last_metrics->get_cpu_timestamp(), 0);
+
+            // when the real-time timer fires, the difference between the elapsed wall
+            // time and the elapsed cpu time is the time the thread was not running.
+            // The cpu-time timer cannot fire while the thread is blocked so only the
+            // real-time samples are candidates for the blocked call-stack
+            if(_ret.m_signal == get_sampling_realtime_signal())
+            {
+                auto _wall    = static_cast<int64_t>(_ret.m_end - _ret.m_beg);
+                _ret.m_offcpu = std::max<int64_t>(_wall - _ret.m_cpu, 0);
+            }
+        }
         if constexpr(tim::trait::is_available<hw_counters>::value)
         {
             auto _hw_counters_enabled = [](const auto* _bt_v) {
@@ -1277,6 +1397,9 @@ post_process_perfetto(int64_t _tid, const std::vector<timer_sampling_data>& _tim
                     {
                         tracing::add_perfetto_annotation(ctx, "begin_ns", _beg);
                         tracing::add_perfetto_annotation(ctx, "end_ns", _end);
+                        if(controller::enabled())
+                            tracing::add_perfetto_annotation(ctx, "weight",
+                                                             itr.m_weight);
                     }
 
                     if(_include_hw)
@@ -1481,6 +1604,45 @@ post_process_timemory(int64_t _tid, const std::vector<timer_sampling_data>& _tim
         }
     }
 
+    // separate call-graph of the time spent blocked in each call-stack
+    if(get_sampling_offcpu())
+    {
+        for(const auto& itr : _timer_data)
+        {
+            if(itr.m_offcpu <= 0) continue;
+
+            using bundle_t = tim::lightweight_tuple<sampling_offcpu_clock>;
+
+            auto _data = std::vector<bundle_t>{};
+            _data.reserve(itr.m_stack.size());
+
+            for(const auto& iitr : itr.m_stack)
+            {
+                _data.emplace_back(tim::string_view_t{ iitr.name });
+                _data.back().push(itr.m_tid);
+                _data.back().start();
+            }
+
+            for(size_t i = 0; i < _data.size(); ++i)
+            {
+                auto& iitr = _data.at(_data.size() - i - 1);
+                iitr.stop();
+                if constexpr(tim::trait::is_available<sampling_offcpu_clock>::value)
+                {
+                    auto* _oc = iitr.get<sampling_offcpu_clock>();
+                    if(_oc)
+                    {
+                        auto _value = static_cast<double>(itr.m_offcpu) /
+                                      sampling_offcpu_clock::get_unit();
+                        _oc->set_value(_value);
+                        _oc->set_accum(_value);
+                    }
+                }
+                iitr.pop();
+            }
+        }
+    }
+
     for(auto&& itr : _overflow_data)
     {
         using bundle_t =
@@ -1536,6 +1698,133 @@ post_process_timemory(int64_t _tid, const std::vector<timer_sampling_data>& _tim
     }
 }
 
+void
+post_process_profiles(int64_t _tid, sampling_profiles& _profiles,
+                      const std::vector<timer_sampling_data>&    _timer_data,
+                      const std::vector<overflow_sampling_data>& _overflow_data)
+{
+    ROCPROFSYS_VERBOSE(3 || get_debug_sampling(),
+                       "[%li] Post-processing data for folded/pprof output...\n", _tid);
+
+    const auto& _thread_info = thread_info::get(_tid, SequentTID);
+    if(!_thread_info) return;
+
+    auto _get_frames = [](const std::vector<tim::unwind::processed_entry>& _stack) {
+        auto _frames = std::vector<stack_profile::frame>{};
+        _frames.reserve(_stack.size());
+        for(const auto& itr : _stack)
+            _frames.emplace_back(
+                stack_profile::frame{ demangle(itr.name), itr.location });
+        return _frames;
+    };
+
+    // the hardware counters are the same on every thread so the labels of the first
+    // thread which creates the profile of a timer apply to all the threads
+    auto _hw_labels = backtrace_metrics::get_hw_counter_labels(_tid);
+
+    for(const auto& itr : _timer_data)
+    {
+        if(!_thread_info->is_valid_lifetime({ itr.m_beg, itr.m_end })) continue;
+
+        // the weight is > 1 when the adaptive controller lengthened the interval, i.e.
+        // the sample stands for the time of that many intervals of its sampler
+        auto    _period = static_cast<double>(get_timer_period(itr.m_signal));
+        int64_t _time   = std::llround(itr.m_weight * _period);
+        int64_t _wall   = itr.m_end - itr.m_beg;
+        int64_t _cpu    = std::max<int64_t>(itr.m_cpu, 0);
+        auto    _frames = _get_frames(itr.m_stack);
+
+        if(get_sampling_offcpu() && itr.m_offcpu > 0)
+            _profiles.offcpu.add(_frames, { itr.m_offcpu, 1 });
+
+        auto _values = stack_profile::values_t{ 1, _time, _wall, _cpu };
+        if constexpr(tim::trait::is_available<hw_counters>::value)
+        {
+            if(itr.m_metrics(type_list<backtrace_metrics::hw_counters>{}))
+            {
+                const auto& _hw_values = itr.m_metrics.get_hw_counters();
+                auto        _n = std::min<size_t>(_hw_labels.size(), _hw_values.size());
+                for(size_t i = 0; i < _n; ++i)
+                    _values.emplace_back(std::max<int64_t>(_hw_values.at(i), 0));
+            }
+        }
+
+        _profiles.get_timer(itr.m_signal, _hw_labels).add(_frames, _values);
+        _profiles.beg = std::min(_profiles.beg, itr.m_beg);
+        _profiles.end = std::max(_profiles.end, itr.m_end);
+    }
+
+    for(const auto& itr : _overflow_data)
+    {
+        if(!_thread_info->is_valid_lifetime({ itr.m_beg, itr.m_end })) continue;
+
+        int64_t _wall = itr.m_end - itr.m_beg;
+        _profiles.overflow.add(_get_frames(itr.m_stack), { 1, _wall });
+        _profiles.beg = std::min(_profiles.beg, itr.m_beg);
+        _profiles.end = std::max(_profiles.end, itr.m_end);
+    }
+}
+
+void
+write_profiles(const sampling_profiles& _profiles)
+{
+    auto _duration =
+        (_profiles.end > _profiles.beg) ? (_profiles.end - _profiles.beg) : uint64_t{ 0 };
+
+    auto _write = [&](const stack_profile& _profile, const std::string& _prefix,
+                      int64_t _period_v, bool _folded) {
+        if(_profile.empty()) return;
+
+        if(_folded)
+        {
+            const auto& _types = _profile.get_value_types();
+            for(size_t i = 0; i < _types.size(); ++i)
+            {
+                // e.g. the cpu time is not available without thread cpu time metrics
+                if(_profile.get_total(i) <= 0) continue;
+
+                // hardware counter names may contain characters such as "::"
+                auto _type = _types.at(i).type;
+                std::replace_if(
+                    _type.begin(), _type.end(),
+                    [](char _c) { return std::isalnum(_c) == 0 && _c != '_'; }, '_');
+                auto _label = (i == 0) ? _prefix : JOIN('-', _prefix, _type);
+                auto _fname = tim::settings::compose_output_filename(
+                    JOIN('-', _label, "folded"), ".txt");
+                if(_profile.write_folded(_fname, i) && get_verbose() >= 0)
+                    operation::file_output_message<backtrace>{}(
+                        _fname, std::string{ "folded stacks" });
+            }
+        }
+
+        if(get_sampling_pprof_output())
+        {
+            auto _fname = tim::settings::compose_output_filename(_prefix, ".pb");
+            if(_profile.write_pprof(_fname, _profiles.beg, _duration, _period_v) &&
+               get_verbose() >= 0)
+                operation::file_output_message<backtrace>{}(_fname,
+                                                            std::string{ "pprof" });
+        }
+    };
+
+    for(const auto& itr : _profiles.timer)
+        _write(itr.second, JOIN('-', "sampling", get_timer_clock(itr.first)),
+               get_timer_period(itr.first), get_sampling_folded_output());
+    _write(_profiles.overflow, "sampling-overflow", 0, get_sampling_folded_output());
+
+    // the off-CPU flamegraph is always written when the off-CPU analysis is enabled
+    if(get_sampling_offcpu())
+    {
+        if(_profiles.offcpu.empty())
+            ROCPROFSYS_VERBOSE(0, "[sampling] No off-CPU time was attributed to any "
+                                  "call-stack. Off-CPU analysis requires "
+                                  "ROCPROFSYS_SAMPLING_REALTIME=ON and the "
+                                  "thread_cpu_time category\n");
+        _write(_profiles.offcpu, "sampling-offcpu",
+               get_timer_period(get_sampling_realtime_signal()), true);
+    }
+}
+
 struct sampling_initialization
 {
     static void preinit()
@@ -1546,6 +1835,9 @@ struct sampling_initialization
         sampling_cpu_clock::label()       = "sampling_cpu_clock";
         sampling_cpu_clock::description() = "CPU clock time (via sampling)";
 
+        sampling_offcpu_clock::label()       = "sampling_offcpu_clock";
+        sampling_offcpu_clock::description() = "Off-CPU (blocked) time (via sampling)";
+
         sampling_percent::label()       = "sampling_percent";
         sampling_percent::description() = "Percentage of samples";
         sampling_percent::set_precision(3);
@@ -0,0 +1,261 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/sampling_controller.hpp"
+#include "core/common.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <string>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace rocprofsys
+{
+namespace sampling
+{
+namespace controller
+{
+namespace
+{
+constexpr size_t   max_timers         = 4;
+constexpr size_t   min_window_samples = 4;
+constexpr uint64_t window_ns          = 100000000;  // 100 msec
+constexpr double   retune_threshold   = 0.1;
+
+struct timer_info
+{
+    int     id     = -1;
+    int64_t period = 0;
+};
+
+// everything here is accessed from the signal handler so it must not require dynamic
+// initialization of the thread-local
+struct controller_state
+{
+    bool                               active         = false;
+    size_t                             ntimers        = 0;
+    double                             budget         = 0.0;
+    double                             max_scale      = 1.0;
+    double                             scale          = 1.0;
+    double                             peak_scale     = 1.0;
+    uint64_t                           sample_beg     = 0;
+    uint64_t                           window_beg     = 0;
+    uint64_t                           window_cost    = 0;
+    size_t                             window_samples = 0;
+    uint64_t                           total_beg      = 0;
+    uint64_t                           total_cost     = 0;
+    size_t                             num_retunes    = 0;
+    std::array<timer_info, max_timers> timers         = {};
+};
+
+thread_local controller_state state = {};
+
+uint64_t
+now_ns()
+{
+    struct timespec _ts;
+    clock_gettime(CLOCK_MONOTONIC, &_ts);
+    return (static_cast<uint64_t>(_ts.tv_sec) * 1000000000UL) + _ts.tv_nsec;
+}
+
+// the timers are created by timemory and the timer_t handles are not exposed so the
+// kernel timer ids are used directly via the raw syscalls
+int
+get_timer_interval(int _id, int64_t& _period)
+{
+    struct itimerspec _spec = {};
+    auto              _ret  = syscall(SYS_timer_gettime, _id, &_spec);
+    _period = (_spec.it_interval.tv_sec * 1000000000L) + _spec.it_interval.tv_nsec;
+    return _ret;
+}
+
+int
+set_timer_interval(int _id, int64_t _period)
+{
+    struct itimerspec _spec = {};
+
+    _spec.it_interval.tv_sec  = _period / 1000000000L;
+    _spec.it_interval.tv_nsec = _period % 1000000000L;
+    _spec.it_value            = _spec.it_interval;
+    return syscall(SYS_timer_settime, _id, 0, &_spec, nullptr);
+}
+
+// returns the (kernel timer id, signal) pairs of the POSIX timers which notify the
+// given thread. Requires /proc/<pid>/timers (CONFIG_CHECKPOINT_RESTORE)
+auto
+get_thread_timers(long _sys_tid)
+{
+    auto _data = std::vector<std::pair<int, int>>{};
+    auto _ifs  = std::ifstream{ "/proc/self/timers" };
+    if(!_ifs) return _data;
+
+    int  _id     = -1;
+    int  _signo  = -1;
+    long _notify = -1;
+    auto _line   = std::string{};
+    while(std::getline(_ifs, _line))
+    {
+        if(sscanf(_line.c_str(), "ID: %d", &_id) == 1)
+        {
+            _signo  = -1;
+            _notify = -1;
+        }
+        else if(sscanf(_line.c_str(), "signal: %d/", &_signo) == 1)
+        {}
+        else if(_line.find("notify:") == 0)
+        {
+            auto _pos = _line.find("tid.");
+            if(_pos != std::string::npos) _notify = std::stol(_line.substr(_pos + 4));
+        }
+        else if(_line.find("ClockID:") == 0)
+        {
+            if(_id >= 0 && _signo > 0 && _notify == _sys_tid)
+                _data.emplace_back(_id, _signo);
+            _id = -1;
+        }
+    }
+    return _data;
+}
+
+void
+retune(double _scale)
+{
+    for(size_t i = 0; i < state.ntimers; ++i)
+    {
+        const auto& _timer = state.timers[i];
+        set_timer_interval(_timer.id, static_cast<int64_t>(_timer.period * _scale));
+    }
+    state.scale      = _scale;
+    state.peak_scale = std::max(state.peak_scale, _scale);
+    ++state.num_retunes;
+}
+}  // namespace
+
+bool
+enabled()
+{
+    return (config::get_sampling_overhead_budget() > 0.0);
+}
+
+void
+configure(bool _setup, int64_t _tid, const std::set<int>& _signals)
+{
+    if(!enabled()) return;
+
+    if(_setup)
+    {
+        state = controller_state{};
+
+        for(auto itr : get_thread_timers(threading::get_sys_tid()))
+        {
+            if(state.ntimers >= max_timers) break;
+            if(_signals.count(itr.second) == 0) continue;
+
+            int64_t _period = 0;
+            if(get_timer_interval(itr.first, _period) != 0 || _period <= 0) continue;
+
+            state.timers[state.ntimers++] = timer_info{ itr.first, _period };
+        }
+
+        if(state.ntimers == 0)
+        {
+            ROCPROFSYS_VERBOSE(1,
+                               "[sampling] unable to locate the sampling timers of "
+                               "thread %li in /proc/self/timers. Adaptive sampling "
+                               "frequency is disabled for this thread\n",
+                               _tid);
+            return;
+        }
+
+        state.budget     = config::get_sampling_overhead_budget() / 100.0;
+        state.max_scale  = config::get_sampling_max_interval_scale();
+        state.total_beg  = now_ns();
+        state.window_beg = state.total_beg;
+        state.active     = true;
+    }
+    else if(state.active)
+    {
+        state.active = false;
+
+        auto _elapsed = now_ns() - state.total_beg;
+        auto _frac    = (_elapsed > 0) ? (100.0 * state.total_cost) / _elapsed : 0.0;
+        ROCPROFSYS_VERBOSE(1,
+                           "[sampling] thread %li spent %.3f%% of its time sampling "
+                           "(budget: %.3f%%). Interval scale: %.2fx (peak: %.2fx, "
+                           "retuned %zu times)\n",
+                           _tid, _frac, 100.0 * state.budget, state.scale,
+                           state.peak_scale, state.num_retunes);
+    }
+}
+
+float
+begin_sample()
+{
+    if(!state.active) return 1.0f;
+    state.sample_beg = now_ns();
+    return static_cast<float>(state.scale);
+}
+
+void
+end_sample()
+{
+    if(!state.active || state.sample_beg == 0) return;
+
+    auto _now  = now_ns();
+    auto _cost = _now - state.sample_beg;
+
+    state.sample_beg = 0;
+    state.window_cost += _cost;
+    state.total_cost += _cost;
+    ++state.window_samples;
+
+    auto _elapsed = _now - state.window_beg;
+    if(_elapsed < window_ns || state.window_samples < min_window_samples) return;
+
+    // overhead scales inversely with the interval so the interval which meets the
+    // budget is the current one scaled by the ratio of the observed overhead to the
+    // budget. The change per window is limited to a factor of two to damp the
+    // response to short bursts of expensive samples
+    auto _frac   = static_cast<double>(state.window_cost) / _elapsed;
+    auto _target = state.scale * (_frac / state.budget);
+    _target      = std::clamp(_target, 0.5 * state.scale, 2.0 * state.scale);
+    _target      = std::clamp(_target, 1.0, state.max_scale);
+
+    if(std::abs(_target - state.scale) > retune_threshold * state.scale) retune(_target);
+
+    state.window_beg     = _now;
+    state.window_cost    = 0;
+    state.window_samples = 0;
+}
+}  // namespace controller
+}  // namespace sampling
+}  // namespace rocprofsys
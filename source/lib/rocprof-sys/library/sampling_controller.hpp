@@ -0,0 +1,55 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+#include <set>
+
+namespace rocprofsys
+{
+namespace sampling
+{
+namespace controller
+{
+// whether ROCPROFSYS_SAMPLING_OVERHEAD_BUDGET enables the adaptive controller
+bool
+enabled();
+
+// must be called on the sampled thread. When setting up, this is called after the
+// sampler is started so that the kernel timers for the given signals exist
+void
+configure(bool _setup, int64_t _tid, const std::set<int>& _signals);
+
+// the functions below are async-signal-safe and only touch thread-local state.
+// begin_sample() is called first in the sampling handler and returns the weight of
+// the sample (the ratio of the current interval to the configured interval).
+// end_sample() is called last in the sampling handler and, once per evaluation
+// window, retunes the interval of the thread's timers to stay within the budget
+float
+begin_sample();
+
+void
+end_sample();
+}  // namespace controller
+}  // namespace sampling
+}  // namespace rocprofsys
@@ -0,0 +1,283 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/sampling_profile.hpp"
+#include "core/debug.hpp"
+
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <utility>
+
+namespace rocprofsys
+{
+namespace sampling
+{
+namespace
+{
+// minimal protobuf encoding for the handful of message types in profile.proto
+struct proto_writer
+{
+    void varint(uint64_t _v)
+    {
+        while(_v >= 0x80)
+        {
+            data.push_back(static_cast<char>((_v & 0x7f) | 0x80));
+            _v >>= 7;
+        }
+        data.push_back(static_cast<char>(_v));
+    }
+
+    void tag(uint32_t _field, uint32_t _wire_type) { varint((_field << 3) | _wire_type); }
+
+    void field(uint32_t _field, uint64_t _v)
+    {
+        if(_v == 0) return;
+        tag(_field, 0);
+        varint(_v);
+    }
+
+    void field(uint32_t _field, const std::string& _v)
+    {
+        tag(_field, 2);
+        varint(_v.size());
+        data.append(_v);
+    }
+
+    template <typename ContainerT>
+    void packed(uint32_t _field, const ContainerT& _v)
+    {
+        auto _nested = proto_writer{};
+        for(auto itr : _v)
+            _nested.varint(static_cast<uint64_t>(itr));
+        field(_field, _nested.data);
+    }
+
+    void message(uint32_t _field, const proto_writer& _v) { field(_field, _v.data); }
+
+    std::string data = {};
+};
+
+std::string
+sanitize_folded(std::string _v)
+{
+    // ';' separates frames and the last space separates the value
+    for(auto& itr : _v)
+    {
+        if(itr == ';' || itr == '\n') itr = ':';
+    }
+    return _v;
+}
+}  // namespace
+
+size_t
+stack_profile::stack_hash::operator()(const stack_t& _v) const
+{
+    size_t _hash = _v.size();
+    for(auto itr : _v)
+        _hash ^= itr + 0x9e3779b9 + (_hash << 6) + (_hash >> 2);
+    return _hash;
+}
+
+stack_profile::stack_profile(std::vector<value_type> _types)
+: m_types{ std::move(_types) }
+{}
+
+uint32_t
+stack_profile::get_frame_id(const frame& _v)
+{
+    auto itr = m_frame_id.find(_v.name);
+    if(itr != m_frame_id.end()) return itr->second;
+
+    auto _id = static_cast<uint32_t>(m_frames.size());
+    m_frames.emplace_back(_v);
+    m_frame_id.emplace(_v.name, _id);
+    return _id;
+}
+
+void
+stack_profile::add(const std::vector<frame>& _stack, const values_t& _values)
+{
+    if(_stack.empty()) return;
+
+    auto _key = stack_t{};
+    _key.reserve(_stack.size());
+    for(const auto& itr : _stack)
+        _key.emplace_back(get_frame_id(itr));
+
+    auto& _accum = m_stacks[_key];
+    _accum.resize(m_types.size(), 0);
+    for(size_t i = 0; i < std::min(_accum.size(), _values.size()); ++i)
+        _accum[i] += _values[i];
+}
+
+size_t
+stack_profile::get_value_index(const std::string& _type) const
+{
+    for(size_t i = 0; i < m_types.size(); ++i)
+        if(m_types[i].type == _type) return i;
+    return m_types.size();
+}
+
+int64_t
+stack_profile::get_total(size_t _value_idx) const
+{
+    int64_t _total = 0;
+    for(const auto& itr : m_stacks)
+        if(_value_idx < itr.second.size()) _total += itr.second.at(_value_idx);
+    return _total;
+}
+
+bool
+stack_profile::write_folded(const std::string& _fname, size_t _value_idx) const
+{
+    if(_value_idx >= m_types.size()) return false;
+
+    auto _ofs = std::ofstream{};
+    if(!tim::filepath::open(_ofs, _fname))
+    {
+        ROCPROFSYS_VERBOSE(0, "Error opening folded stack output file: %s\n",
+                           _fname.c_str());
+        return false;
+    }
+
+    auto _names = std::vector<std::string>{};
+    _names.reserve(m_frames.size());
+    for(const auto& itr : m_frames)
+        _names.emplace_back(sanitize_folded(itr.name));
+
+    // sort the output so that identical profiles produce identical files
+    auto _lines = std::vector<std::pair<std::string, int64_t>>{};
+    _lines.reserve(m_stacks.size());
+    for(const auto& itr : m_stacks)
+    {
+        auto _value = itr.second.at(_value_idx);
+        if(_value <= 0) continue;
+
+        auto _line = std::string{};
+        for(auto fitr : itr.first)
+        {
+            if(!_line.empty()) _line += ";";
+            _line += _names.at(fitr);
+        }
+        _lines.emplace_back(std::move(_line), _value);
+    }
+    std::sort(_lines.begin(), _lines.end());
+
+    for(const auto& itr : _lines)
+        _ofs << itr.first << " " << itr.second << "\n";
+
+    return true;
+}
+
+bool
+stack_profile::write_pprof(const std::string& _fname, uint64_t _time_nanos,
+                           uint64_t _duration_nanos, int64_t _period) const
+{
+    auto _ofs = std::ofstream{};
+    if(!tim::filepath::open(_ofs, _fname, std::ios::out | std::ios::binary))
+    {
+        ROCPROFSYS_VERBOSE(0, "Error opening pprof output file: %s\n", _fname.c_str());
+        return false;
+    }
+
+    // string_table[0] must be the empty string
+    auto _strings    = std::vector<std::string>{ "" };
+    auto _string_ids = std::unordered_map<std::string, uint64_t>{ { "", 0 } };
+    auto _string_id  = [&_strings, &_string_ids](const std::string& _v) {
+        auto itr = _string_ids.find(_v);
+        if(itr != _string_ids.end()) return itr->second;
+        auto _id = _strings.size();
+        _strings.emplace_back(_v);
+        _string_ids.emplace(_v, _id);
+        return static_cast<uint64_t>(_id);
+    };
+
+    auto _profile    = proto_writer{};
+    auto _value_type = [&_string_id](const value_type& _v) {
+        auto _msg = proto_writer{};
+        _msg.field(1, _string_id(_v.type));
+        _msg.field(2, _string_id(_v.unit));
+        return _msg;
+    };
+
+    // Profile.sample_type = 1
+    for(const auto& itr : m_types)
+        _profile.message(1, _value_type(itr));
+
+    // Profile.sample = 2. Location ids are frame ids + 1 (zero is not a valid id) and
+    // pprof expects the leaf first
+    for(const auto& itr : m_stacks)
+    {
+        auto _locations = std::vector<uint64_t>{};
+        _locations.reserve(itr.first.size());
+        for(auto fitr = itr.first.rbegin(); fitr != itr.first.rend(); ++fitr)
+            _locations.emplace_back(*fitr + 1);
+
+        auto _sample = proto_writer{};
+        _sample.packed(1, _locations);
+        _sample.packed(2, itr.second);
+        _profile.message(2, _sample);
+    }
+
+    // Profile.location = 4 and Profile.function = 5: one of each per frame
+    for(size_t i = 0; i < m_frames.size(); ++i)
+    {
+        auto _line = proto_writer{};
+        _line.field(1, i + 1);
+
+        auto _location = proto_writer{};
+        _location.field(1, i + 1);
+        _location.message(4, _line);
+        _profile.message(4, _location);
+    }
+
+    for(size_t i = 0; i < m_frames.size(); ++i)
+    {
+        const auto& _frame    = m_frames.at(i);
+        auto        _function = proto_writer{};
+        _function.field(1, i + 1);
+        _function.field(2, _string_id(_frame.name));
+        _function.field(3, _string_id(_frame.name));
+        _function.field(4, _string_id(_frame.location));
+        _profile.message(5, _function);
+    }
+
+    // the string table, time and period must come after every call to _string_id
+    auto _period_type = (m_types.size() > 1) ? _value_type(m_types.at(1))
+                                             : _value_type(m_types.at(0));
+
+    for(const auto& itr : _strings)
+        _profile.field(6, itr);
+
+    _profile.field(9, _time_nanos);
+    _profile.field(10, _duration_nanos);
+    _profile.message(11, _period_type);
+    _profile.field(12, static_cast<uint64_t>(_period));
+
+    _ofs.write(_profile.data.data(), _profile.data.size());
+    return _ofs.good();
+}
+}  // namespace sampling
+}  // namespace rocprofsys
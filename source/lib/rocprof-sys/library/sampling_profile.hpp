@@ -0,0 +1,87 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rocprofsys
+{
+namespace sampling
+{
+// aggregates identical call-stacks from the sampler and writes them as collapsed
+// (folded) stacks or as a pprof profile.proto without going through perfetto
+struct stack_profile
+{
+    struct value_type
+    {
+        std::string type = {};
+        std::string unit = {};
+    };
+
+    struct frame
+    {
+        std::string name     = {};
+        std::string location = {};
+    };
+
+    using stack_t  = std::vector<uint32_t>;
+    using values_t = std::vector<int64_t>;
+
+    explicit stack_profile(std::vector<value_type> _types);
+
+    // frames are ordered from the root of the call-stack to the leaf
+    void add(const std::vector<frame>& _stack, const values_t& _values);
+
+    bool    empty() const { return m_stacks.empty(); }
+    size_t  size() const { return m_stacks.size(); }
+    size_t  get_value_index(const std::string& _type) const;
+    int64_t get_total(size_t _value_idx) const;
+
+    const auto& get_value_types() const { return m_types; }
+
+    // "root;...;leaf <value>" per line for the given value type
+    bool write_folded(const std::string& _fname, size_t _value_idx) const;
+
+    // uncompressed profile.proto (pprof detects and accepts both gzipped and raw)
+    bool write_pprof(const std::string& _fname, uint64_t _time_nanos,
+                     uint64_t _duration_nanos, int64_t _period) const;
+
+private:
+    struct stack_hash
+    {
+        size_t operator()(const stack_t&) const;
+    };
+
+    uint32_t get_frame_id(const frame&);
+
+    std::vector<value_type>                           m_types    = {};
+    std::vector<frame>                                m_frames   = {};
+    std::unordered_map<std::string, uint32_t>         m_frame_id = {};
+    std::unordered_map<stack_t, values_t, stack_hash> m_stacks   = {};
+};
+}  // namespace sampling
+}  // namespace rocprofsys
@@ -25,6 +25,7 @@
 #include "core/common.hpp"
 #include "core/concepts.hpp"
 #include "core/config.hpp"
+#include "core/containers/lazy_vector.hpp"
 #include "core/containers/stable_vector.hpp"
 #include "core/debug.hpp"
 #include "core/defines.hpp"
@@ -36,7 +37,9 @@
 #include <timemory/utility/macros.hpp>
 #include <timemory/utility/types.hpp>
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <cstdint>
 #include <cstdlib>
 #include <memory>
@@ -56,6 +59,11 @@ using bundle_allocator_t = tim::data::ring_buffer_allocator<instrumentation_bund
 
 using grow_functor_t = int64_t (*)(int64_t);
 
+// number of slots in the first storage chunk of a thread_data instance. Storage grows
+// on demand in chunks of doubling size instead of allocating MaxThreads slots upfront
+template <size_t MaxThreads>
+constexpr size_t thread_data_chunk_size_v = std::min<size_t>(MaxThreads, 16);
+
 inline auto&
 grow_functors()
 {
@@ -63,6 +71,32 @@ grow_functors()
     return _v;
 }
 
+// type_mutex<data_growth>() serializes grow_data() with the reservation of the slots
+// in the thread_data instances which are created afterwards
+struct data_growth
+{};
+
+// number of threads whose slots are reserved in every thread_data instance
+inline auto&
+reserved_num_threads()
+{
+    static auto _v = std::atomic<int64_t>{ 0 };
+    return _v;
+}
+
+// reserves the slots of the threads which were initialized before the container was
+// created so that accessing them never allocates. Must not be invoked while
+// constructing the static returned by private_instance() since the grow functors
+// access it while holding the lock
+template <typename ContainerT>
+ContainerT&
+reserve_thread_data(ContainerT& _data)
+{
+    auto_lock_t _lk{ type_mutex<data_growth>() };
+    _data.reserve(reserved_num_threads().load(std::memory_order_relaxed));
+    return _data;
+}
+
 template <typename Tp>
 struct base_thread_data
 {
@@ -70,11 +104,7 @@ struct base_thread_data
     {
         auto _func = [](int64_t _sz) -> int64_t {
             decltype(auto) _v = Tp::private_instance();
-            if(_v && _v->capacity() < static_cast<size_t>(_sz + 1))
-            {
-                _v->reserve(_v->capacity() + 1);
-                _v->resize(_v->capacity());
-            }
+            if(_v && _v->capacity() < static_cast<size_t>(_sz)) _v->resize(_sz);
             return (_v) ? _v->capacity() : 0;
         };
         grow_functors().emplace_back(std::move(_func));
@@ -104,8 +134,9 @@ struct thread_data : base_thread_data<thread_data<Tp, Tag, MaxThreads>>
 {
     using this_type  = thread_data<Tp, Tag, MaxThreads>;
     using value_type = unique_ptr_t<Tp>;
-    using array_type =
-        container::stable_vector<value_type, MaxThreads, container::cacheline_align_v>;
+    using array_type   = container::lazy_vector<value_type,
+                                              thread_data_chunk_size_v<MaxThreads>,
+                                              container::cacheline_align_v>;
     using functor_type = std::function<value_type()>;
 
     template <typename... Args>
@@ -128,8 +159,8 @@ struct thread_data : base_thread_data<thread_data<Tp, Tag, MaxThreads>>
 
     static size_t size() { return private_instance()->m_data.size(); }
 
-    decltype(auto) data() { return m_data; }
-    decltype(auto) data() const { return m_data; }
+    auto&       data() { return m_data; }
+    const auto& data() const { return m_data; }
 
     decltype(auto) begin() { return m_data.begin(); }
     decltype(auto) end() { return m_data.end(); }
@@ -147,15 +178,7 @@ struct thread_data : base_thread_data<thread_data<Tp, Tag, MaxThreads>>
     decltype(auto) capacity() const { return m_data.capacity(); }
     decltype(auto) empty() const { return m_data.empty(); }
 
-    void resize(size_t _n) { container::resize(m_data, _n, m_init()); }
-
-    template <typename Up>
-    void resize(size_t _n, Up&& _v)
-    {
-        static_assert(std::is_assignable<value_type, Up>::value,
-                      "value is not assignable to optional<Tp>");
-        container::resize(m_data, _n, std::forward<Up>(_v));
-    }
+    void resize(size_t _n) { container::resize(m_data, _n); }
 
     static array_type* get()
     {
@@ -170,8 +193,7 @@ private:
     template <typename... Args>
     static array_type& instances(construct_on_init, Args&&...);
 
-    array_type   m_data = array_type(MaxThreads);
-    functor_type m_init = []() { return value_type{}; };
+    array_type m_data = {};
 };
 
 template <typename Tp, typename Tag, size_t MaxThreads>
@@ -205,7 +227,8 @@ template <typename Tp, typename Tag, size_t MaxThreads>
 typename thread_data<Tp, Tag, MaxThreads>::array_type&
 thread_data<Tp, Tag, MaxThreads>::instances()
 {
-    return private_instance()->m_data;
+    static auto& _v = reserve_thread_data(private_instance()->m_data);
+    return _v;
 }
 
 template <typename Tp, typename Tag, size_t MaxThreads>
@@ -224,12 +247,10 @@ thread_data<Tp, Tag, MaxThreads>::instances(construct_on_init, Args&&... _args)
 {
     static auto& _v = [&]() -> array_type& {
         auto& _internal = instances();
-        for(size_t i = 0; i < MaxThreads; ++i)
-            _internal.at(i) =
-                utility::generate<value_type>{}(std::forward<Args>(_args)...);
-        private_instance()->m_init = [_args...]() {
-            return utility::generate<value_type>{}(_args...);
-        };
+        _internal.set_initializer(
+            [_args...]() { return utility::generate<value_type>{}(_args...); });
+        for(auto& itr : _internal)
+            itr = utility::generate<value_type>{}(std::forward<Args>(_args)...);
         return _internal;
     }();
     return _v;
@@ -248,21 +269,22 @@ struct thread_data<std::optional<Tp>, Tag, MaxThreads>
     using this_type    = thread_data<std::optional<Tp>, Tag, MaxThreads>;
     using value_type   = std::optional<Tp>;
     using functor_type = std::function<value_type()>;
-    using array_type =
-        container::stable_vector<value_type, MaxThreads, container::cacheline_align_v>;
+    using array_type   = container::lazy_vector<value_type,
+                                              thread_data_chunk_size_v<MaxThreads>,
+                                              container::cacheline_align_v>;
 
     thread_data()  = default;
     ~thread_data() = default;
 
     explicit thread_data(functor_type&& _init)
-    : m_init{ std::move(_init) }
+    : m_data{ std::move(_init) }
     {}
 
-    thread_data(const thread_data&)     = default;
-    thread_data(thread_data&&) noexcept = default;
+    thread_data(const thread_data&)     = delete;
+    thread_data(thread_data&&) noexcept = delete;
 
-    thread_data& operator=(const thread_data&) = default;
-    thread_data& operator=(thread_data&&) noexcept = default;
+    thread_data& operator=(const thread_data&) = delete;
+    thread_data& operator=(thread_data&&) noexcept = delete;
 
     static unique_ptr_t<this_type>& instance();
 
@@ -280,8 +302,8 @@ struct thread_data<std::optional<Tp>, Tag, MaxThreads>
 
     size_t size() { return m_data.size(); }
 
-    decltype(auto) data() { return m_data; }
-    decltype(auto) data() const { return m_data; }
+    auto&       data() { return m_data; }
+    const auto& data() const { return m_data; }
 
     decltype(auto) begin() { return m_data.begin(); }
     decltype(auto) end() { return m_data.end(); }
@@ -299,7 +321,7 @@ struct thread_data<std::optional<Tp>, Tag, MaxThreads>
     decltype(auto) capacity() const { return m_data.capacity(); }
     decltype(auto) empty() const { return m_data.empty(); }
 
-    void resize(size_t _n) { container::resize(m_data, _n, m_init()); }
+    void resize(size_t _n) { container::resize(m_data, _n); }
 
     template <typename Up>
     void resize(size_t _n, Up&& _v)
@@ -313,8 +335,7 @@ private:
     friend struct base_thread_data<this_type>;
     static decltype(auto) private_instance() { return instance(); }
 
-    array_type   m_data = {};
-    functor_type m_init = []() { return value_type{}; };
+    array_type m_data = {};
 };
 
 template <typename Tp, typename Tag, size_t MaxThreads>
@@ -336,7 +357,7 @@ thread_data<std::optional<Tp>, Tag, MaxThreads>::instance(construct_on_init,
         if(!_ref)
             _ref = utility::generate<unique_ptr_t<this_type>>{}(
                 std::forward<Args>(_args)...);
-        if(_ref->size() < MaxThreads) _ref->resize(MaxThreads);
+        if(_ref) reserve_thread_data(_ref->m_data);
         return _ref;
     }();
     return _v;
@@ -353,6 +374,8 @@ thread_data<std::optional<Tp>, Tag, MaxThreads>::construct(construct_on_init,
     static auto  _v   = [&]() {
         if(_ref)
         {
+            _ref->m_data.set_initializer(
+                [_args...]() { return utility::generate<value_type>{}(_args...); });
             for(auto& itr : *_ref)
                 itr = utility::generate<value_type>{}(std::forward<Args>(_args)...);
         }
@@ -371,17 +394,14 @@ thread_data<std::optional<Tp>, Tag, MaxThreads>::construct(construct_on_thread&&
     // construct outside of lambda to prevent data-race
     static auto& _instance = instance(construct_on_init{});
     static auto  _constructed =
-        container::stable_vector<bool, MaxThreads, container::cacheline_align_v>{};
+        container::lazy_vector<bool, thread_data_chunk_size_v<MaxThreads>,
+                               container::cacheline_align_v>{};
     static auto _grow = []() {
-        container::resize(_constructed, MaxThreads, false);
         grow_functors().emplace_back([](int64_t _n) -> int64_t {
-            if(static_cast<size_t>(_n) >= _constructed.size())
-            {
-                _constructed.reserve(_constructed.capacity() + 1);
-                container::resize(_constructed, _constructed.capacity(), false);
-            }
-            return _constructed.size();
+            _constructed.reserve(_n);
+            return _constructed.capacity();
         });
+        reserve_thread_data(_constructed);
         return true;
     }();
 
@@ -418,22 +438,23 @@ struct thread_data<identity<Tp>, Tag, MaxThreads>
 {
     using this_type  = thread_data<identity<Tp>, Tag, MaxThreads>;
     using value_type = Tp;
-    using array_type =
-        container::stable_vector<value_type, MaxThreads, container::cacheline_align_v>;
+    using array_type   = container::lazy_vector<value_type,
+                                              thread_data_chunk_size_v<MaxThreads>,
+                                              container::cacheline_align_v>;
     using functor_type = std::function<value_type()>;
 
     thread_data()  = default;
     ~thread_data() = default;
 
     explicit thread_data(functor_type&& _init)
-    : m_init{ std::move(_init) }
+    : m_data{ std::move(_init) }
     {}
 
-    thread_data(const thread_data&)     = default;
-    thread_data(thread_data&&) noexcept = default;
+    thread_data(const thread_data&)     = delete;
+    thread_data(thread_data&&) noexcept = delete;
 
-    thread_data& operator=(const thread_data&) = default;
-    thread_data& operator=(thread_data&&) noexcept = default;
+    thread_data& operator=(const thread_data&) = delete;
+    thread_data& operator=(thread_data&&) noexcept = delete;
 
     static unique_ptr_t<this_type>& instance();
 
@@ -451,8 +472,8 @@ struct thread_data<identity<Tp>, Tag, MaxThreads>
 
     size_t size() { return m_data.size(); }
 
-    decltype(auto) data() { return m_data; }
-    decltype(auto) data() const { return m_data; }
+    auto&       data() { return m_data; }
+    const auto& data() const { return m_data; }
 
     decltype(auto) begin() { return m_data.begin(); }
     decltype(auto) end() { return m_data.end(); }
@@ -470,7 +491,7 @@ struct thread_data<identity<Tp>, Tag, MaxThreads>
     decltype(auto) capacity() const { return m_data.capacity(); }
     decltype(auto) empty() const { return m_data.empty(); }
 
-    void resize(size_t _n) { container::resize(m_data, _n, m_init()); }
+    void resize(size_t _n) { container::resize(m_data, _n); }
     void resize(size_t _n, value_type&& _v) { container::resize(m_data, _n, _v); }
 
     void fill(value_type _v)
@@ -483,8 +504,7 @@ private:
     friend struct base_thread_data<this_type>;
     static decltype(auto) private_instance() { return instance(); }
 
-    array_type   m_data = {};
-    functor_type m_init = []() { return value_type{}; };
+    array_type m_data = {};
 };
 
 template <typename Tp, typename Tag, size_t MaxThreads>
@@ -505,7 +525,7 @@ thread_data<identity<Tp>, Tag, MaxThreads>::instance(construct_on_init, Args&&..
         if(!_ref)
             _ref = utility::generate<unique_ptr_t<this_type>>{}(
                 std::forward<Args>(_args)...);
-        if(_ref->size() < MaxThreads) _ref->resize(MaxThreads);
+        if(_ref) reserve_thread_data(_ref->m_data);
         return _ref;
     }();
     return _v;
@@ -521,6 +541,8 @@ thread_data<identity<Tp>, Tag, MaxThreads>::construct(construct_on_init, Args&&.
     static auto  _v   = [&]() {
         if(_ref)
         {
+            _ref->m_data.set_initializer(
+                [_args...]() { return utility::generate<value_type>{}(_args...); });
             for(auto& itr : *_ref)
                 itr = utility::generate<value_type>{}(std::forward<Args>(_args)...);
         }
@@ -539,17 +561,14 @@ thread_data<identity<Tp>, Tag, MaxThreads>::construct(construct_on_thread&& _t,
     // construct outside of lambda to prevent data-race
     static auto& _instance = instance(construct_on_init{});
     static auto  _constructed =
-        container::stable_vector<bool, MaxThreads, container::cacheline_align_v>{};
+        container::lazy_vector<bool, thread_data_chunk_size_v<MaxThreads>,
+                               container::cacheline_align_v>{};
     static auto _grow = []() {
-        container::resize(_constructed, MaxThreads, false);
         grow_functors().emplace_back([](int64_t _n) -> int64_t {
-            if(static_cast<size_t>(_n) >= _constructed.size())
-            {
-                _constructed.reserve(_constructed.capacity() + 1);
-                container::resize(_constructed, _constructed.capacity(), false);
-            }
-            return _constructed.size();
+            _constructed.reserve(_n);
+            return _constructed.capacity();
         });
+        reserve_thread_data(_constructed);
         return true;
     }();
 
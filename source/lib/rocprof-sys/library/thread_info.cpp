@@ -35,12 +35,146 @@
 #include <timemory/components/timing/backends.hpp>
 #include <timemory/process/threading.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 namespace rocprofsys
 {
 namespace
 {
+// maps the system, sequent and STL thread ids to the internal thread index. Lookups
+// are lock-free linear probes into a power-of-2 open-addressing table. Insertions
+// happen once per thread (under a lock) and a full table is replaced by a table of
+// twice the capacity: the replaced tables are retained since a concurrent lookup may
+// still be probing them. Entries are never removed: when the system recycles a thread
+// id, the entry is re-assigned to the newest thread
+struct thread_id_index
+{
+    static constexpr size_t initial_capacity = 64;
+
+    struct entry
+    {
+        std::atomic<int64_t> key   = { 0 };
+        std::atomic<int64_t> value = { 0 };  // internal index + 1 (zero == empty)
+    };
+
+    struct table
+    {
+        explicit table(size_t _n)
+        : mask{ _n - 1 }
+        , entries{ std::make_unique<entry[]>(_n) }
+        {}
+
+        size_t                   mask    = 0;
+        size_t                   size    = 0;
+        std::unique_ptr<entry[]> entries = {};
+    };
+
+    thread_id_index() { m_current.store(add_table(initial_capacity)); }
+
+    int64_t find(int64_t _key) const
+    {
+        const auto* _table = m_current.load(std::memory_order_acquire);
+        for(size_t i = hash(_key);; ++i)
+        {
+            const auto& _entry = _table->entries[i & _table->mask];
+            auto        _value = _entry.value.load(std::memory_order_acquire);
+            if(_value == 0) return -1;
+            if(_entry.key.load(std::memory_order_relaxed) == _key) return _value - 1;
+        }
+    }
+
+    void insert(int64_t _key, int64_t _index)
+    {
+        std::unique_lock<std::mutex> _lk{ m_mutex };
+        auto*                        _table = m_current.load(std::memory_order_relaxed);
+        if(2 * (_table->size + 1) > _table->mask + 1)
+        {
+            auto* _grown = add_table(2 * (_table->mask + 1));
+            for(size_t i = 0; i <= _table->mask; ++i)
+            {
+                const auto& _entry = _table->entries[i];
+                auto        _value = _entry.value.load(std::memory_order_relaxed);
+                if(_value > 0)
+                    insert(_grown, _entry.key.load(std::memory_order_relaxed),
+                           _value - 1);
+            }
+            m_current.store(_table = _grown, std::memory_order_release);
+        }
+        insert(_table, _key, _index);
+    }
+
+private:
+    static size_t hash(int64_t _key)
+    {
+        // fibonacci hashing: thread ids are frequently sequential
+        return (static_cast<uint64_t>(_key) * 0x9E3779B97F4A7C15ULL) >> 32;
+    }
+
+    static void insert(table* _table, int64_t _key, int64_t _index)
+    {
+        for(size_t i = hash(_key);; ++i)
+        {
+            auto& _entry = _table->entries[i & _table->mask];
+            auto  _value = _entry.value.load(std::memory_order_relaxed);
+            if(_value == 0)
+            {
+                _entry.key.store(_key, std::memory_order_relaxed);
+                _entry.value.store(_index + 1, std::memory_order_release);
+                ++_table->size;
+                return;
+            }
+            else if(_entry.key.load(std::memory_order_relaxed) == _key)
+            {
+                _entry.value.store(_index + 1, std::memory_order_release);
+                return;
+            }
+        }
+    }
+
+    table* add_table(size_t _n)
+    {
+        return m_tables.emplace_back(std::make_unique<table>(_n)).get();
+    }
+
+    std::mutex                          m_mutex   = {};
+    std::atomic<table*>                 m_current = { nullptr };
+    std::vector<std::unique_ptr<table>> m_tables  = {};
+};
+
+template <ThreadIdType TypeV>
+auto&
+get_thread_id_index()
+{
+    static auto _v = thread_id_index{};
+    return _v;
+}
+
+int64_t
+get_stl_key(std::thread::id _tid)
+{
+    if constexpr(sizeof(std::thread::id) == sizeof(int64_t) &&
+                 std::is_trivially_copyable<std::thread::id>::value)
+    {
+        // unique among the live threads, unlike a hash
+        int64_t _v = 0;
+        std::memcpy(&_v, &_tid, sizeof(_v));
+        return _v;
+    }
+    else
+    {
+        return static_cast<int64_t>(std::hash<std::thread::id>{}(_tid));
+    }
+}
+
 auto&
 get_info_data()
 {
@@ -84,6 +218,10 @@ init_index_data(int64_t _tid, bool _offset = false)
                                      "thread %zi on thread %zi\n",
                                      _tid, itr->internal_value);
 
+        get_thread_id_index<SystemTID>().insert(itr->system_value, _tid);
+        get_thread_id_index<SequentTID>().insert(itr->sequent_value, _tid);
+        get_thread_id_index<StlThreadID>().insert(get_stl_key(itr->stl_value), _tid);
+
         int _verb = 2;
         // if thread created using finalization, bump up the minimum verbosity level
         if(get_state() >= State::Finalized && _offset) _verb += 2;
@@ -125,33 +263,40 @@ thread_index_data::as_string() const
 int64_t
 grow_data(int64_t _tid)
 {
-    struct data_growth
-    {};
+    auto& _reserved = reserved_num_threads();
 
-    if(_tid >= peak_num_threads)
+    // thread_data storage is allocated on first access. Reserve the slot of this thread
+    // in every instance when the thread is initialized so that the allocation does not
+    // happen later, e.g. from within a signal handler. Instances created afterwards
+    // reserve up to reserved_num_threads themselves
+    if(_tid >= _reserved.load(std::memory_order_acquire) || _tid >= peak_num_threads)
     {
         ROCPROFSYS_SCOPED_THREAD_STATE(ThreadState::Internal);
         auto_lock_t _lk{ type_mutex<data_growth>() };
 
         // check again after locking
-        if(_tid >= peak_num_threads)
+        if(_tid >= _reserved.load(std::memory_order_relaxed))
         {
-            TIMEMORY_PRINTF_WARNING(
-                stderr, "[%li] Growing thread data from %li to %li...\n", _tid,
-                peak_num_threads, peak_num_threads + max_supported_threads);
-            fflush(stderr);
-
+            int64_t _capacity = -1;
             for(auto itr : grow_functors())
             {
-                if(itr)
-                {
-                    int64_t _new_capacity = (*itr)(_tid + 1);
-                    TIMEMORY_PRINTF_WARNING(stderr,
-                                            "[%li] Grew thread data from %li to %li...\n",
-                                            _tid, peak_num_threads, _new_capacity);
-                }
+                if(!itr) continue;
+                auto _n   = (*itr)(_tid + 1);
+                _capacity = (_capacity < 0) ? _n : std::min<int64_t>(_capacity, _n);
             }
-            peak_num_threads += max_supported_threads;
+            _reserved.store(std::max<int64_t>(_capacity, _tid + 1),
+                            std::memory_order_release);
+        }
+
+        if(_tid >= peak_num_threads)
+        {
+            auto _peak = peak_num_threads;
+            while(_tid >= _peak)
+                _peak += max_supported_threads;
+            TIMEMORY_PRINTF_WARNING(stderr,
+                                    "[%li] Growing thread data from %li to %li...\n",
+                                    _tid, peak_num_threads, _peak);
+            peak_num_threads = _peak;
         }
     }
 
@@ -245,8 +390,10 @@ thread_info::get(std::thread::id _tid)
     const auto& _v = get_info_data();
     if(_v)
     {
-        for(const auto& itr : *_v)
+        auto _idx = get_thread_id_index<StlThreadID>().find(get_stl_key(_tid));
+        if(_idx >= 0)
         {
+            const auto& itr = _v->at(_idx);
             if(itr && itr->index_data && itr->index_data->stl_value == _tid) return itr;
         }
     }
@@ -262,26 +409,24 @@ thread_info::get(int64_t _tid, ThreadIdType _type)
         return get_info_data(_tid);
     else if(_type == ThreadIdType::SystemTID)
     {
-        const auto& _v = get_info_data();
-        if(_v)
+        const auto& _v   = get_info_data();
+        auto        _idx = get_thread_id_index<SystemTID>().find(_tid);
+        if(_v && _idx >= 0)
         {
-            for(const auto& itr : *_v)
-            {
-                if(itr && itr->index_data && itr->index_data->system_value == _tid)
-                    return itr;
-            }
+            const auto& itr = _v->at(_idx);
+            if(itr && itr->index_data && itr->index_data->system_value == _tid)
+                return itr;
         }
     }
     else if(_type == ThreadIdType::SequentTID)
     {
-        const auto& _v = get_info_data();
-        if(_v)
+        const auto& _v   = get_info_data();
+        auto        _idx = get_thread_id_index<SequentTID>().find(_tid);
+        if(_v && _idx >= 0)
         {
-            for(const auto& itr : *_v)
-            {
-                if(itr && itr->index_data && itr->index_data->sequent_value == _tid)
-                    return itr;
-            }
+            const auto& itr = _v->at(_idx);
+            if(itr && itr->index_data && itr->index_data->sequent_value == _tid)
+                return itr;
         }
     }
     else if(_type == ThreadIdType::PthreadID)
@@ -30,6 +30,8 @@
 #include <timemory/hash/types.hpp>
 #include <timemory/process/threading.hpp>
 
+#include <utility>
+
 namespace rocprofsys
 {
 namespace tracing
@@ -55,6 +57,16 @@ get_timemory_hash_aliases(int64_t _tid)
     return thread_data<identity<tim::hash_alias_ptr_t>>::instance(
         construct_on_thread{ _tid });
 }
+
+// does not construct the data of threads which never traced
+template <typename Tp>
+const Tp&
+find_timemory_hash_data(int64_t _tid)
+{
+    static const auto _empty = Tp{};
+    const auto&       _data  = thread_data<identity<Tp>>::instance();
+    return (_data) ? std::as_const(*_data).at(_tid) : _empty;
+}
 }  // namespace
 
 bool debug_push = tim::get_env("ROCPROFSYS_DEBUG_PUSH", false) || get_debug_env();
@@ -87,8 +99,8 @@ copy_timemory_hash_ids()
     // combine all the hash and alias info into one container
     for(size_t i = 0; i < thread_info::get_peak_num_threads(); ++i)
     {
-        auto& _hitr = get_timemory_hash_ids(i);
-        auto& _aitr = get_timemory_hash_aliases(i);
+        const auto& _hitr = find_timemory_hash_data<tim::hash_map_ptr_t>(i);
+        const auto& _aitr = find_timemory_hash_data<tim::hash_alias_ptr_t>(i);
 
         if(_hitr)
         {
@@ -108,8 +120,8 @@ copy_timemory_hash_ids()
     {
         for(size_t i = 0; i < thread_info::get_peak_num_threads(); ++i)
         {
-            auto& _hitr = get_timemory_hash_ids(i);
-            auto& _aitr = get_timemory_hash_aliases(i);
+            const auto& _hitr = find_timemory_hash_data<tim::hash_map_ptr_t>(i);
+            const auto& _aitr = find_timemory_hash_data<tim::hash_alias_ptr_t>(i);
 
             if(_hitr) *_hitr = *_hmain;
             if(_aitr) *_aitr = *_amain;
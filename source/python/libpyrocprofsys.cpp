@@ -48,6 +48,7 @@
 #include <cstdint>
 #include <exception>
 #include <locale>
+#include <optional>
 #include <regex>
 #include <set>
 #include <stdexcept>
@@ -187,11 +188,33 @@ using profiler_index_map_t = std::unordered_map<uint32_t, profiler_label_map_t>;
 using strset_t             = std::unordered_set<std::string>;
 using note_t               = rocprofsys_annotation_t;
 using annotations_t        = std::array<note_t, 6>;
+using regex_vec_t          = std::vector<std::regex>;
 //
 namespace
 {
 strset_t default_exclude_functions = { "^<.*>$" };
 strset_t default_exclude_filenames = { "(encoder|decoder|threading).py$", "^<.*>$" };
+
+regex_vec_t
+compile_regexes(const strset_t& _expr)
+{
+    const auto _rconstants = std::regex_constants::egrep | std::regex_constants::optimize;
+    auto       _v          = regex_vec_t{};
+    _v.reserve(_expr.size());
+    for(const auto& itr : _expr)  // NOLINT
+        _v.emplace_back(itr, _rconstants);
+    return _v;
+}
+
+bool
+find_matching(const regex_vec_t& _expr, const std::string& _name)
+{
+    for(const auto& itr : _expr)  // NOLINT
+    {
+        if(std::regex_search(_name, itr)) return true;
+    }
+    return false;
+}
 }  // namespace
 //
 auto&
@@ -201,6 +224,44 @@ get_paused()
     return _v;
 }
 //
+struct config;
+//
+// include/exclude/restrict regexes compiled from the configuration
+struct filter_set
+{
+    explicit filter_set(const config&);
+
+    regex_vec_t restrict_functions        = {};
+    regex_vec_t restrict_filenames        = {};
+    regex_vec_t include_functions         = {};
+    regex_vec_t include_filenames         = {};
+    regex_vec_t exclude_functions         = {};
+    regex_vec_t exclude_filenames         = {};
+    regex_vec_t default_exclude_functions = {};
+};
+//
+enum class code_decision : uint8_t
+{
+    skip = 0,
+    skip_ignore_depth,  // excluded function: its callees are ignored too
+    record,
+};
+//
+// filter decision and labels of a code object. The code object is referenced so that
+// its address is not re-used by another code object while the entry is cached
+struct code_entry
+{
+    py::object    code     = {};
+    code_decision decision = code_decision::skip;
+    std::string   func     = {};
+    std::string   file     = {};
+    std::string   full     = {};
+    // labels by line number (zero when the line is not part of the label)
+    std::vector<std::pair<int, const std::string*>> labels = {};
+};
+//
+using code_cache_t = std::unordered_map<PyCodeObject*, code_entry>;
+//
 struct config
 {
     bool                    is_running         = false;
@@ -229,8 +290,31 @@ struct config
                                   note_t{ "argcount", ROCPROFSYS_INT32, nullptr },
                                   note_t{ "nlocals", ROCPROFSYS_INT32, nullptr },
                                   note_t{ "stacksize", ROCPROFSYS_INT32, nullptr } };
+
+    // compiled filters, decisions per code object and the interned labels
+    std::optional<filter_set> filters    = {};
+    code_cache_t              code_cache = {};
+    strset_t                  labels     = {};
+
+    // discards the compiled filters and the cached decisions after the configuration
+    // changed. Labels are kept since the pending records reference them
+    void reset_cache()
+    {
+        filters.reset();
+        code_cache.clear();
+    }
 };
 //
+filter_set::filter_set(const config& _config)
+: restrict_functions{ compile_regexes(_config.restrict_functions) }
+, restrict_filenames{ compile_regexes(_config.restrict_filenames) }
+, include_functions{ compile_regexes(_config.include_functions) }
+, include_filenames{ compile_regexes(_config.include_filenames) }
+, exclude_functions{ compile_regexes(_config.exclude_functions) }
+, exclude_filenames{ compile_regexes(_config.exclude_filenames) }
+, default_exclude_functions{ compile_regexes(pyprofile::default_exclude_functions) }
+{}
+//
 inline config&
 get_config()
 {
@@ -285,16 +369,163 @@ get_frame_lasti(PyFrameObject* frame)
 #endif
 }
 //
-auto
+PyCodeObject*
 get_frame_code(PyFrameObject* frame)
 {
 #if ROCPROFSYS_PYTHON_VERSION >= 31100
-    return PyFrame_GetCode(frame);
+    // PyFrame_GetCode returns a new reference: the frame keeps the code object alive
+    auto* _code = PyFrame_GetCode(frame);
+    Py_XDECREF(_code);
+    return _code;
 #else
     return frame->f_code;
 #endif
 }
 //
+int
+get_trace_what(const char* swhat)
+{
+    switch(swhat[0])
+    {
+        case 'c':
+        {
+            if(strcmp(swhat, "call") == 0) return PyTrace_CALL;
+            if(strcmp(swhat, "c_call") == 0) return PyTrace_C_CALL;
+            if(strcmp(swhat, "c_return") == 0) return PyTrace_C_RETURN;
+            break;
+        }
+        case 'r':
+        {
+            if(strcmp(swhat, "return") == 0) return PyTrace_RETURN;
+            break;
+        }
+        default: break;
+    }
+    return -1;
+}
+//
+std::string
+get_label(const config& _config, const code_entry& _entry, const std::string& _args,
+          int _lineno)
+{
+    auto _funcname = _entry.func;
+    auto _bracket  = _config.include_filename;
+    if(_bracket) _funcname.insert(0, "[");
+    // append the arguments
+    if(_config.include_args) _funcname.append(_args);
+    if(_bracket) _funcname.append("]");
+    // append the filename
+    if(_config.include_filename)
+    {
+        if(_config.full_filepath)
+            _funcname.append(TIMEMORY_JOIN("", '[', _entry.full));
+        else
+            _funcname.append(TIMEMORY_JOIN("", '[', _entry.file));
+    }
+    // append the line number
+    if(_config.include_line && _config.include_filename)
+        _funcname.append(TIMEMORY_JOIN("", ':', _lineno, ']'));
+    else if(_config.include_line)
+        _funcname.append(TIMEMORY_JOIN("", ':', _lineno));
+    else if(_config.include_filename)
+        _funcname += "]";
+    return _funcname;
+}
+//
+// applies the restrict/include/exclude filters to the code object once. Subsequent
+// calls and returns of the code object only look up the cached decision
+code_entry&
+get_code_entry(config& _config, PyCodeObject* _code, const std::string& _internal_path)
+{
+    auto itr = _config.code_cache.find(_code);
+    if(itr != _config.code_cache.end()) return itr->second;
+
+    if(!_config.filters) _config.filters.emplace(_config);
+
+    auto& _filters = *_config.filters;
+    auto& _entry   = _config.code_cache[_code];
+
+    _entry.code = py::reinterpret_borrow<py::object>(reinterpret_cast<PyObject*>(_code));
+    _entry.func = py::cast<std::string>(_code->co_name);
+    _entry.full = py::cast<std::string>(_code->co_filename);
+    _entry.file = (_entry.full.find('/') != std::string::npos)
+                      ? _entry.full.substr(_entry.full.find_last_of('/') + 1)
+                      : _entry.full;
+
+    const auto& _func  = _entry.func;
+    const auto& _full  = _entry.full;
+    bool        _force = false;
+
+    if(!_filters.restrict_functions.empty())
+    {
+        _force = find_matching(_filters.restrict_functions, _func);
+        if(!_force)
+        {
+            if(_config.verbose > 2)
+                TIMEMORY_PRINT_HERE("Skipping non-restricted function: %s",
+                                    _func.c_str());
+            return _entry;
+        }
+    }
+
+    if(!_force)
+    {
+        if(find_matching(_filters.include_functions, _func))
+        {
+            _force = true;
+        }
+        else if(find_matching(_filters.exclude_functions, _func))
+        {
+            if(_config.verbose > 1)
+                TIMEMORY_PRINT_HERE("Skipping designated function: '%s'", _func.c_str());
+            if(!find_matching(_filters.default_exclude_functions, _func))
+                _entry.decision = code_decision::skip_ignore_depth;
+            return _entry;
+        }
+    }
+
+    if(!_config.include_internal &&
+       strncmp(_full.c_str(), _internal_path.c_str(), _internal_path.length()) == 0)
+    {
+        if(_config.verbose > 2)
+            TIMEMORY_PRINT_HERE("Skipping internal function: %s", _func.c_str());
+        return _entry;
+    }
+
+    if(!_force && !_filters.restrict_filenames.empty())
+    {
+        _force = find_matching(_filters.restrict_filenames, _full);
+        if(!_force)
+        {
+            if(_config.verbose > 2)
+                TIMEMORY_PRINT_HERE("Skipping non-restricted file: %s", _full.c_str());
+            return _entry;
+        }
+    }
+
+    if(!_force)
+    {
+        if(find_matching(_filters.include_filenames, _full))
+        {
+            _force = true;
+        }
+        else if(find_matching(_filters.exclude_filenames, _full))
+        {
+            if(_config.verbose > 2)
+                TIMEMORY_PRINT_HERE("Skipping non-included file: %s", _full.c_str());
+            return _entry;
+        }
+    }
+
+    // an empty label is never recorded
+    if(_func.empty() && !_config.include_filename && !_config.include_line &&
+       !_config.include_args)
+        return _entry;
+
+    _entry.decision = code_decision::record;
+    return _entry;
+}
+//
 void
 profiler_function(py::object pframe, const char* swhat, py::object arg)
 {
@@ -315,11 +546,7 @@ profiler_function(py::object pframe, const char* swhat, py::object arg)
 
     auto* frame = reinterpret_cast<PyFrameObject*>(pframe.ptr());
 
-    int what = (strcmp(swhat, "call") == 0)       ? PyTrace_CALL
-               : (strcmp(swhat, "c_call") == 0)   ? PyTrace_C_CALL
-               : (strcmp(swhat, "return") == 0)   ? PyTrace_RETURN
-               : (strcmp(swhat, "c_return") == 0) ? PyTrace_C_RETURN
-                                                  : -1;
+    int what = get_trace_what(swhat);
     // only support PyTrace_{CALL,C_CALL,RETURN,C_RETURN}
     if(what < 0)
     {
@@ -362,11 +589,11 @@ profiler_function(py::object pframe, const char* swhat, py::object arg)
 
     // get the arguments
     auto _get_args = [&]() {
-        auto inspect = py::module::import("inspect");
+        static auto* _inspect = new py::module{ py::module::import("inspect") };
         try
         {
-            return py::cast<std::string>(
-                inspect.attr("formatargvalues")(*inspect.attr("getargvalues")(pframe)));
+            return py::cast<std::string>(_inspect->attr("formatargvalues")(
+                *_inspect->attr("getargvalues")(pframe)));
         } catch(py::error_already_set& _exc)
         {
             TIMEMORY_CONDITIONAL_PRINT_HERE(_config.verbose > 1, "Error! %s",
@@ -376,150 +603,66 @@ profiler_function(py::object pframe, const char* swhat, py::object arg)
         return std::string{};
     };
 
-    // get the final label
-    auto _get_label = [&](auto& _funcname, auto& _filename, auto& _fullpath) {
-        auto _bracket = _config.include_filename;
-        if(_bracket) _funcname.insert(0, "[");
-        // append the arguments
-        if(_config.include_args) _funcname.append(_get_args());
-        if(_bracket) _funcname.append("]");
-        // append the filename
-        if(_config.include_filename)
-        {
-            if(_config.full_filepath)
-                _funcname.append(TIMEMORY_JOIN("", '[', std::move(_fullpath)));
-            else
-                _funcname.append(TIMEMORY_JOIN("", '[', std::move(_filename)));
-        }
-        // append the line number
-        if(_config.include_line && _config.include_filename)
-            _funcname.append(TIMEMORY_JOIN("", ':', get_frame_lineno(frame), ']'));
-        else if(_config.include_line)
-            _funcname.append(TIMEMORY_JOIN("", ':', get_frame_lineno(frame)));
-        else if(_config.include_filename)
-            _funcname += "]";
-        return _funcname;
-    };
-
-    auto _find_matching = [](const strset_t& _expr, const std::string& _name) {
-        const auto _rconstants =
-            std::regex_constants::egrep | std::regex_constants::optimize;
-        for(const auto& itr : _expr)  // NOLINT
-        {
-            if(std::regex_search(_name, std::regex(itr, _rconstants))) return true;
-        }
-        return false;
-    };
-
-    bool  _force      = false;
-    auto& _only_funcs = _config.restrict_functions;
-    auto& _incl_funcs = _config.include_functions;
-    auto& _skip_funcs = _config.exclude_functions;
-    auto  _func       = py::cast<std::string>(get_frame_code(frame)->co_name);
-
-    if(!_only_funcs.empty())
-    {
-        _force = _find_matching(_only_funcs, _func);
-        if(!_force)
-        {
-            if(_config.verbose > 2)
-                TIMEMORY_PRINT_HERE("Skipping non-restricted function: %s",
-                                    _func.c_str());
-            return;
-        }
-    }
+    auto* _code  = get_frame_code(frame);
+    auto& _entry = get_code_entry(_config, _code, _rocprofsys_path);
 
-    if(!_force)
+    switch(_entry.decision)
     {
-        if(_find_matching(_incl_funcs, _func))
-        {
-            _force = true;
-        }
-        else if(_find_matching(_skip_funcs, _func))
-        {
-            if(_config.verbose > 1)
-                TIMEMORY_PRINT_HERE("Skipping designated function: '%s'", _func.c_str());
-            if(!_find_matching(default_exclude_functions, _func))
-                _update_ignore_stack_depth();
-            return;
-        }
+        case code_decision::skip: return;
+        case code_decision::skip_ignore_depth: _update_ignore_stack_depth(); return;
+        case code_decision::record: break;
     }
 
-    auto& _only_files = _config.restrict_filenames;
-    auto& _incl_files = _config.include_filenames;
-    auto& _skip_files = _config.exclude_filenames;
-    auto  _full       = py::cast<std::string>(get_frame_code(frame)->co_filename);
-    auto  _file       = (_full.find('/') != std::string::npos)
-                            ? _full.substr(_full.find_last_of('/') + 1)
-                            : _full;
+    TIMEMORY_CONDITIONAL_PRINT_HERE(_config.verbose > 3, "%8s | %s%s | %s | %s", swhat,
+                                    _entry.func.c_str(), _get_args().c_str(),
+                                    _entry.file.c_str(), _entry.full.c_str());
 
-    if(!_config.include_internal &&
-       strncmp(_full.c_str(), _rocprofsys_path.c_str(), _rocprofsys_path.length()) == 0)
-    {
-        if(_config.verbose > 2)
-            TIMEMORY_PRINT_HERE("Skipping internal function: %s", _func.c_str());
-        return;
-    }
+    auto _intern = [](std::string&& _label) {
+        return &*_config.labels.emplace(std::move(_label)).first;
+    };
 
-    if(!_force && !_only_files.empty())
-    {
-        _force = _find_matching(_only_files, _full);
-        if(!_force)
-        {
-            if(_config.verbose > 2)
-                TIMEMORY_PRINT_HERE("Skipping non-restricted file: %s", _full.c_str());
-            return;
-        }
-    }
+    // get the final label. Labels without the arguments are cached per line number
+    auto _get_label = [&]() {
+        if(_config.include_args)
+            return _intern(
+                get_label(_config, _entry, _get_args(), get_frame_lineno(frame)));
 
-    if(!_force)
-    {
-        if(_find_matching(_incl_files, _full))
-        {
-            _force = true;
-        }
-        else if(_find_matching(_skip_files, _full))
+        auto _lineno = (_config.include_line) ? get_frame_lineno(frame) : 0;
+        for(const auto& itr : _entry.labels)
         {
-            if(_config.verbose > 2)
-                TIMEMORY_PRINT_HERE("Skipping non-included file: %s", _full.c_str());
-            return;
+            if(itr.first == _lineno) return itr.second;
         }
-    }
 
-    TIMEMORY_CONDITIONAL_PRINT_HERE(_config.verbose > 3, "%8s | %s%s | %s | %s", swhat,
-                                    _func.c_str(), _get_args().c_str(), _file.c_str(),
-                                    _full.c_str());
-
-    auto _label = _get_label(_func, _file, _full);
-    if(_label.empty()) return;
-
-    static thread_local strset_t _labels{};
-    const auto&                  _label_ref = *_labels.emplace(_label).first;
-    auto                         _annotate  = _config.annotate_trace;
+        const auto* _label = _intern(get_label(_config, _entry, std::string{}, _lineno));
+        _entry.labels.emplace_back(_lineno, _label);
+        return _label;
+    };
 
     // start function
     auto _profiler_call = [&]() {
-        int _lineno = 0;
-        int _lasti  = 0;
+        const auto* _label    = _get_label();
+        auto        _annotate = _config.annotate_trace;
+        int         _lineno   = 0;
+        int         _lasti    = 0;
         if(_annotate)
         {
             _lineno                         = get_frame_lineno(frame);
             _lasti                          = get_frame_lasti(frame);
-            _config.annotations.at(0).value = const_cast<char*>(_full.c_str());
+            _config.annotations.at(0).value = const_cast<char*>(_entry.full.c_str());
             _config.annotations.at(1).value = &_lineno;
             _config.annotations.at(2).value = &_lasti;
-            _config.annotations.at(3).value = &get_frame_code(frame)->co_argcount;
-            _config.annotations.at(4).value = &get_frame_code(frame)->co_nlocals;
-            _config.annotations.at(5).value = &get_frame_code(frame)->co_stacksize;
+            _config.annotations.at(3).value = &_code->co_argcount;
+            _config.annotations.at(4).value = &_code->co_nlocals;
+            _config.annotations.at(5).value = &_code->co_stacksize;
         }
 
-        _config.records.emplace_back([&_label_ref, _annotate]() {
-            rocprofsys_pop_category_region(ROCPROFSYS_CATEGORY_PYTHON, _label_ref.c_str(),
+        _config.records.emplace_back([_label, _annotate]() {
+            rocprofsys_pop_category_region(ROCPROFSYS_CATEGORY_PYTHON, _label->c_str(),
                                            (_annotate) ? _config.annotations.data()
                                                        : nullptr,
                                            _config.annotations.size());
         });
-        rocprofsys_push_category_region(ROCPROFSYS_CATEGORY_PYTHON, _label_ref.c_str(),
+        rocprofsys_push_category_region(ROCPROFSYS_CATEGORY_PYTHON, _label->c_str(),
                                         (_annotate) ? _config.annotations.data()
                                                     : nullptr,
                                         _config.annotations.size());
@@ -602,7 +745,11 @@ generate(py::module& _pymod)
 #define CONFIGURATION_PROPERTY(NAME, TYPE, DOC, ...)                                     \
     _pyconfig.def_property_static(                                                       \
         NAME, [](py::object&&) { return __VA_ARGS__; },                                  \
-        [](py::object&&, TYPE val) { __VA_ARGS__ = val; }, DOC);
+        [](py::object&&, TYPE val) {                                                     \
+            __VA_ARGS__ = val;                                                           \
+            get_config().reset_cache();                                                  \
+        },                                                                               \
+        DOC);
 
     CONFIGURATION_PROPERTY("_is_running", bool, "Profiler is currently running",
                            get_config().is_running)
@@ -646,6 +793,7 @@ generate(py::module& _pymod)
         auto GET = [](py::object&&) { return _get_strset(__VA_ARGS__); };                \
         auto SET = [](py::object&&, const py::list& val) {                               \
             _set_strset(val, __VA_ARGS__);                                               \
+            get_config().reset_cache();                                                  \
         };                                                                               \
         CONFIGURATION_PROPERTY_LAMBDA(NAME, DOC, GET, SET)                               \
     }
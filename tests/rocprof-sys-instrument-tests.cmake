@@ -25,6 +25,32 @@ rocprofiler_systems_add_test(
     REWRITE_PASS_REGEX "\\[function\\]\\[Forcing\\] caller-include-regex :: 'outer'"
     REWRITE_RUN_PASS_REGEX ">>> ._outer ([ \\|]+) 17")
 
+# the fixture profile has two threads whose root call-paths take 1 sec each. 'inner' is
+# called from both (0.2 + 0.3 sec = 25% of the total) and 'outer' takes 0.3 sec (15%)
+# but also appears recursively under 'inner', which must not be counted again
+rocprofiler_systems_add_test(
+    SKIP_BASELINE SKIP_SAMPLING SKIP_RUNTIME
+    NAME rewrite-caller-profile-feedback
+    TARGET rewrite-caller
+    LABELS "profile-feedback"
+    REWRITE_ARGS
+        -e
+        -v
+        2
+        --profile-feedback
+        ${CMAKE_CURRENT_LIST_DIR}/profile-feedback-wall-clock.json
+        --profile-feedback-hot
+        0.2
+        --print-instrumented
+        functions
+    RUN_ARGS 17
+    ENVIRONMENT "${_base_environment};ROCPROFSYS_COUT_OUTPUT=ON"
+    REWRITE_PASS_REGEX
+        "\\[function\\]\\[Forcing\\] profile-feedback-hot-25\\.0-percent :: 'inner'"
+    REWRITE_FAIL_REGEX
+        "\\[Forcing\\] profile-feedback-hot-[0-9.]+-percent :: 'outer'|ROCPROFSYS_ABORT_FAIL_REGEX"
+    )
+
 rocprofiler_systems_add_test(
     NAME parallel-overhead
     TARGET parallel-overhead
@@ -42,6 +68,64 @@ rocprofiler_systems_add_test(
     RUN_ARGS 10 ${NUM_THREADS} 1000
     ENVIRONMENT "${_base_environment}")
 
+rocprofiler_systems_add_test(
+    SKIP_BASELINE SKIP_SAMPLING SKIP_RUNTIME
+    NAME parallel-overhead-plan-cache
+    TARGET parallel-overhead
+    LABELS "plan-cache"
+    REWRITE_ARGS
+        -e
+        -v
+        1
+        --min-instructions=8
+        --plan-cache
+        ${PROJECT_BINARY_DIR}/rocprof-sys-tests-output/plan-cache
+    RUN_ARGS 10 4 1000
+    ENVIRONMENT "${_base_environment}"
+    REWRITE_PASS_REGEX
+        "(Saved the instrumentation plan of|Using instrumentation plan) ")
+
+# the plan saved by the first runtime instrumentation is loaded by the second one. The
+# target and its libraries may be loaded at different addresses (ASLR) in each run
+if(NOT ROCPROFSYS_USE_SANITIZER)
+    add_test(
+        NAME parallel-overhead-plan-cache-runtime-instrument
+        COMMAND
+            ${CMAKE_CURRENT_LIST_DIR}/run-rocprof-sys-plan-cache.sh
+            ${PROJECT_BINARY_DIR}/rocprof-sys-tests-output/plan-cache-runtime
+            $<TARGET_FILE:rocprofiler-systems-instrument> -e -v 1 --min-instructions=8
+            -- $<TARGET_FILE:parallel-overhead> 10 4 1000
+        WORKING_DIRECTORY ${PROJECT_BINARY_DIR})
+
+    set(_plan_cache_runtime_environ
+        "${_base_environment}" "ROCPROFSYS_OUTPUT_PATH=rocprof-sys-tests-output"
+        "ROCPROFSYS_OUTPUT_PREFIX=parallel-overhead-plan-cache-runtime-instrument/")
+
+    set_tests_properties(
+        parallel-overhead-plan-cache-runtime-instrument
+        PROPERTIES ENVIRONMENT
+                   "${_plan_cache_runtime_environ}"
+                   TIMEOUT
+                   600
+                   LABELS
+                   "parallel-overhead;runtime-instrument;plan-cache"
+                   PASS_REGULAR_EXPRESSION
+                   "Instrumented function counts match"
+                   FAIL_REGULAR_EXPRESSION
+                   "The instrumented functions differ")
+endif()
+
+rocprofiler_systems_add_test(
+    SKIP_BASELINE SKIP_SAMPLING SKIP_RUNTIME
+    NAME parallel-overhead-loop-counts
+    TARGET parallel-overhead
+    LABELS "loops"
+    REWRITE_ARGS -e -v 2 -l --loop-mode iterations --min-instructions=8
+    RUN_ARGS 10 4 1000
+    ENVIRONMENT "${_base_environment}"
+    REWRITE_FAIL_REGEX "The loop counters cannot be registered"
+    REWRITE_RUN_PASS_REGEX "loop-counts.(txt|json)")
+
 rocprofiler_systems_add_test(
     SKIP_BASELINE SKIP_RUNTIME
     NAME parallel-overhead-locks-perfetto
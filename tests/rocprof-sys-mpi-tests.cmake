@@ -120,3 +120,26 @@ foreach(_EXAMPLE all2all allgather allreduce bcast reduce scatter-gather send-re
         RUN_ARGS 30
         ENVIRONMENT "${_mpip_${_EXAMPLE}_environment}")
 endforeach()
+
+rocprofiler_systems_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_SAMPLING
+    NAME "mpi-send-recv-comm-matrix"
+    TARGET mpi-send-recv
+    MPI ON
+    NUM_PROCS 2
+    LABELS "mpip"
+    REWRITE_ARGS -e -v 2 --label file line --min-instructions 0
+    RUN_ARGS 30
+    ENVIRONMENT "${_mpip_environment};ROCPROFSYS_MPIP_COMM_MATRIX=ON"
+    REWRITE_RUN_PASS_REGEX "comm-matrix(-[0-9]+)?\\.json")
+
+rocprofiler_systems_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_SAMPLING
+    NAME "mpi-send-recv-wait-state"
+    TARGET mpi-late-sender
+    MPI ON
+    NUM_PROCS 2
+    LABELS "mpip"
+    REWRITE_ARGS -e -v 2 --label file line --min-instructions 0
+    ENVIRONMENT "${_mpip_environment};ROCPROFSYS_MPIP_WAIT_STATE=ON"
+    REWRITE_RUN_PASS_REGEX "late-sender (1[5-9][0-9]|[2-9][0-9][0-9])\\.[0-9]+ msec")
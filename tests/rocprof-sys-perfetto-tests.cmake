@@ -0,0 +1,62 @@
+# -------------------------------------------------------------------------------------- #
+#
+# perfetto output tests
+#
+# -------------------------------------------------------------------------------------- #
+
+rocprofiler_systems_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+    NAME perfetto-compression
+    TARGET parallel-overhead
+    RUN_ARGS 30 2 200
+    LABELS "perfetto"
+    ENVIRONMENT "${_perfetto_environment};ROCPROFSYS_PERFETTO_COMPRESSION=deflate"
+    SAMPLING_PASS_REGEX "perfetto trace compressed from")
+
+rocprofiler_systems_add_validation_test(
+    NAME perfetto-compression-sampling
+    PERFETTO_FILE "perfetto-trace.proto"
+    LABELS "perfetto")
+
+# the trace is read into memory (no temporary file) and is written through a single
+# call to the compressor, which must split it into several packet batches
+rocprofiler_systems_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_SAMPLING
+    NAME perfetto-compression-in-memory
+    TARGET parallel-overhead
+    RUN_ARGS 20 2 50
+    REWRITE_ARGS -e -v 2 --min-instructions=0 -R "^fib$"
+    LABELS "perfetto"
+    ENVIRONMENT
+        "${_perfetto_environment};ROCPROFSYS_PERFETTO_COMPRESSION=deflate;ROCPROFSYS_USE_TEMPORARY_FILES=OFF"
+    REWRITE_RUN_PASS_REGEX "packet batches: ([2-9]|[1-9][0-9]+)\\)")
+
+rocprofiler_systems_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+    NAME perfetto-rotation
+    TARGET parallel-overhead
+    RUN_ARGS 30 2 200
+    LABELS "perfetto"
+    ENVIRONMENT
+        "${_perfetto_environment};ROCPROFSYS_PERFETTO_ROTATE_SECONDS=0.25;ROCPROFSYS_PERFETTO_ROTATE_SIZE_MB=1"
+    SAMPLING_PASS_REGEX "perfetto-trace\\.0\\.proto")
+
+rocprofiler_systems_add_validation_test(
+    NAME perfetto-rotation-sampling
+    PERFETTO_FILE "perfetto-trace.0.proto"
+    LABELS "perfetto")
+
+rocprofiler_systems_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+    NAME perfetto-streaming
+    TARGET parallel-overhead
+    RUN_ARGS 30 2 200
+    LABELS "perfetto"
+    ENVIRONMENT
+        "${_perfetto_environment};ROCPROFSYS_VERBOSE=1;ROCPROFSYS_PERFETTO_BUFFER_SIZE_KB=4096;ROCPROFSYS_PERFETTO_FILE_WRITE_PERIOD_MS=100;ROCPROFSYS_PERFETTO_FLUSH_PERIOD_MS=100"
+    SAMPLING_PASS_REGEX "perfetto buffer statistics: ")
+
+rocprofiler_systems_add_validation_test(
+    NAME perfetto-streaming-sampling
+    PERFETTO_FILE "perfetto-trace.proto"
+    LABELS "perfetto")
@@ -32,3 +32,24 @@ rocprofiler_systems_add_test(
     REWRITE_RUN_PASS_REGEX
         "start_thread (.*) 4 (.*) pthread_mutex_lock (.*) 4000 (.*) pthread_mutex_unlock (.*) 4000"
     )
+
+rocprofiler_systems_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+    NAME parallel-overhead-locks-contention
+    TARGET parallel-overhead-locks
+    LABELS "locks"
+    RUN_ARGS 10 4 1000
+    ENVIRONMENT
+        "${_lock_environment};ROCPROFSYS_PROFILE=ON;ROCPROFSYS_TRACE=ON;ROCPROFSYS_VERBOSE=1;ROCPROFSYS_TRACE_THREAD_LOCK_CONTENTION=ON;ROCPROFSYS_TRACE_THREAD_LOCK_WAIT_THRESHOLD=1"
+    SAMPLING_PASS_REGEX
+        "\\[lock-contention\\] [0-9]+ contended acquisitions(.*)lock-contention\\.txt")
+
+rocprofiler_systems_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+    NAME parallel-overhead-locks-holders
+    TARGET parallel-overhead-locks
+    LABELS "locks"
+    RUN_ARGS 10 4 1000
+    ENVIRONMENT
+        "${_lock_environment};ROCPROFSYS_PROFILE=ON;ROCPROFSYS_TRACE=ON;ROCPROFSYS_VERBOSE=1;ROCPROFSYS_TRACE_THREAD_LOCK_CONTENTION=ON;ROCPROFSYS_TRACE_THREAD_LOCK_HOLDERS=ON;ROCPROFSYS_TRACE_THREAD_LOCK_WAIT_THRESHOLD=1"
+    SAMPLING_PASS_REGEX "lock-wait-graph\\.json")
@@ -0,0 +1,35 @@
+# -------------------------------------------------------------------------------------- #
+#
+# sampling tests
+#
+# -------------------------------------------------------------------------------------- #
+
+rocprofiler_systems_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+    NAME sampling-overhead-budget
+    TARGET parallel-overhead
+    RUN_ARGS 30 2 200
+    LABELS "sampling"
+    ENVIRONMENT
+        "${_base_environment};ROCPROFSYS_VERBOSE=1;ROCPROFSYS_SAMPLING_CPUTIME=ON;ROCPROFSYS_SAMPLING_CPUTIME_FREQ=5000;ROCPROFSYS_SAMPLING_OVERHEAD_BUDGET=1"
+    SAMPLING_PASS_REGEX "of its time sampling \\(budget: 1.000%\\)")
+
+rocprofiler_systems_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+    NAME sampling-folded-pprof
+    TARGET parallel-overhead
+    RUN_ARGS 30 2 200
+    LABELS "sampling"
+    ENVIRONMENT
+        "${_base_environment};ROCPROFSYS_SAMPLING_CPUTIME=ON;ROCPROFSYS_SAMPLING_FOLDED_OUTPUT=ON;ROCPROFSYS_SAMPLING_PPROF_OUTPUT=ON"
+    SAMPLING_PASS_REGEX "sampling-cputime-folded\\.txt.*sampling-cputime\\.pb")
+
+rocprofiler_systems_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+    NAME sampling-offcpu
+    TARGET trace-time-window
+    LABELS "sampling"
+    ENVIRONMENT
+        "${_base_environment};ROCPROFSYS_SAMPLING_REALTIME=ON;ROCPROFSYS_SAMPLING_CPUTIME=ON;ROCPROFSYS_SAMPLING_REALTIME_FREQ=100;ROCPROFSYS_SAMPLING_OFFCPU=ON"
+    SAMPLING_PASS_REGEX "sampling-offcpu-folded\\.txt"
+    SAMPLING_FAIL_REGEX "No off-CPU time was attributed")
@@ -29,3 +29,17 @@ rocprofiler_systems_add_test(
     SAMPLING_PASS_REGEX "Pushing custom region :: run.10. x 1000"
     BASELINE_FAIL_REGEX "Pushing custom region"
     REWRITE_FAIL_REGEX "0 instrumented loops in procedure")
+
+rocprofiler_systems_add_test(
+    SKIP_BASELINE SKIP_SAMPLING
+    NAME user-api-enable-guard
+    TARGET user-api
+    LABELS "loops;enable-guard"
+    REWRITE_ARGS -e -v 2 -l --min-instructions=8 -E custom_push_region --enable-guard
+    RUNTIME_ARGS -e -v 1 -l --min-instructions=8 -E custom_push_region --enable-guard
+    RUN_ARGS 10 ${NUM_THREADS} 1000
+    ENVIRONMENT "${_base_environment}"
+    REWRITE_RUN_PASS_REGEX "Pushing custom region :: run.10. x 1000"
+    RUNTIME_PASS_REGEX "Pushing custom region :: run.10. x 1000"
+    REWRITE_FAIL_REGEX "instrumentation will not be guarded"
+    RUNTIME_FAIL_REGEX "instrumentation will not be guarded")
@@ -0,0 +1,71 @@
+#!/bin/bash
+#
+# usage: run-rocprof-sys-plan-cache.sh <plan-cache-dir> <instrument-command...> -- <app...>
+#
+# Runs the runtime instrumentation twice with the same plan cache directory: the first
+# run analyzes the functions and saves the plan, the second run loads the plan. The
+# number of instrumented functions per module must be identical in both runs.
+
+PLAN_CACHE_DIR=${1}
+shift
+
+ROCPROFSYS_COMMAND=""
+
+while [[ $# -gt 0 ]]
+do
+    if [ "${1}" == "--" ]; then
+        shift
+        break
+    else
+        ROCPROFSYS_COMMAND="${ROCPROFSYS_COMMAND}${1} "
+        shift
+    fi
+done
+
+rm -rf ${PLAN_CACHE_DIR}
+
+run-instrument()
+{
+    local _LOG=${1}
+    ${ROCPROFSYS_COMMAND} --plan-cache ${PLAN_CACHE_DIR} -- ${@:2} 2>&1 | tee ${_LOG}
+    return ${PIPESTATUS[0]}
+}
+
+FRESH_LOG=$(mktemp)
+CACHED_LOG=$(mktemp)
+
+cleanup()
+{
+    rm -f ${FRESH_LOG} ${CACHED_LOG}
+}
+
+trap cleanup EXIT
+
+run-instrument ${FRESH_LOG} ${@} || exit 1
+run-instrument ${CACHED_LOG} ${@} || exit 1
+
+if ! grep -q "Saved the instrumentation plan of" ${FRESH_LOG}; then
+    echo "Error! The first run did not save an instrumentation plan"
+    exit 1
+fi
+
+if ! grep -q "Using instrumentation plan" ${CACHED_LOG}; then
+    echo "Error! The second run did not use the saved instrumentation plan"
+    exit 1
+fi
+
+FRESH_COUNTS=$(grep "instrumented funcs in" ${FRESH_LOG} | sort)
+CACHED_COUNTS=$(grep "instrumented funcs in" ${CACHED_LOG} | sort)
+
+if [ -z "${FRESH_COUNTS}" ] || [ "${FRESH_COUNTS}" != "${CACHED_COUNTS}" ]; then
+    echo "Error! The instrumented functions differ between the fresh and cached plan"
+    echo "fresh:"
+    echo "${FRESH_COUNTS}"
+    echo "cached:"
+    echo "${CACHED_COUNTS}"
+    exit 1
+fi
+
+echo ""
+echo "Instrumented function counts match between the fresh and cached plan"
+echo "${CACHED_COUNTS}"
@@ -0,0 +1,123 @@
+// Measures the per-tick cost of the background cpu frequency + memory usage sample
+// as a function of the number of sampled CPUs. The "cpuinfo" column is the previous
+// sample: it parses /proc/cpuinfo through timemory and reads the resident and virtual
+// memory sizes separately. The "sysfs" column uses the readers of the cpu_freq
+// sampler: scaling_cur_freq through pre-opened descriptors and a single read of
+// /proc/self/statm.
+
+#include "core/cpu_freq_files.hpp"
+
+#include <timemory/components/rusage/backends.hpp>
+#include <timemory/utility/procfs/cpuinfo.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <vector>
+
+namespace cpu_freq_files = ::rocprofsys::cpu_freq_files;
+namespace cpuinfo        = ::tim::procfs::cpuinfo;
+
+namespace
+{
+using clock_type = std::chrono::steady_clock;
+
+volatile uint64_t sink = 0;
+
+void
+cpuinfo_tick(size_t _ncpu)
+{
+    auto     _rcache = tim::rusage_cache{ RUSAGE_SELF };
+    auto&&   _freq   = cpuinfo::freq{};
+    uint64_t _total  = 0;
+    for(size_t i = 0; i < _ncpu; ++i)
+        _total += _freq(i);
+
+    sink += _total + tim::get_page_rss() + tim::get_virt_mem() + _rcache.get_peak_rss();
+}
+
+void
+sysfs_tick(const std::vector<int>& _fds, cpu_freq_files::statm_file& _statm)
+{
+    auto     _rcache = tim::rusage_cache{ RUSAGE_SELF };
+    uint64_t _total  = 0;
+    for(auto itr : _fds)
+    {
+        uint64_t _value = 0;
+        if(cpu_freq_files::read_cur_freq(itr, _value)) _total += _value;
+    }
+
+    int64_t _virt = 0;
+    int64_t _rss  = 0;
+    _statm.read(_virt, _rss);
+
+    sink += _total + _virt + _rss + _rcache.get_peak_rss();
+}
+
+template <typename FuncT>
+double
+measure(size_t _niter, FuncT&& _func)
+{
+    auto _beg = clock_type::now();
+    for(size_t i = 0; i < _niter; ++i)
+        _func();
+    auto _end = clock_type::now();
+    return std::chrono::duration<double, std::micro>(_end - _beg).count() / _niter;
+}
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+    size_t _niter = 200;
+    size_t _nmax  = sysconf(_SC_NPROCESSORS_CONF);
+
+    if(argc > 1) _niter = std::max<long>(atol(argv[1]), 1);
+    if(argc > 2) _nmax = std::min<size_t>(atol(argv[2]), _nmax);
+
+    auto _fds = std::vector<int>{};
+    for(size_t i = 0; i < _nmax; ++i)
+    {
+        auto _fd = cpu_freq_files::open_cur_freq(i);
+        if(_fd >= 0) _fds.emplace_back(_fd);
+    }
+
+    auto    _statm = cpu_freq_files::statm_file{};
+    int64_t _virt  = 0;
+    int64_t _rss   = 0;
+    if(!_statm.read(_virt, _rss))
+    {
+        fprintf(stderr, "unable to read /proc/self/statm\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("[cpu-freq-sample] iterations: %zu, cpus: %zu, cpufreq sysfs entries: %zu\n",
+           _niter, _nmax, _fds.size());
+    printf("%8s %18s %18s %10s\n", "ncpu", "cpuinfo (usec)", "sysfs (usec)", "speedup");
+
+    auto _counts = std::vector<size_t>{};
+    for(size_t i = 1; i < _nmax; i *= 2)
+        _counts.emplace_back(i);
+    _counts.emplace_back(_nmax);
+
+    for(auto _ncpu : _counts)
+    {
+        auto _nfds = std::min(_ncpu, _fds.size());
+        auto _sub  = std::vector<int>(_fds.begin(), _fds.begin() + _nfds);
+
+        auto _old = measure(_niter, [_ncpu]() { cpuinfo_tick(_ncpu); });
+        auto _new = measure(_niter, [&_sub, &_statm]() { sysfs_tick(_sub, _statm); });
+
+        printf("%8zu %18.3f %18.3f %9.1fx\n", _ncpu, _old, _new,
+               (_new > 0.0) ? (_old / _new) : 0.0);
+    }
+
+    for(auto itr : _fds)
+        close(itr);
+
+    return EXIT_SUCCESS;
+}
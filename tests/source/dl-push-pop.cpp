@@ -0,0 +1,91 @@
+// Measures the per-call cost of rocprofsys_push_trace/rocprofsys_pop_trace and
+// rocprofsys_push_region/rocprofsys_pop_region through librocprof-sys-dl with the
+// direct-bound entry points (ROCPROFSYS_DL_DIRECT_BIND=ON) and with the indirect path
+// which re-checks the library state and dispatches through ROCPROFSYS_DL_INVOKE on
+// every call (ROCPROFSYS_DL_DIRECT_BIND=OFF). Each mode is measured in a separate child
+// process since the binding is selected when rocprofsys_init is called.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern "C"
+{
+    void rocprofsys_init(const char*, bool, const char*);
+    void rocprofsys_finalize(void);
+    void rocprofsys_push_trace(const char*);
+    void rocprofsys_pop_trace(const char*);
+    int  rocprofsys_push_region(const char*);
+    int  rocprofsys_pop_region(const char*);
+}
+
+namespace
+{
+using clock_type = std::chrono::steady_clock;
+
+template <typename FuncT>
+double
+measure(size_t _niter, FuncT&& _func)
+{
+    for(size_t i = 0; i < _niter / 10; ++i)
+        _func();
+
+    auto _beg = clock_type::now();
+    for(size_t i = 0; i < _niter; ++i)
+        _func();
+    auto _end = clock_type::now();
+    return std::chrono::duration<double, std::nano>(_end - _beg).count() / _niter;
+}
+
+int
+run(const char* _label, const char* _direct_bind, size_t _niter, const char* _argv0)
+{
+    fflush(stdout);
+    auto _pid = fork();
+    if(_pid == 0)
+    {
+        setenv("ROCPROFSYS_DL_DIRECT_BIND", _direct_bind, 1);
+        rocprofsys_init("trace", false, _argv0);
+
+        auto _trace = measure(_niter, []() {
+            rocprofsys_push_trace("dl-push-pop");
+            rocprofsys_pop_trace("dl-push-pop");
+        });
+        auto _region = measure(_niter, []() {
+            rocprofsys_push_region("dl-push-pop");
+            rocprofsys_pop_region("dl-push-pop");
+        });
+
+        printf("%-10s %12zu %22.1f %22.1f\n", _label, _niter, _trace, _region);
+        fflush(stdout);
+
+        rocprofsys_finalize();
+        _exit(EXIT_SUCCESS);
+    }
+
+    int _status = 0;
+    if(_pid < 0 || waitpid(_pid, &_status, 0) != _pid) return EXIT_FAILURE;
+    return (WIFEXITED(_status)) ? WEXITSTATUS(_status) : EXIT_FAILURE;
+}
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+    size_t _niter = 1000000;
+    if(argc > 1) _niter = std::max<long>(atol(argv[1]), 1);
+
+    printf("[dl-push-pop] iterations: %zu\n", _niter);
+    printf("%-10s %12s %22s %22s\n", "binding", "iterations", "push/pop trace (ns)",
+           "push/pop region (ns)");
+
+    int _ret = EXIT_SUCCESS;
+    _ret |= run("indirect", "OFF", _niter, argv[0]);
+    _ret |= run("direct", "ON", _niter, argv[0]);
+
+    return _ret;
+}
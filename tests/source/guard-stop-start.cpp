@@ -0,0 +1,76 @@
+// Calls rocprofsys_user_stop_trace and rocprofsys_user_start_trace from instrumented
+// functions. With --enable-guard, the entry of a function is skipped while the trace is
+// stopped but its exit is not: stop_in_progress is still in progress when the trace is
+// stopped and start_in_progress is in progress when it is started again. The regions
+// are balanced when stop_in_progress and after_start are both children of outer and
+// neither skipped nor start_in_progress is recorded.
+
+#include <rocprofiler-systems/user.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+
+#define NOINLINE __attribute__((noinline))
+
+namespace
+{
+std::atomic<long> total{ 0 };
+}
+
+NOINLINE void
+work(long _n)
+{
+    for(long i = 0; i < _n; ++i)
+        total += i;
+}
+
+NOINLINE void
+stop_in_progress()
+{
+    work(100);
+    rocprofsys_user_stop_trace();
+    work(100);
+}
+
+NOINLINE void
+skipped()
+{
+    work(100);
+}
+
+NOINLINE void
+start_in_progress()
+{
+    work(100);
+    rocprofsys_user_start_trace();
+    work(100);
+}
+
+NOINLINE void
+after_start()
+{
+    work(100);
+}
+
+NOINLINE void
+outer()
+{
+    stop_in_progress();
+    skipped();
+    start_in_progress();
+    after_start();
+}
+
+int
+main(int argc, char** argv)
+{
+    int nrepeat = 2;
+    if(argc > 1) nrepeat = atoi(argv[1]);
+
+    for(int i = 0; i < nrepeat; ++i)
+        outer();
+
+    printf("[%s] total = %li\n", argv[0], total.load());
+    return 0;
+}
@@ -0,0 +1,163 @@
+// Compares the per-sample latency of the frame-pointer unwinder used by
+// ROCPROFSYS_SAMPLING_UNWINDER=frame-pointer against libunwind (or the glibc
+// backtrace() DWARF unwinder when libunwind is not available). Signals are delivered
+// synchronously from a recursive call-stack of a configurable depth and each unwinder
+// is timed inside the signal handler.
+
+#include "core/frame_pointer.hpp"
+
+#if defined(ROCPROFSYS_TEST_LIBUNWIND)
+#    define UNW_LOCAL_ONLY
+#    include <libunwind.h>
+#else
+#    include <execinfo.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <signal.h>
+#include <vector>
+
+namespace frame_pointer = ::rocprofsys::frame_pointer;
+
+namespace
+{
+constexpr size_t max_depth = 128;
+
+frame_pointer::stack_bounds bounds        = {};
+std::vector<uint64_t>       fp_latency    = {};
+std::vector<uint64_t>       unw_latency   = {};
+size_t                      fp_depth      = 0;
+size_t                      unw_depth     = 0;
+size_t                      fp_invalid    = 0;
+volatile int                recurse_guard = 0;
+
+uint64_t
+now()
+{
+    struct timespec _ts;
+    clock_gettime(CLOCK_MONOTONIC, &_ts);
+    return static_cast<uint64_t>(_ts.tv_sec) * 1000000000UL + _ts.tv_nsec;
+}
+
+size_t
+unwind_reference(uintptr_t* _frames, size_t _max)
+{
+#if defined(ROCPROFSYS_TEST_LIBUNWIND)
+    unw_context_t _context;
+    unw_cursor_t  _cursor;
+    unw_getcontext(&_context);
+    if(unw_init_local(&_cursor, &_context) < 0) return 0;
+
+    size_t _n = 0;
+    while(_n < _max && unw_step(&_cursor) > 0)
+    {
+        unw_word_t _ip = 0;
+        unw_get_reg(&_cursor, UNW_REG_IP, &_ip);
+        _frames[_n++] = _ip;
+    }
+    return _n;
+#else
+    return backtrace(reinterpret_cast<void**>(_frames), static_cast<int>(_max));
+#endif
+}
+
+void
+handler(int _signo, siginfo_t*, void*)
+{
+    auto _frames = std::array<uintptr_t, max_depth>{};
+
+    auto _t0 = now();
+    auto _uc = frame_pointer::find_signal_context(
+        __builtin_frame_address(0), frame_pointer::get_signal_restorer(_signo), bounds);
+    auto _nfp = frame_pointer::unwind(_uc, bounds, _frames.data(), _frames.size());
+    auto _t1  = now();
+    auto _nuw = unwind_reference(_frames.data(), _frames.size());
+    auto _t2  = now();
+
+    if(_nfp == 0) ++fp_invalid;
+    fp_latency.emplace_back(_t1 - _t0);
+    unw_latency.emplace_back(_t2 - _t1);
+    fp_depth  = std::max(fp_depth, _nfp);
+    unw_depth = std::max(unw_depth, _nuw);
+}
+
+__attribute__((noinline)) void
+recurse(size_t _depth, size_t _nsamples)
+{
+    if(_depth > 0)
+    {
+        recurse(_depth - 1, _nsamples);
+        ++recurse_guard;
+        return;
+    }
+
+    for(size_t i = 0; i < _nsamples; ++i)
+        raise(SIGPROF);
+}
+
+void
+report(const char* _label, std::vector<uint64_t>& _v, size_t _depth)
+{
+    std::sort(_v.begin(), _v.end());
+    double _sum = 0.0;
+    for(auto itr : _v)
+        _sum += itr;
+    auto _pct = [&_v](double _p) {
+        return _v.at(std::min<size_t>(_v.size() - 1, _p * _v.size()));
+    };
+    printf("%-14s %8zu %12.1f %10lu %10lu %10lu\n", _label, _depth, _sum / _v.size(),
+           static_cast<unsigned long>(_pct(0.5)), static_cast<unsigned long>(_pct(0.99)),
+           static_cast<unsigned long>(_v.back()));
+}
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+    size_t _depth    = 32;
+    size_t _nsamples = 10000;
+
+    if(argc > 1) _depth = atol(argv[1]);
+    if(argc > 2) _nsamples = std::max<long>(atol(argv[2]), 1);
+
+    if(!frame_pointer::is_supported)
+    {
+        printf("[sampling-unwind] frame-pointer unwinding is not supported on this "
+               "architecture\n");
+        return EXIT_SUCCESS;
+    }
+
+    bounds = frame_pointer::get_stack_bounds();
+    fp_latency.reserve(_nsamples);
+    unw_latency.reserve(_nsamples);
+
+    struct sigaction _act = {};
+    _act.sa_sigaction     = &handler;
+    _act.sa_flags         = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&_act.sa_mask);
+    sigaction(SIGPROF, &_act, nullptr);
+
+    recurse(_depth, _nsamples);
+
+#if defined(ROCPROFSYS_TEST_LIBUNWIND)
+    const char* _reference = "libunwind";
+#else
+    const char* _reference = "backtrace()";
+#endif
+
+    printf("[sampling-unwind] call-stack depth: %zu, samples: %zu, invalid frame-pointer "
+           "chains: %zu\n",
+           _depth, _nsamples, fp_invalid);
+    printf("%-14s %8s %12s %10s %10s %10s\n", "unwinder", "frames", "mean (ns)",
+           "p50 (ns)", "p99 (ns)", "max (ns)");
+    report("frame-pointer", fp_latency, fp_depth);
+    report(_reference, unw_latency, unw_depth);
+
+    return (fp_invalid == _nsamples) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,138 @@
+// Measures the resident memory of the per-thread storage of the thread_data instances
+// at startup. The "eager" layout is the container::stable_vector of MAX_THREADS
+// cache-line aligned slots which every instance used to allocate upfront; the "lazy"
+// layout is the container::lazy_vector which only allocates the chunks (of doubling
+// size) which contain the slots of the threads that were seen. The "lazy-read" layout
+// additionally reads every slot up to MAX_THREADS through const access, like the
+// finalization loops do, which must not allocate. Each layout is measured in a
+// separate child process so that memory released by one layout is not re-used by the
+// other.
+
+#include "core/containers/lazy_vector.hpp"
+#include "core/containers/stable_vector.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <sys/wait.h>
+#include <type_traits>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#if !defined(MAX_THREADS)
+#    define MAX_THREADS 2048
+#endif
+
+namespace container = ::rocprofsys::container;
+
+namespace
+{
+constexpr size_t max_threads = MAX_THREADS;
+constexpr size_t chunk_size  = (max_threads < 16) ? max_threads : 16;
+
+using eager_storage =
+    container::stable_vector<void*, max_threads, container::cacheline_align_v>;
+using lazy_storage =
+    container::lazy_vector<void*, chunk_size, container::cacheline_align_v>;
+
+struct lazy_read_storage : lazy_storage
+{};
+
+uint64_t
+read_rss()
+{
+    long long _size = 0;
+    long long _res  = 0;
+    auto*     _fp   = fopen("/proc/self/statm", "r");
+    if(_fp)
+    {
+        if(fscanf(_fp, "%lld %lld", &_size, &_res) != 2) _res = 0;
+        fclose(_fp);
+    }
+    return _res * sysconf(_SC_PAGESIZE);
+}
+
+template <typename Tp>
+std::unique_ptr<Tp>
+make_storage()
+{
+    if constexpr(std::is_same<Tp, eager_storage>::value)
+        return std::make_unique<Tp>(max_threads);
+    else
+        return std::make_unique<Tp>();
+}
+
+template <typename Tp>
+int
+measure(const char* _label, size_t _ninstances, size_t _nthreads)
+{
+    auto _beg  = read_rss();
+    auto _data = std::vector<std::unique_ptr<Tp>>{};
+    for(size_t i = 0; i < _ninstances; ++i)
+    {
+        auto& _v = _data.emplace_back(make_storage<Tp>());
+        for(size_t j = 0; j < _nthreads; ++j)
+            (*_v)[j] = _v.get();
+    }
+
+    int _ret = EXIT_SUCCESS;
+    if constexpr(std::is_same<Tp, lazy_read_storage>::value)
+    {
+        size_t _nvalid = 0;
+        for(auto& itr : _data)
+        {
+            auto _size = itr->size();
+            for(size_t j = 0; j < max_threads; ++j)
+                _nvalid += (std::as_const(*itr)[j] != nullptr) ? 1 : 0;
+            if(itr->size() != _size) _ret = EXIT_FAILURE;
+        }
+        if(_nvalid != _ninstances * _nthreads) _ret = EXIT_FAILURE;
+        if(_ret != EXIT_SUCCESS)
+            fprintf(stderr, "[thread-data-rss] const access allocated storage\n");
+    }
+    auto _end = read_rss();
+
+    printf("%-10s %10zu %10zu %14.3f\n", _label, _ninstances, _nthreads,
+           (_end - _beg) / (1024.0 * 1024.0));
+    fflush(stdout);
+    return _ret;
+}
+
+template <typename Tp>
+int
+measure_in_child(const char* _label, size_t _ninstances, size_t _nthreads)
+{
+    fflush(stdout);
+    auto _pid = fork();
+    if(_pid == 0) _exit(measure<Tp>(_label, _ninstances, _nthreads));
+
+    int _status = 0;
+    if(_pid < 0 || waitpid(_pid, &_status, 0) != _pid) return EXIT_FAILURE;
+    return (WIFEXITED(_status)) ? WEXITSTATUS(_status) : EXIT_FAILURE;
+}
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+    size_t _ninstances = 80;
+    size_t _nthreads   = 8;
+
+    if(argc > 1) _ninstances = std::max<long>(atol(argv[1]), 1);
+    if(argc > 2)
+        _nthreads = std::min<size_t>(std::max<long>(atol(argv[2]), 1), max_threads);
+
+    printf("[thread-data-rss] max threads: %zu, first chunk size: %zu\n", max_threads,
+           chunk_size);
+    printf("%-10s %10s %10s %14s\n", "layout", "instances", "threads", "RSS (MB)");
+
+    int _ret = EXIT_SUCCESS;
+    _ret |= measure_in_child<eager_storage>("eager", _ninstances, _nthreads);
+    _ret |= measure_in_child<lazy_storage>("lazy", _ninstances, _nthreads);
+    _ret |= measure_in_child<lazy_read_storage>("lazy-read", _ninstances, _nthreads);
+
+    return _ret;
+}